@@ -29,6 +29,7 @@
 #else
 #import "ADALTokenCache.h"
 #import "ADALTokenCache+Internal.h"
+#import "ADALFileTokenCache+Internal.h"
 #endif 
 
 #import "ADALAuthenticationContext+Internal.h"
@@ -45,6 +46,7 @@
 #import "MSIDLegacyTokenCacheAccessor.h"
 #import "MSIDDefaultTokenCacheAccessor.h"
 #import "MSIDAADV1Oauth2Factory.h"
+#import "ADALTokenCacheKey.h"
 
 // This variable is purposefully a global so that way we can more easily pull it out of the
 // symbols in a binary to detect what version of ADAL is being used without needing to
@@ -60,6 +62,10 @@ NSString* ADAL_VERSION_VAR = @ADAL_VERSION_STRING;
 #endif
 // iOS keychain group.
 @property (nonatomic) NSString *sharedGroup;
+#if !TARGET_OS_IPHONE
+// ADAL cache over the storage the token cache accessor reads from, used for the cache preload.
+@property (nonatomic) id<ADALTokenCacheDataSource> preloadDataSource;
+#endif
 
 @end
 
@@ -110,6 +116,7 @@ NSString* ADAL_VERSION_VAR = @ADAL_VERSION_STRING;
     
     self.legacyMacCache = [ADALTokenCache new];
     self.legacyMacCache.delegate = delegate;
+    self.preloadDataSource = self.legacyMacCache;
 
     MSIDLegacyTokenCacheAccessor *tokenCache = [self createMacCache:self.legacyMacCache.macTokenCache];
     
@@ -118,6 +125,24 @@ NSString* ADAL_VERSION_VAR = @ADAL_VERSION_STRING;
                         tokenCache:tokenCache
                              error:error];
 }
+
+- (id)initWithAuthority:(NSString *)authority
+      validateAuthority:(BOOL)validateAuthority
+              fileCache:(ADALFileTokenCache *)fileCache
+                  error:(ADALAuthenticationError * __autoreleasing *)error
+{
+    API_ENTRY;
+    
+    RETURN_NIL_ON_NIL_ARGUMENT(fileCache);
+    
+    self.preloadDataSource = fileCache;
+    MSIDLegacyTokenCacheAccessor *tokenCache = [self createMacCache:fileCache.fileDataSource];
+    
+    return [self initWithAuthority:authority
+                 validateAuthority:validateAuthority
+                        tokenCache:tokenCache
+                             error:error];
+}
 #endif
 
 - (id)initWithAuthority:(NSString *)authority
@@ -131,6 +156,7 @@ NSString* ADAL_VERSION_VAR = @ADAL_VERSION_STRING;
     self.sharedGroup = MSIDKeychainTokenCache.defaultKeychainGroup;
 #else
     self.legacyMacCache = [ADALTokenCache defaultCache];
+    self.preloadDataSource = self.legacyMacCache;
     tokenCache = [self createMacCache:self.legacyMacCache.macTokenCache];
 #endif
     
@@ -188,6 +214,10 @@ NSString* ADAL_VERSION_VAR = @ADAL_VERSION_STRING;
                                                                         tokenCache:self.tokenCache
                                                                              error:&error];
     request.sharedGroup = self.sharedGroup;
+#if !TARGET_OS_IPHONE
+    request.tokenCacheWriteBatching = self.legacyMacCache;
+    request.tokenCacheLookupPass = self.legacyMacCache;
+#endif
     
     if (!request)
     {
@@ -543,6 +573,83 @@ NSString* ADAL_VERSION_VAR = @ADAL_VERSION_STRING;
     [request acquireToken:@"138" completionBlock:completionBlock];
 }
 
+#pragma mark - Cache preload
+
+#if !TARGET_OS_IPHONE
+- (NSProgress *)preloadTokenCacheForClientId:(NSString *)clientId
+                             completionBlock:(ADALCachePreloadCompletion)completionBlock
+{
+    API_ENTRY;
+    
+    NSProgress *progress = [NSProgress discreteProgressWithTotalUnitCount:2];
+    
+    ADALAuthenticationError *keyError = nil;
+    ADALTokenCacheKey *mrrtKey = [ADALTokenCacheKey keyWithAuthority:_authority resource:nil clientId:clientId error:&keyError];
+    
+    // Contexts created over a bare cache accessor have nothing to preload
+    if (!mrrtKey || !self.preloadDataSource)
+    {
+        progress.completedUnitCount = progress.totalUnitCount;
+        
+        if (completionBlock)
+        {
+            dispatch_async(dispatch_get_main_queue(), ^{ completionBlock(0, keyError); });
+        }
+        return progress;
+    }
+    
+    // The same cache object silent requests go through, so that its loaded state is what gets warmed
+    id<ADALTokenCacheDataSource> dataSource = self.preloadDataSource;
+    id<ADALTokenCacheLookupPass> lookupPass = self.legacyMacCache;
+    NSString *authority = _authority;
+    
+    // Utility QoS so that the preload doesn't compete with the app's own launch work
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        
+        ADALAuthenticationError *error = nil;
+        NSUInteger itemCount = 0;
+        
+        if (!progress.isCancelled)
+        {
+            [lookupPass beginLookupPass];
+            
+            // The refresh tokens a silent request of the client falls back to: its MRRT and the FRT of its family
+            NSArray<ADALTokenCacheItem *> *mrrtItems = [dataSource getItemsWithKey:mrrtKey userId:nil correlationId:nil error:&error];
+            progress.completedUnitCount = 1;
+            itemCount += mrrtItems.count;
+            
+            NSString *familyId = nil;
+            for (ADALTokenCacheItem *item in mrrtItems)
+            {
+                familyId = familyId ?: item.familyId;
+            }
+            
+            // Use default family ID if the MRRT has none to preserve the previous ADAL functionality
+            NSString *frtClientId = [NSString stringWithFormat:@"%@-%@", ADAL_CLIENT_FAMILY_ID, familyId ?: @"1"];
+            ADALTokenCacheKey *frtKey = [ADALTokenCacheKey keyWithAuthority:authority resource:nil clientId:frtClientId error:nil];
+            
+            if (!error && frtKey)
+            {
+                itemCount += [[dataSource getItemsWithKey:frtKey userId:nil correlationId:nil error:&error] count];
+            }
+            
+            [lookupPass endLookupPass];
+            
+            MSID_LOG_INFO(nil, @"Preloaded token cache, %lu refresh tokens for the client", (unsigned long)itemCount);
+        }
+        
+        progress.completedUnitCount = progress.totalUnitCount;
+        
+        if (completionBlock)
+        {
+            dispatch_async(dispatch_get_main_queue(), ^{ completionBlock(itemCount, error); });
+        }
+    });
+    
+    return progress;
+}
+#endif
+
 #pragma mark - Private
 
 #if TARGET_OS_IPHONE
@@ -23,6 +23,8 @@
 
 #import "ADALAuthenticationSettings.h"
 
+#import "ADALNegativeLookupCache.h"
+
 #if TARGET_OS_IPHONE
 #import "ADALKeychainTokenCache.h"
 #else
@@ -58,6 +60,16 @@
     return self;
 }
 
+- (NSTimeInterval)silentMissTimeToLive
+{
+    return [ADALNegativeLookupCache sharedCache].timeToLive;
+}
+
+- (void)setSilentMissTimeToLive:(NSTimeInterval)silentMissTimeToLive
+{
+    [ADALNegativeLookupCache sharedCache].timeToLive = silentMissTimeToLive;
+}
+
 #if TARGET_OS_IPHONE
 - (BOOL)enableFullScreen
 {
@@ -23,10 +23,25 @@
 
 #import "ADALLogger.h"
 #import "MSIDLogger+Internal.h"
+#import "ADALLogRingBuffer.h"
+#include <stdatomic.h>
+
+// Messages held for asynchronous delivery before the overflow policy kicks in
+#define ADAL_LOG_BUFFER_CAPACITY 4096
+// Messages popped per turn of the drain loop
+#define ADAL_LOG_DRAIN_BATCH_SIZE 64
 
 static LogCallback s_OldCallback = nil;
 static ADLoggerCallback s_LoggerCallback = nil;
 
+static ADALLogRingBuffer *s_logBuffer = nil;
+static dispatch_queue_t s_logQueue = nil;
+static atomic_bool s_asynchronous = false;
+static atomic_bool s_drainScheduled = false;
+static atomic_int s_overflowPolicy = ADAL_LOG_OVERFLOW_DROP_OLDEST;
+// Drops already reported to the callback, only touched while draining
+static NSUInteger s_reportedDropCount = 0;
+
 static NSMutableDictionary* s_adalFullMetadata = nil;
 
 @implementation ADALLogger
@@ -44,26 +59,153 @@ static NSMutableDictionary* s_adalFullMetadata = nil;
     // We want the shared callback to be set as early as possible
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
+        s_logBuffer = [[ADALLogRingBuffer alloc] initWithCapacity:ADAL_LOG_BUFFER_CAPACITY];
+        s_logQueue = dispatch_queue_create("com.microsoft.adal.logger", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        
         [[MSIDLogger sharedLogger] setCallback:^(MSIDLogLevel level, NSString *message, BOOL containsPII) {
             
-            @synchronized (self) //Guard against thread-unsafe callback and modification of sLogCallback after the check
+            if (atomic_load(&s_asynchronous))
             {
-                if (s_LoggerCallback)
-                {
-                    s_LoggerCallback((ADAL_LOG_LEVEL)level, message, containsPII);
-                }
-                else if (s_OldCallback)
-                {
-                    NSString *msg = containsPII ? @"PII message" : message;
-                    NSString *additionalMessage = containsPII ? message : nil;
-                    
-                    s_OldCallback((ADAL_LOG_LEVEL)level, msg, additionalMessage, 0, nil);
-                }
+                [self enqueueLevel:(ADAL_LOG_LEVEL)level message:message containsPii:containsPII];
+                return;
             }
+            
+            [self forwardLevel:(ADAL_LOG_LEVEL)level message:message containsPii:containsPII];
         }];
     });
 }
 
++ (void)forwardLevel:(ADAL_LOG_LEVEL)level message:(NSString *)message containsPii:(BOOL)containsPII
+{
+    @synchronized (self) //Guard against thread-unsafe callback and modification of sLogCallback after the check
+    {
+        if (s_LoggerCallback)
+        {
+            s_LoggerCallback(level, message, containsPII);
+        }
+        else if (s_OldCallback)
+        {
+            NSString *msg = containsPII ? @"PII message" : message;
+            NSString *additionalMessage = containsPII ? message : nil;
+            
+            s_OldCallback(level, msg, additionalMessage, 0, nil);
+        }
+    }
+}
+
+#pragma mark - Asynchronous logging
+
++ (void)enqueueLevel:(ADAL_LOG_LEVEL)level message:(NSString *)message containsPii:(BOOL)containsPII
+{
+    BOOL dropOldest = atomic_load_explicit(&s_overflowPolicy, memory_order_relaxed) == ADAL_LOG_OVERFLOW_DROP_OLDEST;
+    [s_logBuffer pushLevel:level message:message containsPii:containsPII dropOldest:dropOldest];
+    
+    // One drain at a time is enough, it keeps going until the buffer is empty
+    if (!atomic_exchange(&s_drainScheduled, true))
+    {
+        dispatch_async(s_logQueue, ^{
+            [self drain];
+        });
+    }
+}
+
++ (void)drain
+{
+    // Cleared before popping, so a message pushed after the last pop schedules another drain
+    atomic_store(&s_drainScheduled, false);
+    
+    NSMutableArray<NSString *> *messages = [[NSMutableArray alloc] initWithCapacity:ADAL_LOG_DRAIN_BATCH_SIZE];
+    NSInteger levels[ADAL_LOG_DRAIN_BATCH_SIZE];
+    BOOL containsPIIs[ADAL_LOG_DRAIN_BATCH_SIZE];
+    BOOL bufferEmpty = NO;
+    
+    while (!bufferEmpty)
+    {
+        NSString *warning = nil;
+        
+        // Messages are only popped under the buffer lock and forwarded after it is released.
+        // Forwarding takes the callback lock, and a callback may call flush while holding it.
+        @synchronized (s_logBuffer)
+        {
+            NSInteger level = 0;
+            NSString *message = nil;
+            BOOL containsPII = NO;
+            
+            while (messages.count < ADAL_LOG_DRAIN_BATCH_SIZE && [s_logBuffer popLevel:&level message:&message containsPii:&containsPII])
+            {
+                levels[messages.count] = level;
+                containsPIIs[messages.count] = containsPII;
+                [messages addObject:message];
+            }
+            
+            bufferEmpty = messages.count < ADAL_LOG_DRAIN_BATCH_SIZE;
+            
+            NSUInteger droppedCount = s_logBuffer.droppedCount;
+            if (bufferEmpty && droppedCount > s_reportedDropCount)
+            {
+                warning = [NSString stringWithFormat:@"ADAL logger dropped %lu messages, the asynchronous logging buffer was full", (unsigned long)(droppedCount - s_reportedDropCount)];
+                s_reportedDropCount = droppedCount;
+            }
+        }
+        
+        for (NSUInteger i = 0; i < messages.count; i++)
+        {
+            [self forwardLevel:(ADAL_LOG_LEVEL)levels[i] message:messages[i] containsPii:containsPIIs[i]];
+        }
+        [messages removeAllObjects];
+        
+        if (warning && [MSIDLogger sharedLogger].level >= MSIDLogLevelWarning)
+        {
+            [self forwardLevel:ADAL_LOG_LEVEL_WARN message:warning containsPii:NO];
+        }
+    }
+}
+
++ (void)setAsynchronousLogging:(BOOL)asynchronous
+{
+    [self setupLogCallback];
+    
+    BOOL wasAsynchronous = atomic_exchange(&s_asynchronous, asynchronous);
+    if (wasAsynchronous && !asynchronous)
+    {
+        [self drain];
+    }
+}
+
++ (BOOL)getAsynchronousLogging
+{
+    return atomic_load(&s_asynchronous);
+}
+
++ (void)setLogOverflowPolicy:(ADAL_LOG_OVERFLOW_POLICY)policy
+{
+    atomic_store_explicit(&s_overflowPolicy, policy, memory_order_relaxed);
+}
+
++ (ADAL_LOG_OVERFLOW_POLICY)getLogOverflowPolicy
+{
+    return (ADAL_LOG_OVERFLOW_POLICY)atomic_load_explicit(&s_overflowPolicy, memory_order_relaxed);
+}
+
++ (NSUInteger)getDroppedLogCount
+{
+    [self setupLogCallback];
+    
+    return s_logBuffer.droppedCount;
+}
+
++ (void)flush
+{
+    if (!atomic_load(&s_asynchronous))
+    {
+        return;
+    }
+    
+    [self drain];
+}
+
+#pragma mark - Callbacks
+
 + (void)setLogCallBack:(LogCallback)callback
 {
     @synchronized (self)
@@ -46,6 +46,8 @@
 @property (retain, nonatomic) NSString *logComponent;
 @property (retain, nonatomic) MSIDAccountIdentifier *account;
 @property (retain, nonatomic) NSDictionary *appRequestMetadata;
+// Public API that started the request, used to break down latency statistics. May be nil.
+@property (retain, nonatomic) NSString *apiId;
 
 - (NSString *)openIdScopesString;
 - (MSIDConfiguration *)msidConfig;
@@ -83,6 +83,7 @@
     parameters->_account = [_account copyWithZone:zone];
     parameters->_decodedClaims = [_decodedClaims copyWithZone:zone];
     parameters->_clientCapabilities = [_clientCapabilities copyWithZone:zone];
+    parameters->_apiId = [_apiId copyWithZone:zone];
 
     return parameters;
 }
@@ -48,8 +48,37 @@ NSString *const ID_TOKEN_JWT_TYPE = @"JWT";
 NSString *const ID_TOKEN_OBJECT_ID = @"oid";
 NSString *const ID_TOKEN_GUEST_ID = @"altsecid";
 
+// Enough for the users of a typical app, every cached token of a user carries the same id_token
+#define ADAL_PARSED_ID_TOKENS_COUNT_LIMIT 32
+
+// The parts of a successfully parsed id_token that ADALUserInformation keeps
+@interface ADALParsedIdToken : NSObject
+
+@property (nonatomic) NSString *userId;
+@property (nonatomic) BOOL userIdDisplayable;
+@property (nonatomic) NSString *uniqueId;
+@property (nonatomic) NSDictionary *allClaims;
+
+@end
+
+@implementation ADALParsedIdToken
+@end
+
 @implementation ADALUserInformation (Internal)
 
++ (NSCache<NSString *, ADALParsedIdToken *> *)parsedIdTokens
+{
+    static NSCache *s_parsedIdTokens = nil;
+    static dispatch_once_t s_once;
+    
+    dispatch_once(&s_once, ^{
+        s_parsedIdTokens = [NSCache new];
+        s_parsedIdTokens.countLimit = ADAL_PARSED_ID_TOKENS_COUNT_LIMIT;
+    });
+    
+    return s_parsedIdTokens;
+}
+
 + (ADALUserInformation *)userInformationWithIdToken:(NSString *)idToken
                                     homeAccountId:(NSString *)homeAccountId
                                            error:(ADALAuthenticationError * __autoreleasing *)error
@@ -78,6 +107,20 @@ NSString *const ID_TOKEN_GUEST_ID = @"altsecid";
     
     _rawIdToken = idToken;
     _homeAccountId = homeAccountId;
+    
+    // Cache items and results of the same user are built from the same id_token over and over,
+    // it is only decoded the first time.
+    ADALParsedIdToken *parsedIdToken = [ADALUserInformation.parsedIdTokens objectForKey:idToken];
+    
+    if (parsedIdToken)
+    {
+        _userId = parsedIdToken.userId;
+        _userIdDisplayable = parsedIdToken.userIdDisplayable;
+        _uniqueId = parsedIdToken.uniqueId;
+        _allClaims = parsedIdToken.allClaims;
+        
+        return self;
+    }
 
     NSError *idTokenError = nil;
     MSIDIdTokenClaims *idTokenClaims = [MSIDAADIdTokenClaimsFactory claimsFromRawIdToken:_rawIdToken error:&idTokenError];
@@ -113,6 +156,13 @@ NSString *const ID_TOKEN_GUEST_ID = @"altsecid";
         return nil;
     }
     
+    parsedIdToken = [ADALParsedIdToken new];
+    parsedIdToken.userId = _userId;
+    parsedIdToken.userIdDisplayable = _userIdDisplayable;
+    parsedIdToken.uniqueId = _uniqueId;
+    parsedIdToken.allClaims = _allClaims;
+    [ADALUserInformation.parsedIdTokens setObject:parsedIdToken forKey:[idToken copy]];
+    
     return self;
 }
 
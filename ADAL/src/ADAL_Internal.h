@@ -141,10 +141,20 @@ argumentName:@#ARG correlationId:nil]; \
 //Can be used only inside another macro.
 #define TO_NSSTRING(x) @"" x
 
+//Whether a message at LEVEL gets past the logger. Work done only to build a log message should be
+//guarded with it, so the message isn't built when it would be dropped:
+#define ADAL_LOG_ENABLED(LEVEL) ((LEVEL) <= [MSIDLogger sharedLogger].level)
+
+//Same as above for messages with PII, which are dropped unless PII logging is also on:
+#define ADAL_LOG_PII_ENABLED(LEVEL) (ADAL_LOG_ENABLED(LEVEL) && [MSIDLogger sharedLogger].PiiLoggingEnabled)
+
 //Logs public function call:
 #define API_ENTRY \
 { \
+if (ADAL_LOG_ENABLED(MSIDLogLevelVerbose)) \
+{ \
 WHERE; \
 MSID_LOG_VERBOSE(nil, @"ADAL API call [Version - " ADAL_VERSION_STRING "] - %@", __where); \
+} \
 }
 
@@ -26,10 +26,41 @@
 @protocol MSIDTokenCacheDataSource;
 @protocol MSIDCredentialItemSerializer;
 @protocol ADALTokenCacheDataSource;
+@class ADALAuthenticationError;
+
+@protocol ADALTokenCacheWriteBatching;
 
 @interface ADALMSIDDataSourceWrapper : NSObject <ADALTokenCacheDataSource>
 
+/*! Optional, used by performWriteBatch: to persist several writes at once. */
+@property (nonatomic, weak) id<ADALTokenCacheWriteBatching> writeBatching;
+
 - (instancetype)initWithMSIDDataSource:(id<MSIDTokenCacheDataSource>)dataSource
                             serializer:(id<MSIDCredentialItemSerializer>)serializer;
 
+/*!
+ Runs writeBlock as a single write batch. All items written or removed in the block are
+ persisted together. Returns the result of writeBlock.
+ */
+- (BOOL)performWriteBatch:(BOOL (^)(void))writeBlock;
+
+/*!
+ Removes access tokens without a refresh token that are expired beyond their extended lifetime,
+ and orphaned entries that don't hold any token. Items are removed in batches of batchSize.
+ 
+ @param removedCount  (Optional) Number of items removed.
+ @param removedBytes  (Optional) Total size of the removed records as the data source stores them.
+ */
+- (BOOL)removeExpiredItemsWithBatchSize:(NSUInteger)batchSize
+                           removedCount:(NSUInteger *)removedCount
+                           removedBytes:(NSUInteger *)removedBytes
+                                  error:(ADALAuthenticationError **)error;
+
+- (BOOL)removeExpiredItems:(NSUInteger *)removedCount
+              removedBytes:(NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError **)error;
+
+/*! Schedules removeExpiredItems on a background queue every interval seconds. Pass 0 to stop. */
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval;
+
 @end
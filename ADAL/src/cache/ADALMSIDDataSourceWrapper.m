@@ -38,12 +38,19 @@
 #import "MSIDDefaultTokenCacheAccessor.h"
 #import "MSIDAADV1Oauth2Factory.h"
 #import "MSIDAccountIdentifier.h"
+#import "ADALTokenCacheItem+Internal.h"
+#import "ADALNegativeLookupCache.h"
+#import "ADALCacheStatistics.h"
+#import "ADALHistogram.h"
+
+#define ADAL_EXPIRED_ITEMS_SWEEP_BATCH_SIZE 50
 
 @interface ADALMSIDDataSourceWrapper()
 
 @property (nonatomic) id<MSIDTokenCacheDataSource> dataSource;
 @property (nonatomic) id<MSIDCredentialItemSerializer> seriazer;
 @property (nonatomic) MSIDLegacyTokenCacheAccessor *legacyAccessor;
+@property (nonatomic) dispatch_source_t sweepTimer;
 
 @end
 
@@ -73,6 +80,14 @@
     return self;
 }
 
+- (void)dealloc
+{
+    if (_sweepTimer)
+    {
+        dispatch_source_cancel(_sweepTimer);
+    }
+}
+
 #pragma mark - Accessors
 
 /*! Clears token cache details for specific keys.
@@ -83,6 +98,8 @@
 {
     NSError *cacheError = nil;
     
+    [ADALCacheStatistics increment:ADALCacheCounterRemoval];
+    
     BOOL result = [self.dataSource removeItemsWithKey:[item tokenCacheKey] context:nil error:&cacheError];
     
     if (cacheError && error)
@@ -97,16 +114,45 @@
  containing all of the cached information. Returns an empty array, if no items are found.
  Returns nil in case of error. */
 - (NSArray<ADALTokenCacheItem *> *)allItems:(ADALAuthenticationError * __autoreleasing *)error
+{
+    NSArray<MSIDLegacyTokenCacheItem *> *allItems = [self allCacheItems:error];
+    
+    if (!allItems)
+    {
+        return nil;
+    }
+    
+    NSMutableArray<ADALTokenCacheItem *> *results = [NSMutableArray array];
+    
+    for (MSIDLegacyTokenCacheItem *cacheItem in allItems)
+    {
+        ADALTokenCacheItem *item = [[ADALTokenCacheItem alloc] initWithMSIDLegacyTokenCacheItem:cacheItem];
+        
+        if (item)
+        {
+            [results addObject:item];
+        }
+    }
+    
+    return results;
+}
+
+/*! All items as the data source stores them. Returns nil in case of error. */
+- (NSArray<MSIDLegacyTokenCacheItem *> *)allCacheItems:(ADALAuthenticationError * __autoreleasing *)error
 {
     MSIDLegacyTokenCacheQuery *query = [MSIDLegacyTokenCacheQuery new];
     
     NSError *cacheError = nil;
     
+    uint64_t start = [ADALHistogram now];
+    
     NSArray *allItems = [self.dataSource tokensWithKey:query
                                             serializer:self.seriazer
                                                context:nil
                                                  error:&cacheError];
     
+    [ADALCacheStatistics recordSince:start inHistogram:ADALCacheHistogramRead];
+    
     if (cacheError)
     {
         if (error) *error = [ADALAuthenticationErrorConverter ADALAuthenticationErrorFromMSIDError:cacheError];
@@ -118,19 +164,9 @@
         return nil;
     }
     
-    NSMutableArray<ADALTokenCacheItem *> *results = [NSMutableArray array];
-    
-    for (MSIDLegacyTokenCacheItem *cacheItem in allItems)
-    {
-        ADALTokenCacheItem *item = [[ADALTokenCacheItem alloc] initWithMSIDLegacyTokenCacheItem:cacheItem];
-        
-        if (item)
-        {
-            [results addObject:item];
-        }
-    }
+    [ADALCacheStatistics set:allItems.count forGauge:ADALCacheGaugeItemCount];
     
-    return results;
+    return allItems;
 }
 
 - (BOOL)addOrUpdateItem:(ADALTokenCacheItem *)item
@@ -144,6 +180,8 @@
     
     ADALMSIDContext *context = [[ADALMSIDContext alloc] initWithCorrelationId:correlationId];
     
+    [ADALCacheStatistics increment:ADALCacheCounterWrite];
+    
     BOOL result = [self.dataSource saveToken:tokenCacheItem
                                          key:key
                                   serializer:self.seriazer
@@ -156,6 +194,8 @@
         return NO;
     }
     
+    [[ADALNegativeLookupCache sharedCache] invalidateAll];
+    
     return result;
 }
 
@@ -180,11 +220,17 @@
     
     ADALMSIDContext *context = [[ADALMSIDContext alloc] initWithCorrelationId:correlationId];
     
+    uint64_t start = [ADALHistogram now];
+    
     MSIDCredentialCacheItem *cacheItem = [self.dataSource tokenWithKey:msidKey
                                                             serializer:self.seriazer
                                                                context:context
                                                                  error:&cacheError];
     
+    [ADALCacheStatistics recordSince:start inHistogram:ADALCacheHistogramRead];
+    [ADALCacheStatistics increment:ADALCacheCounterRead];
+    [ADALCacheStatistics increment:cacheItem ? ADALCacheCounterReadHit : ADALCacheCounterReadMiss];
+    
     if (cacheError)
     {
         if (error) *error = [ADALAuthenticationErrorConverter ADALAuthenticationErrorFromMSIDError:cacheError];
@@ -209,11 +255,18 @@
     
     ADALMSIDContext *context = [[ADALMSIDContext alloc] initWithCorrelationId:correlationId];
     
+    uint64_t start = [ADALHistogram now];
+    
     NSArray *cacheItems = [self.dataSource tokensWithKey:query
                                               serializer:self.seriazer
                                                  context:context
                                                 error:&cacheError];
     
+    [ADALCacheStatistics recordSince:start inHistogram:ADALCacheHistogramRead];
+    [ADALCacheStatistics increment:ADALCacheCounterRead];
+    [ADALCacheStatistics increment:cacheItems.count ? ADALCacheCounterReadHit : ADALCacheCounterReadMiss];
+    [ADALCacheStatistics add:cacheItems.count toCounter:ADALCacheCounterItemsRead];
+    
     if (cacheError)
     {
         if (error) *error = [ADALAuthenticationErrorConverter ADALAuthenticationErrorFromMSIDError:cacheError];
@@ -289,4 +342,178 @@
     return [self.dataSource wipeInfo:nil error:nil];
 }
 
+#pragma mark - Write batches
+
+- (BOOL)performWriteBatch:(BOOL (^)(void))writeBlock
+{
+    id<ADALTokenCacheWriteBatching> writeBatching = self.writeBatching;
+    
+    [writeBatching beginWriteBatch];
+    BOOL result = writeBlock();
+    [writeBatching commitWriteBatch];
+    
+    return result;
+}
+
+#pragma mark - Expired items sweep
+
+- (BOOL)removeExpiredItemsWithBatchSize:(NSUInteger)batchSize
+                           removedCount:(NSUInteger *)removedCount
+                           removedBytes:(NSUInteger *)removedBytes
+                                  error:(ADALAuthenticationError **)error
+{
+    if (removedCount) *removedCount = 0;
+    if (removedBytes) *removedBytes = 0;
+    
+    NSArray<MSIDLegacyTokenCacheItem *> *allCacheItems = [self allCacheItems:error];
+    
+    if (!allCacheItems)
+    {
+        return NO;
+    }
+    
+    NSMutableArray<ADALTokenCacheItem *> *staleItems = [NSMutableArray array];
+    NSMutableArray<MSIDLegacyTokenCacheItem *> *staleCacheItems = [NSMutableArray array];
+    
+    for (MSIDLegacyTokenCacheItem *cacheItem in allCacheItems)
+    {
+        ADALTokenCacheItem *item = [[ADALTokenCacheItem alloc] initWithMSIDLegacyTokenCacheItem:cacheItem];
+        
+        if (item && [self isStaleItem:item])
+        {
+            [staleItems addObject:item];
+            [staleCacheItems addObject:cacheItem];
+        }
+    }
+    
+    if (!staleItems.count)
+    {
+        return YES;
+    }
+    
+    batchSize = MAX(batchSize, 1);
+    
+    __block NSUInteger itemCount = 0;
+    __block NSUInteger byteCount = 0;
+    BOOL result = YES;
+    
+    for (NSUInteger batchStart = 0; batchStart < staleItems.count && result; batchStart += batchSize)
+    {
+        @autoreleasepool
+        {
+            NSUInteger batchEnd = MIN(batchStart + batchSize, staleItems.count);
+            __block ADALAuthenticationError *batchError = nil;
+            
+            result = [self performWriteBatch:^BOOL{
+                
+                for (NSUInteger i = batchStart; i < batchEnd; i++)
+                {
+                    // The data source keeps each record as the serializer's output for the item it read
+                    NSUInteger recordSize = removedBytes ? [self.seriazer serializeCredentialCacheItem:staleCacheItems[i]].length : 0;
+                    
+                    if (![self removeItem:staleItems[i] error:&batchError])
+                    {
+                        return NO;
+                    }
+                    
+                    itemCount++;
+                    byteCount += recordSize;
+                }
+                
+                return YES;
+            }];
+            
+            if (!result && error)
+            {
+                *error = batchError;
+            }
+        }
+    }
+    
+    MSID_LOG_INFO(nil, @"Removed %lu expired cache items", (unsigned long)itemCount);
+    
+    if (removedCount) *removedCount = itemCount;
+    if (removedBytes) *removedBytes = byteCount;
+    
+    return result;
+}
+
+- (BOOL)isStaleItem:(ADALTokenCacheItem *)item
+{
+    BOOL hasAccessToken = ![NSString msidIsStringNilOrBlank:item.accessToken];
+    BOOL hasRefreshToken = ![NSString msidIsStringNilOrBlank:item.refreshToken];
+    
+    // Orphaned entry, nothing in it can be used for a token request
+    if (!hasAccessToken && !hasRefreshToken)
+    {
+        return YES;
+    }
+    
+    // Refresh tokens have no client side expiration, they're kept until the server rejects them
+    if (hasRefreshToken || !item.expiresOn)
+    {
+        return NO;
+    }
+    
+    NSDate *now = [NSDate date];
+    
+    if ([item.expiresOn compare:now] != NSOrderedAscending)
+    {
+        return NO;
+    }
+    
+    id extendedExpiresOn = item.additionalServer[MSID_EXTENDED_EXPIRES_ON_CACHE_KEY];
+    
+    if ([extendedExpiresOn isKindOfClass:[NSDate class]])
+    {
+        return [(NSDate *)extendedExpiresOn compare:now] == NSOrderedAscending;
+    }
+    
+    return YES;
+}
+
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval
+{
+    @synchronized (self)
+    {
+        if (_sweepTimer)
+        {
+            dispatch_source_cancel(_sweepTimer);
+            _sweepTimer = nil;
+        }
+        
+        if (interval <= 0)
+        {
+            return;
+        }
+        
+        uint64_t intervalInNanoseconds = (uint64_t)(interval * NSEC_PER_SEC);
+        
+        _sweepTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+        dispatch_source_set_timer(_sweepTimer,
+                                  dispatch_time(DISPATCH_TIME_NOW, (int64_t)intervalInNanoseconds),
+                                  intervalInNanoseconds,
+                                  intervalInNanoseconds / 10);
+        
+        __weak typeof(self) weakSelf = self;
+        dispatch_source_set_event_handler(_sweepTimer, ^{
+            [weakSelf removeExpiredItemsWithBatchSize:ADAL_EXPIRED_ITEMS_SWEEP_BATCH_SIZE
+                                         removedCount:nil
+                                         removedBytes:nil
+                                                error:nil];
+        });
+        dispatch_resume(_sweepTimer);
+    }
+}
+
+- (BOOL)removeExpiredItems:(NSUInteger *)removedCount
+              removedBytes:(NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError **)error
+{
+    return [self removeExpiredItemsWithBatchSize:ADAL_EXPIRED_ITEMS_SWEEP_BATCH_SIZE
+                                    removedCount:removedCount
+                                    removedBytes:removedBytes
+                                           error:error];
+}
+
 @end
@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class ADALRequestParameters;
+
+/*!
+ Remembers for a short time the silent lookups that found nothing usable in the cache, so that
+ apps polling for a user or resource without tokens don't scan the cache on every call.
+ Misses are kept per token cache. Any token write drops all of them: the written tokens may be
+ stored under another user identifier than the one requested, and family refresh tokens serve
+ other client ids, so the lookups a write affects can't be told from the written item.
+ */
+@interface ADALNegativeLookupCache : NSObject
+
++ (ADALNegativeLookupCache *)sharedCache;
+
+/*! How long a miss is remembered. Defaults to 0, which disables the cache. Set through
+    ADALAuthenticationSettings silentMissTimeToLive. */
+@property (atomic) NSTimeInterval timeToLive;
+
+- (BOOL)containsMissForParams:(ADALRequestParameters *)requestParams
+                   tokenCache:(id)tokenCache;
+
+/*! Advances on every invalidateAll. Read it before the cache lookup and pass it to
+    addMissForParams:, so a miss found before a concurrent write isn't remembered after it. */
+@property (readonly) uint64_t writeGeneration;
+
+/*! Remembers the miss unless invalidateAll was called since writeGeneration was read. */
+- (void)addMissForParams:(ADALRequestParameters *)requestParams
+              tokenCache:(id)tokenCache
+         writeGeneration:(uint64_t)writeGeneration;
+
+- (void)invalidateAll;
+
+@end
@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALNegativeLookupCache.h"
+#import "ADALRequestParameters.h"
+#import "MSIDAccountIdentifier.h"
+
+#define NEGATIVE_LOOKUP_MAX_ENTRIES 256
+
+@interface ADALNegativeLookupEntry : NSObject
+
+@property (nonatomic) NSDate *expiresOn;
+
+@end
+
+@implementation ADALNegativeLookupEntry
+
+@end
+
+@implementation ADALNegativeLookupCache
+{
+    // Token cache -> (lookup key -> entry), token caches are held weakly
+    NSMapTable<id, NSMutableDictionary<NSString *, ADALNegativeLookupEntry *> *> *_misses;
+    uint64_t _writeGeneration;
+}
+
++ (ADALNegativeLookupCache *)sharedCache
+{
+    static dispatch_once_t once;
+    static ADALNegativeLookupCache *cache = nil;
+    
+    dispatch_once(&once, ^{
+        cache = [ADALNegativeLookupCache new];
+    });
+    
+    return cache;
+}
+
+- (id)init
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _misses = [NSMapTable weakToStrongObjectsMapTable];
+    
+    return self;
+}
+
++ (NSString *)keyForParams:(ADALRequestParameters *)requestParams
+{
+    return [NSString stringWithFormat:@"%@\x1f%@\x1f%@\x1f%@",
+            requestParams.authority.lowercaseString,
+            requestParams.clientId.lowercaseString,
+            requestParams.resource,
+            requestParams.account.legacyAccountId.lowercaseString ?: @""];
+}
+
+- (BOOL)containsMissForParams:(ADALRequestParameters *)requestParams
+                   tokenCache:(id)tokenCache
+{
+    if (!tokenCache || self.timeToLive <= 0)
+    {
+        return NO;
+    }
+    
+    NSString *key = [ADALNegativeLookupCache keyForParams:requestParams];
+    
+    @synchronized (self)
+    {
+        NSMutableDictionary *misses = [_misses objectForKey:tokenCache];
+        ADALNegativeLookupEntry *entry = misses[key];
+        
+        if (!entry)
+        {
+            return NO;
+        }
+        
+        if ([entry.expiresOn timeIntervalSinceNow] <= 0)
+        {
+            [misses removeObjectForKey:key];
+            return NO;
+        }
+        
+        return YES;
+    }
+}
+
+- (uint64_t)writeGeneration
+{
+    @synchronized (self)
+    {
+        return _writeGeneration;
+    }
+}
+
+- (void)addMissForParams:(ADALRequestParameters *)requestParams
+              tokenCache:(id)tokenCache
+         writeGeneration:(uint64_t)writeGeneration
+{
+    NSTimeInterval timeToLive = self.timeToLive;
+    
+    if (!tokenCache || timeToLive <= 0)
+    {
+        return;
+    }
+    
+    ADALNegativeLookupEntry *entry = [ADALNegativeLookupEntry new];
+    entry.expiresOn = [NSDate dateWithTimeIntervalSinceNow:timeToLive];
+    
+    NSString *key = [ADALNegativeLookupCache keyForParams:requestParams];
+    
+    @synchronized (self)
+    {
+        // A token was written after the lookup started, the miss may already be stale
+        if (writeGeneration != _writeGeneration)
+        {
+            return;
+        }
+        
+        NSMutableDictionary *misses = [_misses objectForKey:tokenCache];
+        
+        if (!misses)
+        {
+            misses = [NSMutableDictionary new];
+            [_misses setObject:misses forKey:tokenCache];
+        }
+        
+        // Misses are cheap to recompute, start over rather than tracking the oldest ones
+        if (misses.count >= NEGATIVE_LOOKUP_MAX_ENTRIES)
+        {
+            [misses removeAllObjects];
+        }
+        
+        misses[key] = entry;
+    }
+}
+
+- (void)invalidateAll
+{
+    @synchronized (self)
+    {
+        _writeGeneration++;
+        [_misses removeAllObjects];
+    }
+}
+
+@end
@@ -22,6 +22,7 @@
 // THE SOFTWARE.
 
 #import <Foundation/Foundation.h>
+#import "ADALTokenCacheDataSource.h"
 
 @class MSIDTokenResponse;
 @class MSIDLegacyTokenCacheAccessor;
@@ -34,6 +35,7 @@
 + (ADALAuthenticationResult *)processAndCacheResponse:(MSIDTokenResponse *)response
                                    fromRefreshToken:(MSIDBaseToken<MSIDRefreshableToken> *)refreshToken
                                               cache:(MSIDLegacyTokenCacheAccessor *)cache
+                                      writeBatching:(id<ADALTokenCacheWriteBatching>)writeBatching
                                              params:(ADALRequestParameters *)requestParams
                                       configuration:(MSIDConfiguration *)configuration
                                        verifyUserId:(BOOL)verifyUserId;
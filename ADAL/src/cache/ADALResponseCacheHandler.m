@@ -32,12 +32,15 @@
 #import "MSIDTokenResponse.h"
 #import "MSIDAccountIdentifier.h"
 #import "ADALAuthenticationErrorConverter.h"
+#import "ADALRequestParameters.h"
+#import "ADALNegativeLookupCache.h"
 
 @implementation ADALResponseCacheHandler
 
 + (ADALAuthenticationResult *)processAndCacheResponse:(MSIDTokenResponse *)response
                                    fromRefreshToken:(MSIDBaseToken<MSIDRefreshableToken> *)refreshToken
                                               cache:(MSIDLegacyTokenCacheAccessor *)cache
+                                      writeBatching:(id<ADALTokenCacheWriteBatching>)writeBatching
                                              params:(ADALRequestParameters *)requestParams
                                       configuration:(MSIDConfiguration *)configuration
                                        verifyUserId:(BOOL)verifyUserId
@@ -60,11 +63,17 @@
                           params:requestParams];
     }
     
+    // AT, RT and account are saved as separate items, commit them together so that
+    // the delegate persists them with a single write
+    [writeBatching beginWriteBatch];
+    
     result = [cache saveTokensWithConfiguration:configuration
                                        response:response
                                         context:requestParams
                                           error:&msidError];
     
+    [writeBatching commitWriteBatch];
+    
     if (!result)
     {
         MSID_LOG_ERROR(nil, @"Failed to save tokens in cache, error code %ld, error domain %@, description %@", (long)msidError.code, msidError.domain, msidError.description);
@@ -75,6 +84,9 @@
         
     ADALTokenCacheItem *adTokenCacheItem = [[ADALTokenCacheItem alloc] initWithLegacySingleResourceToken:resultToken];
     
+    // Any request that missed the cache may find these tokens now
+    [[ADALNegativeLookupCache sharedCache] invalidateAll];
+    
     ADALAuthenticationResult *adResult = [ADALAuthenticationResult resultFromTokenCacheItem:adTokenCacheItem
                                                               multiResourceRefreshToken:response.isMultiResource
                                                                           correlationId:requestParams.correlationId];
@@ -25,7 +25,7 @@
 #import "MSIDMacTokenCache.h"
 #import "ADALTokenCacheDataSource.h"
 
-@interface ADALTokenCache (Internal) <MSIDMacTokenCacheDelegate, ADALTokenCacheDataSource>
+@interface ADALTokenCache (Internal) <MSIDMacTokenCacheDelegate, ADALTokenCacheDataSource, ADALTokenCacheWriteBatching, ADALTokenCacheLookupPass>
 
 @property (nonatomic, nullable, readonly) MSIDMacTokenCache *macTokenCache;
 
@@ -50,15 +50,116 @@
 #import "MSIDLegacyTokenCacheKey.h"
 #import "ADALHelpers.h"
 #import "ADAL_Internal.h"
+#import "ADALNegativeLookupCache.h"
+#import "ADALCacheStatistics.h"
+#import "ADALHistogram.h"
 
 #include <pthread.h>
+#include <stdatomic.h>
+
+// Encoded cache contents, valid as long as the cache hasn't changed since contentsGeneration
+@interface ADALTokenCacheSnapshot : NSObject
+
+@property (nonatomic, readonly) NSData *data;
+@property (nonatomic, readonly) uint64_t contentsGeneration;
+
+@end
+
+@implementation ADALTokenCacheSnapshot
+
+- (instancetype)initWithData:(NSData *)data contentsGeneration:(uint64_t)contentsGeneration
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _data = data;
+    _contentsGeneration = contentsGeneration;
+    
+    return self;
+}
+
+@end
+
+// Whether willAccessCache was forwarded to the delegate for one access,
+// didAccessCache of the same access is forwarded only if it was
+@interface ADALTokenCacheAccess : NSObject
+
+@property (nonatomic) BOOL forwarded;
+// Delegate generation taken before the load, the cache is marked as loaded with it
+@property (nonatomic) uint64_t generation;
+
+@end
+
+@implementation ADALTokenCacheAccess
+@end
+
+// Delegate notifications the current thread has opened on the cache and not closed yet
+@interface ADALTokenCacheThreadState : NSObject
+
+@property (nonatomic, readonly) NSMutableArray<ADALTokenCacheAccess *> *accesses;
+@property (nonatomic) NSUInteger writeDepth;
+@property (nonatomic) NSUInteger writeBatchDepth;
+@property (nonatomic) BOOL writeBatchHasWrites;
+
+@property (nonatomic) NSUInteger lookupPassDepth;
+@property (nonatomic) BOOL lookupPassLoaded;
+@property (nonatomic) BOOL lookupPassAccessOpen;
+@property (nonatomic) uint64_t lookupPassGeneration;
+
+@end
+
+@implementation ADALTokenCacheThreadState
+
+- (instancetype)init
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _accesses = [NSMutableArray new];
+    
+    return self;
+}
+
+- (BOOL)isIdle
+{
+    return !self.accesses.count && !self.writeDepth && !self.writeBatchDepth && !self.lookupPassDepth;
+}
+
+@end
 
 @interface ADALTokenCache()
+{
+    // Incremented before and after every change of the in-memory cache
+    atomic_ullong _contentsGeneration;
+    
+    // Guards the two fields below, signalled whenever either of them changes
+    pthread_mutex_t _threadsMutex;
+    pthread_cond_t _threadsCondition;
+    // Threads with a thread state, except the one with an open write batch
+    NSUInteger _threadsInCache;
+    BOOL _writeBatchOpen;
+}
 
 @property (nonatomic, nullable) MSIDMacTokenCache *macTokenCache;
 @property (nonatomic, nullable) ADALMSIDDataSourceWrapper *msidDataSourceWrapper;
 @property (nonatomic) dispatch_queue_t synchronizationQueue;
 
+// Key of this cache's ADALTokenCacheThreadState in the thread dictionary
+@property (nonatomic) NSString *threadStateKey;
+
+@property (atomic) BOOL readLeaseEnabled;
+@property (atomic) BOOL readLeaseHeld;
+
+@property (atomic) BOOL delegateProvidesGeneration;
+@property (atomic) BOOL hasLoadedGeneration;
+@property (atomic) uint64_t loadedGeneration;
+
+@property (atomic) ADALTokenCacheSnapshot *snapshot;
+
 @end
 
 @implementation ADALTokenCache
@@ -86,13 +187,25 @@
     self.macTokenCache.delegate = self;
     self.msidDataSourceWrapper = [[ADALMSIDDataSourceWrapper alloc] initWithMSIDDataSource:self.macTokenCache
                                                                               serializer:[MSIDKeyedArchiverSerializer new]];
+    self.msidDataSourceWrapper.writeBatching = self;
     
-    NSString *queueName = [NSString stringWithFormat:@"com.microsoft.msidmactokencache-%@", [NSUUID UUID].UUIDString];
+    NSString *uuid = [NSUUID UUID].UUIDString;
+    self.threadStateKey = [NSString stringWithFormat:@"com.microsoft.adaltokencache.threadstate-%@", uuid];
+    NSString *queueName = [NSString stringWithFormat:@"com.microsoft.msidmactokencache-%@", uuid];
     self.synchronizationQueue = dispatch_queue_create([queueName cStringUsingEncoding:NSASCIIStringEncoding], DISPATCH_QUEUE_CONCURRENT);
     
+    pthread_mutex_init(&_threadsMutex, NULL);
+    pthread_cond_init(&_threadsCondition, NULL);
+    
     return self;
 }
 
+- (void)dealloc
+{
+    pthread_cond_destroy(&_threadsCondition);
+    pthread_mutex_destroy(&_threadsMutex);
+}
+
 - (void)setDelegate:(nullable id<ADALTokenCacheDelegate>)delegate
 {
     dispatch_barrier_sync(self.synchronizationQueue, ^{
@@ -103,7 +216,10 @@
         }
         
         _delegate = delegate;
-        [self.macTokenCache clear];
+        self.delegateProvidesGeneration = [delegate respondsToSelector:@selector(generationOfCache:)];
+        self.readLeaseHeld = NO;
+        self.hasLoadedGeneration = NO;
+        [self clearMacTokenCache];
         
     });
     
@@ -114,15 +230,48 @@
             return;
         }
         
+        uint64_t generation = [self currentGeneration];
         [_delegate willAccessCache:self];
         [_delegate didAccessCache:self];
+        [self markLoadedWithGeneration:generation];
         
     });
 }
 
+- (void)clearMacTokenCache
+{
+    atomic_fetch_add(&_contentsGeneration, 1);
+    [self.macTokenCache clear];
+    atomic_fetch_add(&_contentsGeneration, 1);
+}
+
+- (void)invalidateReadLease
+{
+    self.readLeaseHeld = NO;
+    self.hasLoadedGeneration = NO;
+}
+
 - (nullable NSData *)serialize
 {
-    return [self.macTokenCache serialize];
+    // Delegates usually serialize right after deserializing or writing, as long as nothing changed
+    // the last encoded contents are returned without going through the live cache again.
+    uint64_t contentsGeneration = atomic_load(&_contentsGeneration);
+    ADALTokenCacheSnapshot *snapshot = self.snapshot;
+    
+    if (snapshot && snapshot.contentsGeneration == contentsGeneration)
+    {
+        return snapshot.data;
+    }
+    
+    uint64_t start = [ADALHistogram now];
+    NSData *data = [self.macTokenCache serialize];
+    [ADALCacheStatistics recordSince:start inHistogram:ADALCacheHistogramSerialize];
+    [ADALCacheStatistics set:data.length forGauge:ADALCacheGaugeSerializedBytes];
+    
+    // Tagged with the generation from before encoding, so a change made meanwhile leaves it stale
+    self.snapshot = [[ADALTokenCacheSnapshot alloc] initWithData:data contentsGeneration:contentsGeneration];
+    
+    return data;
 }
 
 - (BOOL)deserialize:(nullable NSData*)data
@@ -130,13 +279,25 @@
 {
     if (!data)
     {
-        [self.macTokenCache clear];
+        [self clearMacTokenCache];
         return YES;
     }
 
     NSError *cacheError = nil;
     
+    // Contents stored by someone else may hold tokens for lookups that missed before
+    if (![self.snapshot.data isEqualToData:data])
+    {
+        [[ADALNegativeLookupCache sharedCache] invalidateAll];
+    }
+    
+    uint64_t start = [ADALHistogram now];
+    
+    atomic_fetch_add(&_contentsGeneration, 1);
     BOOL result = [self.macTokenCache deserialize:data error:&cacheError];
+    atomic_fetch_add(&_contentsGeneration, 1);
+    
+    [ADALCacheStatistics recordSince:start inHistogram:ADALCacheHistogramDeserialize];
     
     if (cacheError && error)
     {
@@ -196,34 +357,301 @@
     return [self.msidDataSourceWrapper wipeAllItemsForUserId:userId error:error];
 }
 
+- (BOOL)removeExpiredItems:(NSUInteger *)removedCount
+              removedBytes:(NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError **)error
+{
+    if (!removedBytes)
+    {
+        return [self.msidDataSourceWrapper removeExpiredItems:removedCount removedBytes:nil error:error];
+    }
+    
+    // The whole cache is persisted as one blob, what the sweep reclaims is how much smaller it got
+    NSUInteger sizeBefore = [self serialize].length;
+    BOOL result = [self.msidDataSourceWrapper removeExpiredItems:removedCount removedBytes:nil error:error];
+    NSUInteger sizeAfter = [self serialize].length;
+    
+    *removedBytes = sizeBefore > sizeAfter ? sizeBefore - sizeAfter : 0;
+    
+    return result;
+}
+
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval
+{
+    [self.msidDataSourceWrapper setExpiredItemsSweepInterval:interval];
+}
+
 #pragma mark - MSIDMacTokenCacheDelegate
 
 - (void)willAccessCache:(nonnull MSIDMacTokenCache *)cache
 {
-    dispatch_sync(self.synchronizationQueue, ^{
-        [_delegate willAccessCache:self];
-    });
+    ADALTokenCacheThreadState *state = [self threadStateCreatingIfNeeded:YES];
+    
+    // Decided once per access, the read lease or the generation may change before didAccessCache
+    ADALTokenCacheAccess *access = [ADALTokenCacheAccess new];
+    access.forwarded = [self shouldNotifyDelegateOfAccess:state];
+    [state.accesses addObject:access];
+    
+    if (access.forwarded)
+    {
+        dispatch_sync(self.synchronizationQueue, ^{
+            // Taken before the load, so a change that races with it is picked up on the next access
+            access.generation = [self currentGeneration];
+            [_delegate willAccessCache:self];
+        });
+        
+        if (state.lookupPassDepth)
+        {
+            state.lookupPassAccessOpen = YES;
+            state.lookupPassGeneration = access.generation;
+        }
+    }
 }
 
 - (void)didAccessCache:(nonnull MSIDMacTokenCache *)cache
 {
-    dispatch_sync(self.synchronizationQueue, ^{
-        [_delegate didAccessCache:self];
-    });
+    ADALTokenCacheThreadState *state = [self threadStateCreatingIfNeeded:NO];
+    ADALTokenCacheAccess *access = state.accesses.lastObject;
+    
+    if (!access)
+    {
+        return;
+    }
+    
+    [state.accesses removeLastObject];
+    
+    if (state.lookupPassDepth)
+    {
+        // Later lookups of the pass are served from this load, the access ends with the pass
+        state.lookupPassLoaded = YES;
+    }
+    else if (access.forwarded)
+    {
+        dispatch_sync(self.synchronizationQueue, ^{
+            [_delegate didAccessCache:self];
+        });
+        
+        [self markLoadedWithGeneration:access.generation];
+    }
+    
+    [self releaseThreadStateIfIdle:state];
 }
 
 - (void)willWriteCache:(nonnull MSIDMacTokenCache *)cache
 {
-    dispatch_sync(self.synchronizationQueue, ^{
-        [_delegate willWriteCache:self];
-    });
+    ADALTokenCacheThreadState *state = [self threadStateCreatingIfNeeded:YES];
+    state.writeDepth++;
+    
+    atomic_fetch_add(&_contentsGeneration, 1);
+    
+    // Inside of a batch only the first write of the thread reloads the cache
+    if (!state.writeBatchHasWrites)
+    {
+        dispatch_sync(self.synchronizationQueue, ^{
+            [_delegate willWriteCache:self];
+        });
+        
+        state.writeBatchHasWrites = state.writeBatchDepth > 0;
+    }
 }
 
 - (void)didWriteCache:(nonnull MSIDMacTokenCache *)cache
 {
-    dispatch_sync(self.synchronizationQueue, ^{
-        [_delegate didWriteCache:self];
-    });
+    atomic_fetch_add(&_contentsGeneration, 1);
+    
+    ADALTokenCacheThreadState *state = [self threadStateCreatingIfNeeded:NO];
+    
+    // Inside of a batch the write is persisted on commit
+    if (!state.writeBatchDepth)
+    {
+        dispatch_sync(self.synchronizationQueue, ^{
+            [_delegate didWriteCache:self];
+        });
+        
+        // The delegate has reloaded the cache before the write and persisted it after,
+        // so memory and storage are in sync again.
+        [self markLoadedWithGeneration:[self currentGeneration]];
+    }
+    
+    if (state.writeDepth)
+    {
+        state.writeDepth--;
+        [self releaseThreadStateIfIdle:state];
+    }
+}
+
+- (BOOL)shouldNotifyDelegateOfAccess:(ADALTokenCacheThreadState *)state
+{
+    // Once a batch of this thread has written, the in-memory cache is ahead of the persisted
+    // one and reloading it would drop the pending writes.
+    if (state.writeBatchHasWrites)
+    {
+        return NO;
+    }
+    
+    return !state.lookupPassLoaded && ![self canServeReadsFromMemory];
+}
+
+- (BOOL)canServeReadsFromMemory
+{
+    if (self.readLeaseEnabled && self.readLeaseHeld)
+    {
+        return YES;
+    }
+    
+    return self.hasLoadedGeneration && self.loadedGeneration == [self currentGeneration];
+}
+
+- (uint64_t)currentGeneration
+{
+    if (!self.delegateProvidesGeneration)
+    {
+        return 0;
+    }
+    
+    id<ADALTokenCacheDelegate> delegate = _delegate;
+    return [delegate respondsToSelector:@selector(generationOfCache:)] ? [delegate generationOfCache:self] : 0;
+}
+
+- (void)markLoadedWithGeneration:(uint64_t)generation
+{
+    self.readLeaseHeld = self.readLeaseEnabled;
+    self.loadedGeneration = generation;
+    self.hasLoadedGeneration = self.delegateProvidesGeneration;
+}
+
+- (ADALTokenCacheThreadState *)threadStateCreatingIfNeeded:(BOOL)create
+{
+    NSMutableDictionary *threadDictionary = [NSThread currentThread].threadDictionary;
+    ADALTokenCacheThreadState *state = threadDictionary[self.threadStateKey];
+    
+    if (!state && create)
+    {
+        // A batch of another thread may hold writes it hasn't persisted yet, reading them now
+        // would see half of them and reloading the cache would drop them.
+        pthread_mutex_lock(&_threadsMutex);
+        
+        while (_writeBatchOpen)
+        {
+            pthread_cond_wait(&_threadsCondition, &_threadsMutex);
+        }
+        
+        _threadsInCache++;
+        pthread_mutex_unlock(&_threadsMutex);
+        
+        state = [ADALTokenCacheThreadState new];
+        threadDictionary[self.threadStateKey] = state;
+    }
+    
+    return state;
+}
+
+- (void)releaseThreadStateIfIdle:(ADALTokenCacheThreadState *)state
+{
+    if (![state isIdle])
+    {
+        return;
+    }
+    
+    [[NSThread currentThread].threadDictionary removeObjectForKey:self.threadStateKey];
+    
+    pthread_mutex_lock(&_threadsMutex);
+    _threadsInCache--;
+    pthread_cond_broadcast(&_threadsCondition);
+    pthread_mutex_unlock(&_threadsMutex);
+}
+
+#pragma mark - ADALTokenCacheWriteBatching
+
+- (void)beginWriteBatch
+{
+    ADALTokenCacheThreadState *state = [self threadStateCreatingIfNeeded:YES];
+    
+    if (state.writeBatchDepth++)
+    {
+        return;
+    }
+    
+    // The batch has the cache to itself until it's committed, what other threads have opened
+    // is finished first. The thread stops counting itself while it waits, so that two threads
+    // beginning a batch at the same time don't wait for each other.
+    pthread_mutex_lock(&_threadsMutex);
+    _threadsInCache--;
+    
+    while (_writeBatchOpen || _threadsInCache)
+    {
+        pthread_cond_wait(&_threadsCondition, &_threadsMutex);
+    }
+    
+    _writeBatchOpen = YES;
+    pthread_mutex_unlock(&_threadsMutex);
+}
+
+- (void)commitWriteBatch
+{
+    ADALTokenCacheThreadState *state = [self threadStateCreatingIfNeeded:NO];
+    
+    if (!state.writeBatchDepth)
+    {
+        return;
+    }
+    
+    if (state.writeBatchDepth == 1 && state.writeBatchHasWrites)
+    {
+        dispatch_sync(self.synchronizationQueue, ^{
+            [_delegate didWriteCache:self];
+        });
+        
+        state.writeBatchHasWrites = NO;
+        [self markLoadedWithGeneration:[self currentGeneration]];
+    }
+    
+    if (state.writeBatchDepth == 1)
+    {
+        pthread_mutex_lock(&_threadsMutex);
+        _writeBatchOpen = NO;
+        _threadsInCache++;
+        pthread_cond_broadcast(&_threadsCondition);
+        pthread_mutex_unlock(&_threadsMutex);
+    }
+    
+    state.writeBatchDepth--;
+    [self releaseThreadStateIfIdle:state];
+}
+
+#pragma mark - ADALTokenCacheLookupPass
+
+- (void)beginLookupPass
+{
+    [self threadStateCreatingIfNeeded:YES].lookupPassDepth++;
+}
+
+- (void)endLookupPass
+{
+    ADALTokenCacheThreadState *state = [self threadStateCreatingIfNeeded:NO];
+    
+    if (!state.lookupPassDepth)
+    {
+        return;
+    }
+    
+    if (state.lookupPassDepth == 1)
+    {
+        if (state.lookupPassAccessOpen)
+        {
+            dispatch_sync(self.synchronizationQueue, ^{
+                [_delegate didAccessCache:self];
+            });
+            
+            [self markLoadedWithGeneration:state.lookupPassGeneration];
+        }
+        
+        state.lookupPassLoaded = NO;
+        state.lookupPassAccessOpen = NO;
+    }
+    
+    state.lookupPassDepth--;
+    [self releaseThreadStateIfIdle:state];
 }
 
 #pragma mark - Internal
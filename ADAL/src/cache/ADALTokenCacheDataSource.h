@@ -25,6 +25,33 @@
 @class ADALTokenCacheItem;
 @class ADALAuthenticationError;
 
+/*!
+ Implemented by caches that persist through a delegate. All writes a thread makes between
+ beginWriteBatch and commitWriteBatch are persisted with a single delegate write, the delegate
+ is told about the first write and the outermost commit only. Batches are per thread, an open
+ batch has the cache to itself: it waits for the accesses, writes and lookup passes other threads
+ have open, and other threads wait with any new access or write until the batch is committed.
+ */
+@protocol ADALTokenCacheWriteBatching <NSObject>
+
+- (void)beginWriteBatch;
+- (void)commitWriteBatch;
+
+@end
+
+/*!
+ Implemented by caches that load through a delegate. All lookups a thread makes between
+ beginLookupPass and endLookupPass are served from a single delegate load. Passes are per thread,
+ other threads keep accessing the cache while a pass is open, but a write batch waits for it.
+ Only lookups may be made inside of a pass.
+ */
+@protocol ADALTokenCacheLookupPass <NSObject>
+
+- (void)beginLookupPass;
+- (void)endLookupPass;
+
+@end
+
 @protocol ADALTokenCacheDataSource <NSObject>
 
 /*!
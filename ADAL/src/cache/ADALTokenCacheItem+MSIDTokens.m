@@ -29,6 +29,7 @@
 #import "MSIDLegacySingleResourceToken.h"
 #import "MSIDLegacyTokenCacheKey.h"
 #import "ADALTokenCacheItem+Internal.h"
+#import "NSString+ADALInterning.h"
 #import "MSIDLegacyTokenCacheItem.h"
 #import "NSURL+MSIDExtensions.h"
 #import "MSIDAccountIdentifier.h"
@@ -51,7 +52,7 @@
                                              homeAccountId:accessToken.accountIdentifier.homeAccountId];
         _accessTokenType = accessToken.accessTokenType;
         _accessToken = accessToken.accessToken;
-        _resource = accessToken.resource;
+        _resource = [accessToken.resource adInternedString];
         _expiresOn = accessToken.expiresOn;
         _enrollmentId = accessToken.enrollmentId;
         _applicationIdentifier = accessToken.applicationIdentifier;
@@ -133,8 +134,8 @@
     self = [super init];
     if (self)
     {
-        _clientId = baseToken.clientId;
-        _authority = baseToken.authority.url.absoluteString;
+        _clientId = [baseToken.clientId adInternedString];
+        _authority = [baseToken.authority.url.absoluteString adInternedString];
         _storageAuthority = baseToken.storageAuthority.url.absoluteString;
         _additionalServer = baseToken.additionalServerInfo;
     }
@@ -27,6 +27,7 @@
 #import "ADALAuthenticationSettings.h"
 #import "ADALTokenCacheKey.h"
 #import "ADALTokenCacheItem+Internal.h"
+#import "NSString+ADALInterning.h"
 
 @implementation ADALTokenCacheItem
 
@@ -153,9 +154,9 @@
         return nil;
     }
     
-    _resource = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"resource"];
-    _authority = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"authority"];
-    _clientId = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"clientId"];
+    _resource = [[aDecoder decodeObjectOfClass:[NSString class] forKey:@"resource"] adInternedString];
+    _authority = [[aDecoder decodeObjectOfClass:[NSString class] forKey:@"authority"] adInternedString];
+    _clientId = [[aDecoder decodeObjectOfClass:[NSString class] forKey:@"clientId"] adInternedString];
 	_familyId = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"familyId"];
 
     _accessToken = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"accessToken"];
@@ -46,6 +46,15 @@
                              clientId:(NSString *)clientId
                                 error:(ADALAuthenticationError * __autoreleasing *)error;
 
+/*! Creates a key from components that are already canonical, skipping canonicalization and validation.
+ @param authority Required. Canonicalized with +[ADALHelpers canonicalizeAuthority:].
+ @param resource Optional. Trimmed and lowercased.
+ @param clientId Required. Trimmed and lowercased.
+ */
++ (ADALTokenCacheKey *)keyWithCanonicalAuthority:(NSString *)authority
+                                       resource:(NSString *)resource
+                                       clientId:(NSString *)clientId;
+
 /*! Creates a key with optional application identifier */
 + (ADALTokenCacheKey *)keyWithAuthority:(NSString *)authority
                              resource:(NSString *)resource
@@ -26,6 +26,7 @@
 #import "ADALAuthenticationContext.h"
 #import "ADALHelpers.h"
 #import "ADALTokenCacheKey.h"
+#import "NSString+ADALInterning.h"
 
 @interface ADALTokenCacheKey()
 
@@ -47,10 +48,19 @@
     [NSKeyedUnarchiver setClass:self forClassName:@"ADTokenCacheKey"];
 }
 
+static inline NSUInteger ADALCombineHash(NSUInteger seed, NSUInteger hash)
+{
+    return seed ^ (hash + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
 - (void)calculateHash
 {
-    _hash = [[NSString stringWithFormat:@"##%@##%@##%@##", _authority, _resource, _clientId]
-             hash];
+    // Combines the component hashes instead of hashing a concatenated string, so no temporary
+    // string is created. A nil resource hashes differently from an empty one.
+    NSUInteger hash = [_authority hash];
+    hash = ADALCombineHash(hash, _resource ? [_resource hash] : 0x5bd1e995);
+    hash = ADALCombineHash(hash, [_clientId hash]);
+    _hash = hash;
 }
 
 - (id)initWithAuthority:(NSString *)authority
@@ -71,6 +81,13 @@
     return self;
 }
 
++ (ADALTokenCacheKey *)keyWithCanonicalAuthority:(NSString *)authority
+                                       resource:(NSString *)resource
+                                       clientId:(NSString *)clientId
+{
+    return [[ADALTokenCacheKey alloc] initWithAuthority:authority resource:resource clientId:clientId];
+}
+
 + (ADALTokenCacheKey *)keyWithAuthority:(NSString *)authority
                              resource:(NSString *)resource
                              clientId:(NSString *)clientId
@@ -111,6 +128,11 @@
 
 - (BOOL)isEqual:(id)object
 {
+    if (self == object)
+    {
+        return YES;
+    }
+    
     if (!object)
     {
         return NO;
@@ -123,21 +145,21 @@
     
     ADALTokenCacheKey* key = object;
     
-    //First check the fields which cannot be nil:
-    if (![self.authority isEqualToString:key.authority] ||
-        ![self.clientId isEqualToString:key.clientId])
+    //First check the fields which cannot be nil, interned components are usually the same instance:
+    if ((_authority != key->_authority && ![_authority isEqualToString:key->_authority]) ||
+        (_clientId != key->_clientId && ![_clientId isEqualToString:key->_clientId]))
     {
         return NO;
     }
     
     //Now handle the case of nil resource:
-    if (!self.resource)
+    if (!_resource)
     {
-        return !key.resource;//Both should be nil to be equal
+        return !key->_resource;//Both should be nil to be equal
     }
     else
     {
-        return [self.resource isEqualToString:key.resource];
+        return _resource == key->_resource || [_resource isEqualToString:key->_resource];
     }
 }
 
@@ -155,9 +177,9 @@
         return nil;
     }
     
-    _authority = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"authority"];
-    _resource = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"resource"];
-    _clientId = [aDecoder decodeObjectOfClass:[NSString class] forKey:@"clientId"];
+    _authority = [[aDecoder decodeObjectOfClass:[NSString class] forKey:@"authority"] adInternedString];
+    _resource = [[aDecoder decodeObjectOfClass:[NSString class] forKey:@"resource"] adInternedString];
+    _clientId = [[aDecoder decodeObjectOfClass:[NSString class] forKey:@"clientId"] adInternedString];
     
     [self calculateHash];
     
@@ -184,7 +206,8 @@
 
 - (ADALTokenCacheKey *)mrrtKey
 {
-    return [[self class] keyWithAuthority:_authority resource:nil clientId:_clientId appIdentifier:nil error:nil];
+    // The components of an existing key are already canonical
+    return [[self class] keyWithCanonicalAuthority:_authority resource:nil clientId:_clientId];
 }
 
 @end
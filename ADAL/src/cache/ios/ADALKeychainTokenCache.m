@@ -149,6 +149,18 @@ static ADALKeychainTokenCache* s_defaultCache = nil;
     return [self.msidDataSourceWrapper removeItem:item error:error];
 }
 
+- (BOOL)removeExpiredItems:(NSUInteger *)removedCount
+              removedBytes:(NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError **)error
+{
+    return [self.msidDataSourceWrapper removeExpiredItems:removedCount removedBytes:removedBytes error:error];
+}
+
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval
+{
+    [self.msidDataSourceWrapper setExpiredItemsSweepInterval:interval];
+}
+
 @end
 
 @implementation ADALKeychainTokenCache (Internal)
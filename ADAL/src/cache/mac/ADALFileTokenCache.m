@@ -0,0 +1,171 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADAL_Internal.h"
+#import "ADALFileTokenCache+Internal.h"
+#import "ADALFileTokenCacheDataSource.h"
+#import "ADALAuthenticationErrorConverter.h"
+#import "ADALMSIDDataSourceWrapper.h"
+#import "MSIDKeyedArchiverSerializer.h"
+#import "ADALHelpers.h"
+
+@interface ADALFileTokenCache()
+
+@property (nonatomic) ADALFileTokenCacheDataSource *fileDataSource;
+@property (nonatomic) ADALMSIDDataSourceWrapper *msidDataSourceWrapper;
+
+@end
+
+@implementation ADALFileTokenCache
+
+- (id)init
+{
+    //Ensure that the appropriate init function is called. This will cause the runtime to throw.
+    [super doesNotRecognizeSelector:_cmd];
+    return nil;
+}
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _fileDataSource = [[ADALFileTokenCacheDataSource alloc] initWithPath:path];
+    _msidDataSourceWrapper = [[ADALMSIDDataSourceWrapper alloc] initWithMSIDDataSource:_fileDataSource
+                                                                          serializer:[MSIDKeyedArchiverSerializer new]];
+    
+    return self;
+}
+
+- (NSString *)path
+{
+    return _fileDataSource.path;
+}
+
+#pragma mark - Public cache
+
+- (BOOL)removeAllForClientId:(NSString *)clientId
+                       error:(ADALAuthenticationError **)error
+{
+    clientId = [clientId msidTrimmedString];
+    RETURN_ON_INVALID_ARGUMENT([NSString msidIsStringNilOrBlank:clientId], clientId, NO);
+    
+    return [self.msidDataSourceWrapper removeAllForClientId:clientId error:error];
+}
+
+- (BOOL)removeAllForUserId:(NSString *)userId
+                  clientId:(NSString *)clientId
+                     error:(ADALAuthenticationError **)error
+{
+    userId = [ADALHelpers normalizeUserId:userId];
+    clientId = [clientId msidTrimmedString];
+    RETURN_ON_INVALID_ARGUMENT([NSString msidIsStringNilOrBlank:userId], userId, NO);
+    RETURN_ON_INVALID_ARGUMENT([NSString msidIsStringNilOrBlank:clientId], clientId, NO);
+    
+    return [self.msidDataSourceWrapper removeAllForUserId:userId
+                                                 clientId:clientId
+                                                    error:error];
+}
+
+- (BOOL)wipeAllItemsForUserId:(NSString *)userId
+                        error:(ADALAuthenticationError **)error
+{
+    userId = [ADALHelpers normalizeUserId:userId];
+    RETURN_ON_INVALID_ARGUMENT([NSString msidIsStringNilOrBlank:userId], userId, NO);
+    
+    return [self.msidDataSourceWrapper wipeAllItemsForUserId:userId error:error];
+}
+
+- (NSArray<ADALTokenCacheItem *> *)allItems:(ADALAuthenticationError **)error
+{
+    return [self.msidDataSourceWrapper allItems:error];
+}
+
+- (BOOL)removeItem:(ADALTokenCacheItem *)item
+             error:(ADALAuthenticationError **)error
+{
+    return [self.msidDataSourceWrapper removeItem:item error:error];
+}
+
+- (BOOL)removeExpiredItems:(NSUInteger *)removedCount
+              removedBytes:(NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError **)error
+{
+    return [self.msidDataSourceWrapper removeExpiredItems:removedCount removedBytes:removedBytes error:error];
+}
+
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval
+{
+    [self.msidDataSourceWrapper setExpiredItemsSweepInterval:interval];
+}
+
+- (BOOL)compact:(ADALAuthenticationError **)error
+{
+    NSError *cacheError = nil;
+    BOOL result = [self.fileDataSource compactWithContext:nil error:&cacheError];
+    
+    if (cacheError && error)
+    {
+        *error = [ADALAuthenticationErrorConverter ADALAuthenticationErrorFromMSIDError:cacheError];
+    }
+    
+    return result;
+}
+
+@end
+
+@implementation ADALFileTokenCache (Internal)
+
+@dynamic fileDataSource;
+
+- (NSArray<ADALTokenCacheItem *> *)getItemsWithKey:(ADALTokenCacheKey *)key
+                                          userId:(NSString *)userId
+                                   correlationId:(NSUUID *)correlationId
+                                           error:(ADALAuthenticationError * __autoreleasing *)error
+{
+    return [self.msidDataSourceWrapper getItemsWithKey:key userId:userId correlationId:correlationId error:error];
+}
+
+- (ADALTokenCacheItem *)getItemWithKey:(ADALTokenCacheKey *)key
+                                userId:(NSString *)userId
+                         correlationId:(NSUUID *)correlationId
+                                 error:(ADALAuthenticationError * __autoreleasing *)error
+{
+    return [self.msidDataSourceWrapper getItemWithKey:key userId:userId correlationId:correlationId error:error];
+}
+
+- (BOOL)addOrUpdateItem:(ADALTokenCacheItem *)item
+          correlationId:(NSUUID *)correlationId
+                  error:(ADALAuthenticationError * __autoreleasing *)error
+{
+    return [self.msidDataSourceWrapper addOrUpdateItem:item correlationId:correlationId error:error];
+}
+
+- (NSDictionary *)getWipeTokenData
+{
+    return [self.msidDataSourceWrapper getWipeTokenData];
+}
+
+@end
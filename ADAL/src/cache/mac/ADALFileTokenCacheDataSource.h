@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "MSIDTokenCacheDataSource.h"
+
+/*!
+ MSIDTokenCacheDataSource backed by a single file shared between processes.
+ 
+ Items are appended to the file as records and located through an in-memory index
+ built from a read-only memory mapping of the file, so lookups only copy the bytes
+ of the matching items. Updates and removals append a new record for the same key,
+ the file is compacted once more than half of it is taken by superseded records.
+ Access from multiple processes is coordinated with flock(2) on the file.
+ */
+@interface ADALFileTokenCacheDataSource : NSObject <MSIDTokenCacheDataSource>
+
+@property (nonatomic, readonly) NSString *path;
+
+- (instancetype)initWithPath:(NSString *)path;
+
+/*! Rewrites the file with only the live records. */
+- (BOOL)compactWithContext:(id<MSIDRequestContext>)context
+                     error:(NSError **)error;
+
+@end
@@ -0,0 +1,789 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <sys/file.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import "ADALFileTokenCacheDataSource.h"
+#import "MSIDCacheKey.h"
+#import "MSIDCredentialCacheItem.h"
+#import "MSIDAccountCacheItem.h"
+#import "MSIDCredentialItemSerializer.h"
+#import "MSIDAccountItemSerializer.h"
+#import "MSIDError.h"
+
+#define ADAL_FILE_CACHE_MAGIC "ADALFTC1"
+#define ADAL_FILE_CACHE_VERSION 1
+#define ADAL_FILE_CACHE_MIN_COMPACTION_BYTES (64 * 1024)
+
+static NSString *const s_keySeparator = @"\x1f";
+static NSString *const s_wipeInfoKey = @"wipe";
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+} ADALFileTokenCacheHeader;
+
+typedef struct
+{
+    uint32_t kind;
+    uint32_t flags;
+    uint32_t keyLength;
+    uint32_t valueLength;
+} ADALFileTokenCacheRecordHeader;
+
+typedef NS_ENUM(uint32_t, ADALFileTokenCacheRecordKind)
+{
+    ADALFileTokenCacheRecordCredential = 1,
+    ADALFileTokenCacheRecordAccount = 2,
+    ADALFileTokenCacheRecordWipeInfo = 3,
+};
+
+// A record with this flag removes the item stored under its key
+#define ADAL_FILE_CACHE_RECORD_REMOVED 0x1
+
+@interface ADALFileTokenCacheIndexEntry : NSObject
+
+@property (nonatomic) ADALFileTokenCacheRecordKind kind;
+@property (nonatomic) NSString *account;
+@property (nonatomic) NSString *service;
+@property (nonatomic) NSNumber *type;
+@property (nonatomic) NSRange valueRange;
+@property (nonatomic) NSUInteger recordLength;
+
+@end
+
+@implementation ADALFileTokenCacheIndexEntry
+@end
+
+@interface ADALFileTokenCacheDataSource()
+{
+    int _fd;
+    dev_t _fileDevice;
+    ino_t _fileInode;
+    BOOL _lockedExclusively;
+    
+    const uint8_t *_map;
+    size_t _mapLength;
+    
+    // Offset up to which the file has been read into the index
+    uint64_t _indexedLength;
+    uint64_t _deadBytes;
+    NSMutableDictionary<NSString *, ADALFileTokenCacheIndexEntry *> *_index;
+}
+
+@end
+
+@implementation ADALFileTokenCacheDataSource
+
+#pragma mark - Init
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _path = path;
+    _fd = -1;
+    _index = [NSMutableDictionary new];
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    [self closeFile];
+}
+
+#pragma mark - Credentials
+
+- (BOOL)saveToken:(MSIDCredentialCacheItem *)item
+              key:(MSIDCacheKey *)key
+       serializer:(id<MSIDCredentialItemSerializer>)serializer
+          context:(id<MSIDRequestContext>)context
+            error:(NSError **)error
+{
+    NSData *itemData = [serializer serializeCredentialCacheItem:item];
+    
+    if (!itemData)
+    {
+        MSID_LOG_ERROR(context, @"Failed to serialize token cache item");
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to serialize token cache item" context:context];
+        return NO;
+    }
+    
+    return [self appendRecordWithKind:ADALFileTokenCacheRecordCredential key:key value:itemData context:context error:error];
+}
+
+- (MSIDCredentialCacheItem *)tokenWithKey:(MSIDCacheKey *)key
+                               serializer:(id<MSIDCredentialItemSerializer>)serializer
+                                  context:(id<MSIDRequestContext>)context
+                                    error:(NSError **)error
+{
+    NSArray<MSIDCredentialCacheItem *> *items = [self tokensWithKey:key serializer:serializer context:context error:error];
+    return items.firstObject;
+}
+
+- (NSArray<MSIDCredentialCacheItem *> *)tokensWithKey:(MSIDCacheKey *)key
+                                           serializer:(id<MSIDCredentialItemSerializer>)serializer
+                                              context:(id<MSIDRequestContext>)context
+                                                error:(NSError **)error
+{
+    NSArray<NSData *> *values = [self valuesWithKind:ADALFileTokenCacheRecordCredential key:key context:context error:error];
+    
+    if (!values)
+    {
+        return nil;
+    }
+    
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:values.count];
+    
+    for (NSData *value in values)
+    {
+        MSIDCredentialCacheItem *item = [serializer deserializeCredentialCacheItem:value];
+        
+        if (item)
+        {
+            [items addObject:item];
+        }
+    }
+    
+    return items;
+}
+
+- (BOOL)removeItemsWithKey:(MSIDCacheKey *)key
+                   context:(id<MSIDRequestContext>)context
+                     error:(NSError **)error
+{
+    return [self removeRecordsWithKind:ADALFileTokenCacheRecordCredential key:key context:context error:error];
+}
+
+#pragma mark - Accounts
+
+- (BOOL)saveAccount:(MSIDAccountCacheItem *)item
+                key:(MSIDCacheKey *)key
+         serializer:(id<MSIDAccountItemSerializer>)serializer
+            context:(id<MSIDRequestContext>)context
+              error:(NSError **)error
+{
+    NSData *itemData = [serializer serializeAccountCacheItem:item];
+    
+    if (!itemData)
+    {
+        MSID_LOG_ERROR(context, @"Failed to serialize account item");
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to serialize account item" context:context];
+        return NO;
+    }
+    
+    return [self appendRecordWithKind:ADALFileTokenCacheRecordAccount key:key value:itemData context:context error:error];
+}
+
+- (MSIDAccountCacheItem *)accountWithKey:(MSIDCacheKey *)key
+                              serializer:(id<MSIDAccountItemSerializer>)serializer
+                                 context:(id<MSIDRequestContext>)context
+                                   error:(NSError **)error
+{
+    NSArray<MSIDAccountCacheItem *> *accounts = [self allAccountsWithKey:key serializer:serializer context:context error:error];
+    return accounts.firstObject;
+}
+
+- (NSArray<MSIDAccountCacheItem *> *)allAccountsWithKey:(MSIDCacheKey *)key
+                                             serializer:(id<MSIDAccountItemSerializer>)serializer
+                                                context:(id<MSIDRequestContext>)context
+                                                  error:(NSError **)error
+{
+    NSArray<NSData *> *values = [self valuesWithKind:ADALFileTokenCacheRecordAccount key:key context:context error:error];
+    
+    if (!values)
+    {
+        return nil;
+    }
+    
+    NSMutableArray *accounts = [NSMutableArray arrayWithCapacity:values.count];
+    
+    for (NSData *value in values)
+    {
+        MSIDAccountCacheItem *account = [serializer deserializeAccountCacheItem:value];
+        
+        if (account)
+        {
+            [accounts addObject:account];
+        }
+    }
+    
+    return accounts;
+}
+
+- (BOOL)removeAccountsWithKey:(MSIDCacheKey *)key
+                      context:(id<MSIDRequestContext>)context
+                        error:(NSError **)error
+{
+    return [self removeRecordsWithKind:ADALFileTokenCacheRecordAccount key:key context:context error:error];
+}
+
+#pragma mark - Wipe info
+
+- (BOOL)saveWipeInfoWithContext:(id<MSIDRequestContext>)context
+                          error:(NSError **)error
+{
+    NSDictionary *wipeInfo = @{ @"bundleId" : [[NSBundle mainBundle] bundleIdentifier] ?: @"",
+                                @"wipeTime" : [NSDate date]
+                                };
+    
+    NSData *wipeData = [NSPropertyListSerialization dataWithPropertyList:wipeInfo
+                                                                  format:NSPropertyListBinaryFormat_v1_0
+                                                                 options:0
+                                                                   error:error];
+    
+    if (!wipeData)
+    {
+        return NO;
+    }
+    
+    MSIDCacheKey *wipeKey = [[MSIDCacheKey alloc] initWithAccount:s_wipeInfoKey service:s_wipeInfoKey generic:nil type:nil];
+    return [self appendRecordWithKind:ADALFileTokenCacheRecordWipeInfo key:wipeKey value:wipeData context:context error:error];
+}
+
+- (NSDictionary *)wipeInfo:(id<MSIDRequestContext>)context
+                     error:(NSError **)error
+{
+    MSIDCacheKey *wipeKey = [[MSIDCacheKey alloc] initWithAccount:s_wipeInfoKey service:s_wipeInfoKey generic:nil type:nil];
+    NSData *wipeData = [[self valuesWithKind:ADALFileTokenCacheRecordWipeInfo key:wipeKey context:context error:error] firstObject];
+    
+    if (!wipeData)
+    {
+        return nil;
+    }
+    
+    return [NSPropertyListSerialization propertyListWithData:wipeData options:NSPropertyListImmutable format:NULL error:error];
+}
+
+#pragma mark - Clear
+
+- (BOOL)clearWithContext:(id<MSIDRequestContext>)context
+                   error:(NSError **)error
+{
+    @synchronized (self)
+    {
+        if (![self lockFile:LOCK_EX context:context error:error])
+        {
+            return NO;
+        }
+        
+        // Replaced rather than truncated, so other processes reopen it instead of trusting their index
+        BOOL result = [self replaceFileWithData:[self headerData] context:context error:error];
+        
+        flock(_fd, LOCK_UN);
+        return result;
+    }
+}
+
+- (BOOL)compactWithContext:(id<MSIDRequestContext>)context
+                     error:(NSError **)error
+{
+    @synchronized (self)
+    {
+        if (![self lockFile:LOCK_EX context:context error:error])
+        {
+            return NO;
+        }
+        
+        BOOL result = [self refreshIndexWithContext:context error:error] && [self compactLockedWithContext:context error:error];
+        
+        flock(_fd, LOCK_UN);
+        return result;
+    }
+}
+
+#pragma mark - Records
+
+- (BOOL)appendRecordWithKind:(ADALFileTokenCacheRecordKind)kind
+                         key:(MSIDCacheKey *)key
+                       value:(NSData *)value
+                     context:(id<MSIDRequestContext>)context
+                       error:(NSError **)error
+{
+    if (!key.account || !key.service)
+    {
+        [self fillError:error code:MSIDErrorInternal message:@"Key is not valid, account and service are required" context:context];
+        return NO;
+    }
+    
+    @synchronized (self)
+    {
+        if (![self lockFile:LOCK_EX context:context error:error])
+        {
+            return NO;
+        }
+        
+        BOOL result = [self refreshIndexWithContext:context error:error]
+                   && [self writeRecordWithKind:kind account:key.account service:key.service type:key.type value:value context:context error:error]
+                   && [self compactIfNeededWithContext:context error:error];
+        
+        flock(_fd, LOCK_UN);
+        return result;
+    }
+}
+
+- (BOOL)removeRecordsWithKind:(ADALFileTokenCacheRecordKind)kind
+                          key:(MSIDCacheKey *)key
+                      context:(id<MSIDRequestContext>)context
+                        error:(NSError **)error
+{
+    @synchronized (self)
+    {
+        if (![self lockFile:LOCK_EX context:context error:error])
+        {
+            return NO;
+        }
+        
+        BOOL result = [self refreshIndexWithContext:context error:error];
+        
+        for (ADALFileTokenCacheIndexEntry *entry in [self entriesWithKind:kind key:key])
+        {
+            if (!result)
+            {
+                break;
+            }
+            
+            result = [self writeRecordWithKind:kind account:entry.account service:entry.service type:entry.type value:nil context:context error:error];
+        }
+        
+        result = result && [self compactIfNeededWithContext:context error:error];
+        
+        flock(_fd, LOCK_UN);
+        return result;
+    }
+}
+
+- (NSArray<NSData *> *)valuesWithKind:(ADALFileTokenCacheRecordKind)kind
+                                  key:(MSIDCacheKey *)key
+                              context:(id<MSIDRequestContext>)context
+                                error:(NSError **)error
+{
+    @synchronized (self)
+    {
+        if (![self lockFile:LOCK_SH context:context error:error])
+        {
+            return nil;
+        }
+        
+        NSMutableArray<NSData *> *values = nil;
+        
+        if ([self refreshIndexWithContext:context error:error])
+        {
+            NSArray<ADALFileTokenCacheIndexEntry *> *entries = [self entriesWithKind:kind key:key];
+            values = [NSMutableArray arrayWithCapacity:entries.count];
+            
+            for (ADALFileTokenCacheIndexEntry *entry in entries)
+            {
+                // Copied while the file is locked, the mapping may be replaced once it is released
+                [values addObject:[NSData dataWithBytes:_map + entry.valueRange.location length:entry.valueRange.length]];
+            }
+        }
+        
+        flock(_fd, LOCK_UN);
+        return values;
+    }
+}
+
+- (NSArray<ADALFileTokenCacheIndexEntry *> *)entriesWithKind:(ADALFileTokenCacheRecordKind)kind
+                                                         key:(MSIDCacheKey *)key
+{
+    if (key.account && key.service && key.type)
+    {
+        ADALFileTokenCacheIndexEntry *entry = _index[[self indexKeyWithKind:kind account:key.account service:key.service type:key.type]];
+        return entry ? @[entry] : @[];
+    }
+    
+    NSMutableArray<ADALFileTokenCacheIndexEntry *> *entries = [NSMutableArray new];
+    
+    for (ADALFileTokenCacheIndexEntry *entry in _index.allValues)
+    {
+        if (entry.kind == kind
+            && (!key.account || [key.account isEqualToString:entry.account])
+            && (!key.service || [key.service isEqualToString:entry.service])
+            && (!key.type || [key.type isEqualToNumber:entry.type]))
+        {
+            [entries addObject:entry];
+        }
+    }
+    
+    return entries;
+}
+
+- (NSString *)indexKeyWithKind:(ADALFileTokenCacheRecordKind)kind
+                       account:(NSString *)account
+                       service:(NSString *)service
+                          type:(NSNumber *)type
+{
+    return [@[@(kind), account, service, type ?: @""] componentsJoinedByString:s_keySeparator];
+}
+
+#pragma mark - File
+
+- (BOOL)lockFile:(int)operation
+         context:(id<MSIDRequestContext>)context
+           error:(NSError **)error
+{
+    while (YES)
+    {
+        if (_fd < 0 && ![self openFileWithContext:context error:error])
+        {
+            return NO;
+        }
+        
+        if (flock(_fd, operation) != 0)
+        {
+            MSID_LOG_ERROR(context, @"Failed to lock the token cache file, errno %d", errno);
+            [self fillError:error code:MSIDErrorInternal message:@"Failed to lock the token cache file" context:context];
+            return NO;
+        }
+        
+        // Clearing and compaction replace the file, in which case the one we hold is no longer the cache
+        struct stat pathStat;
+        if (stat(self.path.fileSystemRepresentation, &pathStat) == 0
+            && pathStat.st_dev == _fileDevice
+            && pathStat.st_ino == _fileInode)
+        {
+            _lockedExclusively = operation == LOCK_EX;
+            return YES;
+        }
+        
+        flock(_fd, LOCK_UN);
+        [self closeFile];
+    }
+}
+
+- (BOOL)openFileWithContext:(id<MSIDRequestContext>)context
+                      error:(NSError **)error
+{
+    _fd = open(self.path.fileSystemRepresentation, O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    
+    struct stat fileStat;
+    if (_fd < 0 || fstat(_fd, &fileStat) != 0)
+    {
+        MSID_LOG_ERROR(context, @"Failed to open the token cache file, errno %d", errno);
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to open the token cache file" context:context];
+        [self closeFile];
+        return NO;
+    }
+    
+    _fileDevice = fileStat.st_dev;
+    _fileInode = fileStat.st_ino;
+    return YES;
+}
+
+- (void)closeFile
+{
+    [self unmapFile];
+    
+    if (_fd >= 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+    
+    [_index removeAllObjects];
+    _indexedLength = 0;
+    _deadBytes = 0;
+}
+
+- (void)unmapFile
+{
+    if (_map)
+    {
+        munmap((void *)_map, _mapLength);
+        _map = NULL;
+        _mapLength = 0;
+    }
+}
+
+/*
+ Brings the index up to date with the file, the file must be locked.
+ Only records appended since the last call are read. The file is never truncated below
+ its complete records, clearing and compaction replace it with a new one instead.
+ */
+- (BOOL)refreshIndexWithContext:(id<MSIDRequestContext>)context
+                          error:(NSError **)error
+{
+    struct stat fileStat;
+    if (fstat(_fd, &fileStat) != 0)
+    {
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to read the token cache file" context:context];
+        return NO;
+    }
+    
+    uint64_t fileLength = (uint64_t)fileStat.st_size;
+    
+    if (fileLength == 0)
+    {
+        // A new file, readers see it as empty and the first writer adds the header
+        [self unmapFile];
+        return _lockedExclusively ? [self writeHeaderWithContext:context error:error] : YES;
+    }
+    
+    if (fileLength == _indexedLength && _map)
+    {
+        return YES;
+    }
+    
+    [self unmapFile];
+    
+    void *map = mmap(NULL, (size_t)fileLength, PROT_READ, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED)
+    {
+        MSID_LOG_ERROR(context, @"Failed to map the token cache file, errno %d", errno);
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to map the token cache file" context:context];
+        return NO;
+    }
+    
+    _map = map;
+    _mapLength = (size_t)fileLength;
+    
+    if (_indexedLength == 0)
+    {
+        if (fileLength < sizeof(ADALFileTokenCacheHeader)
+            || memcmp(_map, ADAL_FILE_CACHE_MAGIC, sizeof(((ADALFileTokenCacheHeader *)0)->magic)) != 0)
+        {
+            MSID_LOG_ERROR(context, @"Token cache file has unexpected format");
+            [self fillError:error code:MSIDErrorCacheBadFormat message:@"Token cache file has unexpected format" context:context];
+            return NO;
+        }
+        
+        _indexedLength = sizeof(ADALFileTokenCacheHeader);
+    }
+    
+    while (_indexedLength + sizeof(ADALFileTokenCacheRecordHeader) <= fileLength)
+    {
+        ADALFileTokenCacheRecordHeader recordHeader;
+        memcpy(&recordHeader, _map + _indexedLength, sizeof(recordHeader));
+        
+        uint64_t keyOffset = _indexedLength + sizeof(recordHeader);
+        uint64_t recordLength = sizeof(recordHeader) + (uint64_t)recordHeader.keyLength + recordHeader.valueLength;
+        
+        if (_indexedLength + recordLength > fileLength)
+        {
+            // Partially written record of a writer that didn't finish, it is overwritten by the next append
+            break;
+        }
+        
+        [self indexRecord:recordHeader
+                keyOffset:keyOffset
+             recordLength:recordLength];
+        
+        _indexedLength += recordLength;
+    }
+    
+    return YES;
+}
+
+- (void)indexRecord:(ADALFileTokenCacheRecordHeader)recordHeader
+          keyOffset:(uint64_t)keyOffset
+       recordLength:(uint64_t)recordLength
+{
+    NSString *keyString = [[NSString alloc] initWithBytes:_map + keyOffset
+                                                   length:recordHeader.keyLength
+                                                 encoding:NSUTF8StringEncoding];
+    NSArray<NSString *> *components = [keyString componentsSeparatedByString:s_keySeparator];
+    
+    if (components.count != 4)
+    {
+        _deadBytes += recordLength;
+        return;
+    }
+    
+    NSString *indexKey = keyString;
+    ADALFileTokenCacheIndexEntry *previous = _index[indexKey];
+    
+    if (previous)
+    {
+        _deadBytes += previous.recordLength;
+    }
+    
+    if (recordHeader.flags & ADAL_FILE_CACHE_RECORD_REMOVED)
+    {
+        [_index removeObjectForKey:indexKey];
+        _deadBytes += recordLength;
+        return;
+    }
+    
+    ADALFileTokenCacheIndexEntry *entry = [ADALFileTokenCacheIndexEntry new];
+    entry.kind = recordHeader.kind;
+    entry.account = components[1];
+    entry.service = components[2];
+    entry.type = components[3].length ? @(components[3].integerValue) : nil;
+    entry.valueRange = NSMakeRange((NSUInteger)(keyOffset + recordHeader.keyLength), recordHeader.valueLength);
+    entry.recordLength = (NSUInteger)recordLength;
+    _index[indexKey] = entry;
+}
+
+- (NSData *)headerData
+{
+    ADALFileTokenCacheHeader header = { .version = ADAL_FILE_CACHE_VERSION };
+    memcpy(header.magic, ADAL_FILE_CACHE_MAGIC, sizeof(header.magic));
+    
+    return [NSData dataWithBytes:&header length:sizeof(header)];
+}
+
+/*
+ Writes the header of a new file. The file must be locked exclusively.
+ */
+- (BOOL)writeHeaderWithContext:(id<MSIDRequestContext>)context
+                         error:(NSError **)error
+{
+    NSData *header = [self headerData];
+    
+    if (pwrite(_fd, header.bytes, header.length, 0) != (ssize_t)header.length)
+    {
+        MSID_LOG_ERROR(context, @"Failed to write the token cache file, errno %d", errno);
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to write the token cache file" context:context];
+        return NO;
+    }
+    
+    _indexedLength = 0;
+    return [self refreshIndexWithContext:context error:error];
+}
+
+/*
+ Appends a record after the last complete record in the file and indexes it.
+ A nil value appends a removal. The file must be locked exclusively.
+ */
+- (BOOL)writeRecordWithKind:(ADALFileTokenCacheRecordKind)kind
+                    account:(NSString *)account
+                    service:(NSString *)service
+                       type:(NSNumber *)type
+                      value:(NSData *)value
+                    context:(id<MSIDRequestContext>)context
+                      error:(NSError **)error
+{
+    NSData *keyData = [[self indexKeyWithKind:kind account:account service:service type:type] dataUsingEncoding:NSUTF8StringEncoding];
+    
+    ADALFileTokenCacheRecordHeader recordHeader = {
+        .kind = kind,
+        .flags = value ? 0 : ADAL_FILE_CACHE_RECORD_REMOVED,
+        .keyLength = (uint32_t)keyData.length,
+        .valueLength = (uint32_t)value.length
+    };
+    
+    NSMutableData *record = [NSMutableData dataWithCapacity:sizeof(recordHeader) + keyData.length + value.length];
+    [record appendBytes:&recordHeader length:sizeof(recordHeader)];
+    [record appendData:keyData];
+    
+    if (value)
+    {
+        [record appendData:value];
+    }
+    
+    // Drops a partially written record left behind by a writer that didn't finish, complete
+    // records of other processes are already indexed as the index was refreshed under the lock
+    if (ftruncate(_fd, (off_t)_indexedLength) != 0
+        || pwrite(_fd, record.bytes, record.length, (off_t)_indexedLength) != (ssize_t)record.length)
+    {
+        MSID_LOG_ERROR(context, @"Failed to write the token cache file, errno %d", errno);
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to write the token cache file" context:context];
+        return NO;
+    }
+    
+    return [self refreshIndexWithContext:context error:error];
+}
+
+- (BOOL)compactIfNeededWithContext:(id<MSIDRequestContext>)context
+                             error:(NSError **)error
+{
+    if (_deadBytes < ADAL_FILE_CACHE_MIN_COMPACTION_BYTES || _deadBytes * 2 < _indexedLength)
+    {
+        return YES;
+    }
+    
+    return [self compactLockedWithContext:context error:error];
+}
+
+/*
+ Writes the live records into a new file and moves it over the cache file.
+ The file must be locked exclusively.
+ */
+- (BOOL)compactLockedWithContext:(id<MSIDRequestContext>)context
+                           error:(NSError **)error
+{
+    NSMutableData *compacted = [NSMutableData dataWithCapacity:(NSUInteger)(_indexedLength - _deadBytes)];
+    [compacted appendData:[self headerData]];
+    
+    for (ADALFileTokenCacheIndexEntry *entry in _index.allValues)
+    {
+        [compacted appendBytes:_map + entry.valueRange.location + entry.valueRange.length - entry.recordLength
+                        length:entry.recordLength];
+    }
+    
+    return [self replaceFileWithData:compacted context:context error:error];
+}
+
+/*
+ Writes the data into a new file and moves it over the cache file. Other processes notice
+ the replaced file after taking the lock and reopen it. The file must be locked exclusively.
+ */
+- (BOOL)replaceFileWithData:(NSData *)data
+                    context:(id<MSIDRequestContext>)context
+                      error:(NSError **)error
+{
+    NSString *replacementPath = [self.path stringByAppendingFormat:@".%@", [NSUUID UUID].UUIDString];
+    NSError *writeError = nil;
+    
+    if (![data writeToFile:replacementPath options:0 error:&writeError]
+        || chmod(replacementPath.fileSystemRepresentation, S_IRUSR | S_IWUSR) != 0
+        || rename(replacementPath.fileSystemRepresentation, self.path.fileSystemRepresentation) != 0)
+    {
+        MSID_LOG_ERROR(context, @"Failed to replace the token cache file, error %@, errno %d", writeError, errno);
+        unlink(replacementPath.fileSystemRepresentation);
+        [self fillError:error code:MSIDErrorInternal message:@"Failed to replace the token cache file" context:context];
+        return NO;
+    }
+    
+    // Keeps the lock on the replaced file until the caller releases it, the next access opens the new one
+    [self unmapFile];
+    [_index removeAllObjects];
+    _indexedLength = 0;
+    _deadBytes = 0;
+    _fileInode = 0;
+    
+    return YES;
+}
+
+#pragma mark - Helpers
+
+- (void)fillError:(NSError **)error
+             code:(MSIDErrorCode)code
+          message:(NSString *)message
+          context:(id<MSIDRequestContext>)context
+{
+    if (error)
+    {
+        *error = MSIDCreateError(MSIDErrorDomain, code, message, nil, nil, nil, context.correlationId, nil);
+    }
+}
+
+@end
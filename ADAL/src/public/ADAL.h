@@ -55,5 +55,6 @@ typedef void(^ADAuthenticationCallback)(ADALAuthenticationResult* _Nonnull resul
 #import <ADAL/ADALKeychainTokenCache.h>
 #else
 #import <ADAL/ADALTokenCache.h>
+#import <ADAL/ADALFileTokenCache.h>
 #endif
 
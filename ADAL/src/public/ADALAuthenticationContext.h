@@ -33,6 +33,7 @@
 
 #if !TARGET_OS_IPHONE
 @class ADALTokenCache;
+@class ADALFileTokenCache;
 @protocol ADALTokenCacheDelegate;
 #endif
 
@@ -106,6 +107,10 @@ typedef enum
 @class ADALAuthenticationResult;
 @class MSIDLegacyTokenCacheAccessor;
 
+#if !TARGET_OS_IPHONE
+typedef void (^ADALCachePreloadCompletion)(NSUInteger itemCount, ADALAuthenticationError * _Nullable error);
+#endif
+
 /*!
     @class ADALAuthenticationContext
  
@@ -159,6 +164,22 @@ typedef enum
                validateAuthority:(BOOL)validateAuthority
                    cacheDelegate:(nullable id<ADALTokenCacheDelegate>)delegate
                            error:(ADALAuthenticationError * __autoreleasing _Nullable * _Nullable)error;
+
+/*!
+    Initializes an instance of ADALAuthenticationContext with the provided parameters.
+ 
+    @param authority            The AAD or ADFS authority. Example: @"https://login.microsoftonline.com/contoso.com"
+    @param validateAuthority    Specifies if the authority should be validated.
+    @param fileCache            The ADALFileTokenCache to persist tokens in, an alternative to
+                                implementing an ADALTokenCacheDelegate.
+    @param error                (Optional) Any extra error details, if the method fails
+ 
+    @return An instance of ADALAuthenticationContext, nil if it fails.
+ */
+- (nullable id)initWithAuthority:(nonnull NSString *)authority
+               validateAuthority:(BOOL)validateAuthority
+                       fileCache:(nonnull ADALFileTokenCache *)fileCache
+                           error:(ADALAuthenticationError * __autoreleasing _Nullable * _Nullable)error;
 #endif
 
 /*!
@@ -553,6 +574,26 @@ typedef enum
                           claims:(nullable NSString *)claims
                  completionBlock:(nonnull ADAuthenticationCallback)completionBlock;
 
+#if !TARGET_OS_IPHONE
+/*! Loads the context's token cache on a background queue and looks up the refresh tokens a silent call
+ of the client falls back to, the client's MRRT and the FRT of its family. The first silent call after
+ launch then doesn't pay for the cache delegate load or the file cache index. This is optional, apps
+ that want it should call it right after creating the context, or once their own launch-critical work
+ is done.
+ 
+ The loaded cache stays in memory for the next silent call if the cache delegate supports
+ generationOfCache: or the cache has a read lease enabled, file caches keep their index.
+ Not available on iOS, where the keychain is read on every call and there's nothing to keep loaded.
+ 
+ @param clientId The client identifier whose tokens will be requested.
+ @param completionBlock Called on the main queue once the preload is done, with the number of refresh
+ tokens found for this context's authority and the client. May be nil.
+ @return The progress of the preload. Cancelling it skips the preload if it hasn't started yet.
+ */
+- (nonnull NSProgress *)preloadTokenCacheForClientId:(nonnull NSString *)clientId
+                                     completionBlock:(nullable ADALCachePreloadCompletion)completionBlock;
+#endif
+
 @end
 
 
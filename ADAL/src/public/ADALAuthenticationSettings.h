@@ -52,6 +52,13 @@
  about to expire. */
 @property uint expirationBuffer;
 
+/*! How long, in seconds, a silent request that found nothing usable in the token cache is
+ remembered, so that repeating it fails right away instead of reading the cache again.
+ Any token this process writes drops the remembered misses, but writes made by other apps
+ sharing the cache are not noticed. Only enable it when this app is the only writer of its
+ cache. Defaults to 0, which disables it. */
+@property NSTimeInterval silentMissTimeToLive;
+
 #if TARGET_OS_IPHONE
 /*! deprecated: This is replaced by webviewPresentationStyle. */
 @property BOOL enableFullScreen __attribute((deprecated("Use the webviewPresentationStyle property instead.")));
@@ -34,6 +34,13 @@ typedef enum
     ADAL_LOG_LAST = ADAL_LOG_LEVEL_VERBOSE,
 } ADAL_LOG_LEVEL;
 
+/*! What asynchronous logging does with a new message when its buffer is full */
+typedef enum
+{
+    ADAL_LOG_OVERFLOW_DROP_OLDEST,//Default, the oldest buffered message is discarded
+    ADAL_LOG_OVERFLOW_DROP_NEWEST,//The new message is discarded
+} ADAL_LOG_OVERFLOW_POLICY;
+
 @interface ADALLogger : NSObject
 
 /*!
@@ -103,5 +110,36 @@ typedef void (^ADLoggerCallback)(ADAL_LOG_LEVEL logLevel,
  */
 + (BOOL)getNSLogging;
 
+/*!
+    Turns on or off asynchronous delivery to the logger callback. Off by default, in which case
+    the callback runs on the thread that logged the message before ADAL continues.
+ 
+    When on, messages are put in a bounded buffer and delivered in order on a background queue,
+    so a slow callback doesn't hold up token requests. If the buffer fills up messages are
+    dropped according to the overflow policy, and a warning with the number of dropped messages
+    is delivered once there is room again. Turning it off flushes the buffer.
+ */
++ (void)setAsynchronousLogging:(BOOL)asynchronous;
+
+/*! @return Whether log messages are delivered to the callback asynchronously */
++ (BOOL)getAsynchronousLogging;
+
+/*! Sets which message is discarded when the asynchronous logging buffer is full */
++ (void)setLogOverflowPolicy:(ADAL_LOG_OVERFLOW_POLICY)policy;
+
+/*! @return the current overflow policy */
++ (ADAL_LOG_OVERFLOW_POLICY)getLogOverflowPolicy;
+
+/*! @return the number of messages asynchronous logging has dropped since the app started */
++ (NSUInteger)getDroppedLogCount;
+
+/*!
+    Delivers every buffered message to the callback before returning, on the calling thread.
+    Meant for crash handlers and other places that are about to lose the background queue.
+    Messages it delivers may interleave with the ones the background queue is delivering at the same time.
+    Does nothing when asynchronous logging is off.
+ */
++ (void)flush;
+
 @end
 
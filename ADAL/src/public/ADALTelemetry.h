@@ -36,8 +36,26 @@
  */
 - (void)dispatchEvent:(nonnull NSDictionary<NSString*, NSString*> *)event;
 
+@optional
+
+/*!
+    Callback function that will be called instead of dispatchEvent: for dispatchers registered with
+    dispatchAsynchronously set to YES. It is called on a background queue with a batch of events.
+    @param  events       The events in the order they were flushed.
+ */
+- (void)dispatchEvents:(nonnull NSArray<NSDictionary<NSString*, NSString*> *> *)events;
+
 @end
 
+/*!
+    Receives the trace of one acquire token call.
+    @param  requestId    The telemetry request ID of the call.
+    @param  traceJSON    A trace event format JSON object, with one complete ("X") event per phase of the call.
+                         Timestamps and durations are in microseconds of a monotonic clock, and each event's args
+                         carry its span_id and the parent_id of the phase it is nested in.
+ */
+typedef void (^ADALTraceCallback)(NSString * _Nonnull requestId, NSData * _Nonnull traceJSON);
+
 /*!
     @class ADALTelemetry
  
@@ -67,6 +85,21 @@ Setting piiEnabled to YES, will allow ADAL to return fields with user informatio
 - (void)addDispatcher:(nonnull id<ADDispatcher>)dispatcher
   aggregationRequired:(BOOL)aggregationRequired;
 
+/*!
+    Register a telemetry dispatcher for receiving telemetry events.
+    @param dispatcher               An instance of ADDispatcher implementation.
+    @param aggregationRequired      See addDispatcher:aggregationRequired:.
+    @param dispatchAsynchronously   If set YES, events are queued and delivered to the dispatcher in batches on a
+                                        low priority background queue, so a slow dispatcher doesn't delay token requests.
+                                        Events are delivered once 20 are pending or 2 seconds after the first one.
+                                        If more than 500 events are pending, the oldest ones are dropped.
+                                        Pending events are delivered right away when the dispatcher is removed, when
+                                        the app terminates, or when flushPendingEvents is called.
+ */
+- (void)addDispatcher:(nonnull id<ADDispatcher>)dispatcher
+  aggregationRequired:(BOOL)aggregationRequired
+dispatchAsynchronously:(BOOL)dispatchAsynchronously;
+
 /*!
  Remove a telemetry dispatcher added for receiving telemetry events.
  @param dispatcher            An instance of ADDispatcher implementation added to the dispatches before.
@@ -78,4 +111,89 @@ Setting piiEnabled to YES, will allow ADAL to return fields with user informatio
  */
 - (void)removeAllDispatchers;
 
+/*!
+ Deliver the events queued by dispatchers added with dispatchAsynchronously set to YES, without waiting for their
+ batch to fill, and return once they are delivered. Call it before the app suspends or exits on its own.
+ */
+- (void)flushPendingEvents;
+
+/*!
+ If set, every acquire token call records its phases (API call, authority validation, silent acquire, token grants,
+ HTTP requests and broker round trips) as nested spans, and the callback receives them as trace event JSON on a
+ background queue when the call completes. The JSON loads directly in chrome://tracing or Perfetto. nil by default,
+ which records nothing.
+ */
+@property (nonatomic, copy, nullable) ADALTraceCallback traceCallback;
+
+/*!
+ Latency histograms collected since launch or the last reset, keyed by <phase>.<api id>.<status>.
+ Phases are acquire_token, authority_validation, cache_lookup, grant_refresh_token, grant_mrrt, grant_frt,
+ grant_authorization_code, http and broker. The status is the result of the phase, or for cache_lookup of the
+ silent call it was part of: succeeded, failed or cancelled. http statuses are the response class (2xx, 4xx...)
+ or error. Each histogram has count, min_us, max_us, mean_us, p50_us, p90_us and p99_us, in microseconds.
+ Percentiles are accurate to about 6%.
+ */
+- (nonnull NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *)latencyStatistics;
+
+/*!
+ Clears all latency histograms.
+ */
+- (void)resetLatencyStatistics;
+
+/*!
+ Fraction of acquire token calls, between 0.0 and 1.0, whose telemetry events are collected. 1.0 by default.
+ The decision is made once per call from the telemetry request ID, so a call is either sampled for all its events
+ or for none. ADAL skips building the events of calls that aren't sampled, dispatchers drop the events other
+ components report for them, and aggregating dispatchers send no aggregate for them.
+ */
+@property (nonatomic) double samplingRate;
+
+/*!
+ Overrides samplingRate for one event type.
+ @param samplingRate    Fraction of calls to collect this event for, or a negative value to use samplingRate again.
+ @param eventName       The event name, as reported in the event_name property of the event.
+ */
+- (void)setSamplingRate:(double)samplingRate forEventName:(nonnull NSString *)eventName;
+
+/*!
+ If set YES, events of failed operations are collected even for calls that aren't sampled. YES by default.
+ */
+@property (nonatomic) BOOL samplingKeepsFailures;
+
+/*!
+ Number of acquire token calls whose telemetry is being held by aggregating dispatchers until the call completes.
+ */
+@property (nonatomic, readonly) NSUInteger pendingAggregatedRequestCount;
+
+/*!
+ Number of acquire token calls whose aggregated telemetry was dropped because the call never completed.
+ An aggregating dispatcher drops an unfinished call once it is more than 10 minutes old, checked at least once a
+ minute while calls complete or start, and drops its oldest unfinished call when more than 256 are pending.
+ */
+@property (nonatomic, readonly) NSUInteger evictedAggregatedRequestCount;
+
+/*!
+ Number of telemetry events left out of aggregated telemetry because their acquire token call already had 512 events.
+ */
+@property (nonatomic, readonly) NSUInteger droppedAggregatedEventCount;
+
+/*!
+ Token cache counters and latency histograms collected since launch or the last reset: silent
+ requests served by an access token, refresh token, MRRT or FRT, cache misses, cache reads and
+ writes, item count and serialization times. Each latency histogram has <name>_count, <name>_min_us,
+ <name>_max_us, <name>_mean_us, <name>_p50_us, <name>_p90_us and <name>_p99_us entries.
+ */
+- (nonnull NSDictionary<NSString *, NSNumber *> *)cacheStatistics;
+
+/*!
+ Resets all token cache counters and histograms to zero.
+ */
+- (void)resetCacheStatistics;
+
+/*!
+ If set YES, silent acquire token events dispatched to the telemetry dispatchers carry which cache
+ item served the request and how long the cache lookup took. NO by default.
+ */
+@property (nonatomic) BOOL cacheStatisticsEventsEnabled;
+
 @end
@@ -106,4 +106,18 @@
 - (BOOL)wipeAllItemsForUserId:(NSString * __nonnull)userId
                         error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
 
+/* Removes access tokens without a refresh token that are expired beyond their extended lifetime,
+   and orphaned entries that don't hold any token. removedCount is optional and reports how many
+   items were removed. removedBytes is optional and reports the total size of the removed
+   keychain items' data.
+ */
+- (BOOL)removeExpiredItems:(nullable NSUInteger *)removedCount
+              removedBytes:(nullable NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Runs removeExpiredItems:removedBytes:error: on a background queue every interval seconds.
+   Pass 0 to stop the periodic sweep.
+ */
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval;
+
 @end
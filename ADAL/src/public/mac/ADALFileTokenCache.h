@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class ADALTokenCacheItem;
+@class ADALAuthenticationError;
+
+/*!
+    A token cache persisted by ADAL in a file that can be shared between processes.
+    Unlike ADALTokenCache it doesn't need an ADALTokenCacheDelegate, items are read from
+    and written to the file individually and access is coordinated with file locks.
+ */
+@interface ADALFileTokenCache : NSObject
+
+@property (readonly) NSString * __nonnull path;
+
+/*! Initializes the token cache store.
+ @param path The file to keep the cache in, it is created if it doesn't exist. The directory
+ must already exist. Processes sharing tokens should use the same path.
+ */
+- (nonnull instancetype)initWithPath:(nonnull NSString *)path;
+
+/*! Return a copy of all items. The array will contain ADALTokenCacheItem objects,
+ containing all of the cached information. Returns an empty array, if no items are found.
+ Returns nil in case of error. */
+- (nullable NSArray<ADALTokenCacheItem *> *)allItems:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Removes a token cache item from the file */
+- (BOOL)removeItem:(nonnull ADALTokenCacheItem *)item
+             error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Removes all token cache items for a specific client from the file.
+ */
+- (BOOL)removeAllForClientId:(NSString * __nonnull)clientId
+                       error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Removes all token cache items for a specific user and a specific clientId from the file
+ */
+- (BOOL)removeAllForUserId:(NSString * __nonnull)userId
+                  clientId:(NSString * __nonnull)clientId
+                     error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Removes all token cache items for a specific user and all clients
+ */
+- (BOOL)wipeAllItemsForUserId:(NSString * __nonnull)userId
+                        error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Removes access tokens without a refresh token that are expired beyond their extended lifetime,
+   and orphaned entries that don't hold any token. removedCount is optional and reports how many
+   items were removed. removedBytes is optional and reports the total size of the removed records
+   in the cache file.
+ */
+- (BOOL)removeExpiredItems:(nullable NSUInteger *)removedCount
+              removedBytes:(nullable NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Runs removeExpiredItems:removedBytes:error: on a background queue every interval seconds.
+   Pass 0 to stop the periodic sweep.
+ */
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval;
+
+/* Rewrites the file without the space left behind by updated and removed items. This also
+   happens automatically once that space takes up more than half of the file.
+ */
+- (BOOL)compact:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+@end
@@ -37,6 +37,15 @@
 - (void)willWriteCache:(nonnull ADALTokenCache *)cache;
 - (void)didWriteCache:(nonnull ADALTokenCache *)cache;
 
+@optional
+
+/* Returns a monotonic change stamp of the persisted cache that is cheap to read, e.g. from a small
+   file header or shared memory, and that is incremented by every process that writes the cache.
+   When implemented, willAccessCache:/didAccessCache: are skipped while the generation is the same
+   as the one last loaded or written by this ADALTokenCache.
+ */
+- (uint64_t)generationOfCache:(nonnull ADALTokenCache *)cache;
+
 @end
 
 @interface ADALTokenCache : NSObject
@@ -50,6 +59,10 @@
 
 - (void)setDelegate:(nullable id<ADALTokenCacheDelegate>)delegate;
 
+/*! Returns the encoded cache contents. As long as the cache doesn't change, repeated calls return
+    the data of the last encoding without encoding again. Any write invalidates it, so the first
+    serialize after a write, typically the one made from didWriteCache:, always encodes the cache.
+ */
 - (nullable NSData *)serialize;
 - (BOOL)deserialize:(nullable NSData*)data
               error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
@@ -74,4 +87,26 @@
 - (BOOL)wipeAllItemsForUserId:(NSString * __nonnull)userId
                         error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
 
+/* Removes access tokens without a refresh token that are expired beyond their extended lifetime,
+   and orphaned entries that don't hold any token. removedCount is optional and reports how many
+   items were removed. removedBytes is optional and reports how much smaller the serialized
+   cache became.
+ */
+- (BOOL)removeExpiredItems:(nullable NSUInteger *)removedCount
+              removedBytes:(nullable NSUInteger *)removedBytes
+                     error:(ADALAuthenticationError * __nullable __autoreleasing * __nullable)error;
+
+/* Runs removeExpiredItems:removedBytes:error: on a background queue every interval seconds.
+   Pass 0 to stop the periodic sweep.
+ */
+- (void)setExpiredItemsSweepInterval:(NSTimeInterval)interval;
+
+/* When enabled, willAccessCache:/didAccessCache: are only sent to the delegate until the cache
+   has been loaded once, subsequent reads are served from memory. Writes are still reported to the
+   delegate as usual. Call invalidateReadLease when the persisted cache was changed outside of
+   this ADALTokenCache (e.g. by another process) so the delegate is asked to load it again.
+ */
+- (void)setReadLeaseEnabled:(BOOL)enabled;
+- (void)invalidateReadLease;
+
 @end
@@ -23,6 +23,7 @@
 
 
 #import <Foundation/Foundation.h>
+#import "ADALTokenCacheDataSource.h"
 
 @class MSIDLegacySingleResourceToken;
 @class MSIDRefreshToken;
@@ -30,6 +31,13 @@
 @protocol MSIDRefreshableToken;
 @class MSIDLegacyTokenCacheAccessor;
 
+// Values of cacheLookupSource
+#define ADAL_CACHE_LOOKUP_SOURCE_ACCESS_TOKEN   @"access_token"
+#define ADAL_CACHE_LOOKUP_SOURCE_REFRESH_TOKEN  @"refresh_token"
+#define ADAL_CACHE_LOOKUP_SOURCE_MRRT           @"mrrt"
+#define ADAL_CACHE_LOOKUP_SOURCE_FRT            @"frt"
+#define ADAL_CACHE_LOOKUP_SOURCE_NONE           @"none"
+
 @interface ADALAcquireTokenSilentHandler : NSObject
 {
     ADALRequestParameters *_requestParams;
@@ -43,13 +51,22 @@
     ADALAuthenticationResult *_mrrtResult;
     
     BOOL _attemptedFRT;
+    // Set once an MRRT grant was sent, it may have rotated the FRT the lookup plan read
+    BOOL _attemptedMRRTGrant;
     
     // Verify userId being returned is same as one asked
     BOOL _verifyUserId;
 }
 
+// Which cache item served the request, nil if the item found could not be used. Set when getToken completes.
+@property (readonly) NSString *cacheLookupSource;
+// Time spent looking up the cache in microseconds
+@property (readonly) uint64_t cacheLookupDuration;
+
 + (ADALAcquireTokenSilentHandler *)requestWithParams:(ADALRequestParameters *)requestParams
                                         tokenCache:(MSIDLegacyTokenCacheAccessor *)tokenCache
+                                     writeBatching:(id<ADALTokenCacheWriteBatching>)writeBatching
+                                        lookupPass:(id<ADALTokenCacheLookupPass>)lookupPass
                                       verifyUserId:(BOOL)verifyUserId;
 
 - (void)getToken:(ADAuthenticationCallback)completionBlock;
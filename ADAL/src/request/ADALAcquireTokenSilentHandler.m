@@ -51,12 +51,24 @@
 #import "NSData+MSIDExtensions.h"
 #import "MSIDClientCapabilitiesUtil.h"
 #import "MSIDConfiguration.h"
+#import "ADALSilentLookupPlan.h"
+#import "ADALNegativeLookupCache.h"
+#import "ADALCacheStatistics.h"
+#import "ADALTelemetrySampler.h"
+#import "ADALLatencyStatistics.h"
+#import "ADALHistogram.h"
+#import "ADALTrace.h"
 
 @interface ADALAcquireTokenSilentHandler()
 
 @property (nonatomic) MSIDLegacyTokenCacheAccessor *tokenCache;
+@property (nonatomic) id<ADALTokenCacheWriteBatching> writeBatching;
+@property (nonatomic) id<ADALTokenCacheLookupPass> lookupPass;
 @property (nonatomic) MSIDAADV1Oauth2Factory *factory;
 @property (nonatomic) MSIDConfiguration *configuration;
+@property (nonatomic) ADALSilentLookupPlan *lookupPlan;
+@property (nonatomic) NSString *cacheLookupSource;
+@property (nonatomic) uint64_t cacheLookupDuration;
 
 @end
 
@@ -64,6 +76,8 @@
 
 + (ADALAcquireTokenSilentHandler *)requestWithParams:(ADALRequestParameters *)requestParams
                                         tokenCache:(MSIDLegacyTokenCacheAccessor *)tokenCache
+                                     writeBatching:(id<ADALTokenCacheWriteBatching>)writeBatching
+                                        lookupPass:(id<ADALTokenCacheLookupPass>)lookupPass
                                       verifyUserId:(BOOL)verifyUserId
 {
     ADALAcquireTokenSilentHandler* handler = [ADALAcquireTokenSilentHandler new];
@@ -73,6 +87,8 @@
     
     handler->_requestParams = requestParams;
     handler.tokenCache = tokenCache;
+    handler.writeBatching = writeBatching;
+    handler.lookupPass = lookupPass;
     handler.factory = [MSIDAADV1Oauth2Factory new];
     handler->_verifyUserId = verifyUserId;
     
@@ -100,6 +116,7 @@
                                              multiResourceRefreshToken:NO
                                                          correlationId:[_requestParams correlationId]];
              [result setExtendedLifeTimeToken:YES];
+             self.cacheLookupSource = ADAL_CACHE_LOOKUP_SOURCE_ACCESS_TOKEN;
          }
          
          completionBlock(result);
@@ -116,11 +133,14 @@
                   useOpenidConnect:(BOOL)useOpenidConnect
                    completionBlock:(ADAuthenticationCallback)completionBlock
 {
-    [[MSIDLogger sharedLogger] logToken:refreshToken
-                              tokenType:@"RT"
-                          expiresOnDate:nil
-                           additionaLog:[NSString stringWithFormat:@"Attempting to acquire for %@ using", _requestParams.resource]
-                                context:_requestParams];
+    if (ADAL_LOG_ENABLED(MSIDLogLevelInfo))
+    {
+        [[MSIDLogger sharedLogger] logToken:refreshToken
+                                  tokenType:@"RT"
+                              expiresOnDate:nil
+                               additionaLog:[NSString stringWithFormat:@"Attempting to acquire for %@ using", _requestParams.resource]
+                                    context:_requestParams];
+    }
     //Fill the data for the token refreshing:
     NSMutableDictionary *request_data = nil;
 
@@ -197,6 +217,7 @@
          ADALAuthenticationResult *result = [ADALResponseCacheHandler processAndCacheResponse:tokenResponse
                                                                          fromRefreshToken:cacheItem
                                                                                     cache:self.tokenCache
+                                                                            writeBatching:self.writeBatching
                                                                                    params:_requestParams
                                                                             configuration:_requestParams.msidConfig
                                                                              verifyUserId:_verifyUserId];
@@ -244,45 +265,62 @@
              completionBlock:(ADAuthenticationCallback)completionBlock
                     fallback:(ADAuthenticationCallback)fallback
 {
-    [[MSIDTelemetry sharedInstance] startEvent:[_requestParams telemetryRequestId] eventName:MSID_TELEMETRY_EVENT_TOKEN_GRANT];
+    BOOL telemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_TOKEN_GRANT requestId:[_requestParams telemetryRequestId]];
+    if (telemetryStarted)
+    {
+        [[MSIDTelemetry sharedInstance] startEvent:[_requestParams telemetryRequestId] eventName:MSID_TELEMETRY_EVENT_TOKEN_GRANT];
+    }
+    uint64_t grantStart = [ADALHistogram now];
+    ADALTraceSpanId grantSpan = [ADALTrace beginSpan:MSID_TELEMETRY_EVENT_TOKEN_GRANT requestId:[_requestParams telemetryRequestId]];
     [self acquireTokenByRefreshToken:refreshToken.refreshToken
                            cacheItem:refreshToken
                     useOpenidConnect:useOpenidConnect
                      completionBlock:^(ADALAuthenticationResult *result)
      {
-         ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_TOKEN_GRANT
-                                                                        context:_requestParams];
-         [event setGrantType:MSID_TELEMETRY_VALUE_BY_REFRESH_TOKEN];
-         [event setResultStatus:[result status]];
-         [[MSIDTelemetry sharedInstance] stopEvent:[_requestParams telemetryRequestId] event:event];
-
-         NSString* resultStatus = @"Succeded";
+         [self recordGrantWithRefreshType:refreshType result:result start:grantStart];
+         [ADALTrace endSpan:grantSpan requestId:[_requestParams telemetryRequestId] status:[ADALLatencyStatistics statusForResult:result]];
          
-         if (result.status == AD_FAILED)
+         if (telemetryStarted && [ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_TOKEN_GRANT
+                                                                      requestId:[_requestParams telemetryRequestId]
+                                                                         failed:result.status != AD_SUCCEEDED])
+         {
+             ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_TOKEN_GRANT
+                                                                            context:_requestParams];
+             [event setGrantType:MSID_TELEMETRY_VALUE_BY_REFRESH_TOKEN];
+             [event setResultStatus:[result status]];
+             [[MSIDTelemetry sharedInstance] stopEvent:[_requestParams telemetryRequestId] event:event];
+         }
+
+         if (ADAL_LOG_ENABLED(MSIDLogLevelInfo))
          {
-             if (result.error.protocolCode)
+             NSString* resultStatus = @"Succeded";
+         
+             if (result.status == AD_FAILED)
              {
-                 resultStatus = [NSString stringWithFormat:@"Failed (%@)", result.error.protocolCode];
+                 if (result.error.protocolCode)
+                 {
+                     resultStatus = [NSString stringWithFormat:@"Failed (%@)", result.error.protocolCode];
+                 }
+                 else
+                 {
+                     resultStatus = [NSString stringWithFormat:@"Failed (%@ %ld)", result.error.domain, (long)result.error.code];
+                 }
+             }
+         
+             NSString* msg = nil;
+             if (refreshType)
+             {
+                 msg = [NSString stringWithFormat:@"Acquire Token with %@ Refresh Token %@.", refreshType, resultStatus];
              }
              else
              {
-                 resultStatus = [NSString stringWithFormat:@"Failed (%@ %ld)", result.error.domain, (long)result.error.code];
+                 msg = [NSString stringWithFormat:@"Acquire Token with Refresh Token %@.", resultStatus];
              }
-         }
          
-         NSString* msg = nil;
-         if (refreshType)
-         {
-             msg = [NSString stringWithFormat:@"Acquire Token with %@ Refresh Token %@.", refreshType, resultStatus];
-         }
-         else
-         {
-             msg = [NSString stringWithFormat:@"Acquire Token with Refresh Token %@.", resultStatus];
+             MSID_LOG_INFO(_requestParams, @"%@", msg);
+             MSID_LOG_INFO_PII(_requestParams, @"%@ clientId: '%@', resource: '%@'", msg, _requestParams.clientId, _requestParams.resource);
          }
          
-         MSID_LOG_INFO(_requestParams, @"%@", msg);
-         MSID_LOG_INFO_PII(_requestParams, @"%@ clientId: '%@', resource: '%@'", msg, _requestParams.clientId, _requestParams.resource);
-         
          if ([ADALAuthenticationContext isFinalResult:result])
          {
              completionBlock(result);
@@ -307,66 +345,66 @@
 
     NSError *msidError = nil;
     
-    MSIDConfiguration *configuration = _requestParams.msidConfig;
-
-    MSIDLegacySingleResourceToken *item = [self.tokenCache getSingleResourceTokenForAccount:_requestParams.account
-                                                                              configuration:configuration
-                                                                                    context:_requestParams
-                                                                                      error:&msidError];
+    ADALNegativeLookupCache *negativeLookupCache = [ADALNegativeLookupCache sharedCache];
+    
+    // Nothing usable was in the cache a moment ago and nothing has been written for the user since
+    if ([negativeLookupCache containsMissForParams:_requestParams tokenCache:self.tokenCache])
+    {
+        MSID_LOG_VERBOSE(_requestParams, @"No usable token in cache (remembered miss)");
+        [ADALCacheStatistics increment:ADALCacheCounterSilentRememberedMiss];
+        self.cacheLookupSource = ADAL_CACHE_LOOKUP_SOURCE_NONE;
+        completionBlock(nil);
+        return;
+    }
+    
+    uint64_t writeGeneration = negativeLookupCache.writeGeneration;
+    uint64_t lookupStart = [ADALHistogram now];
+    
+    self.lookupPlan = [ADALSilentLookupPlan planWithParams:_requestParams
+                                                tokenCache:self.tokenCache
+                                                lookupPass:self.lookupPass
+                                                     error:&msidError];
+    
+    self.cacheLookupDuration = ([ADALHistogram now] - lookupStart) / NSEC_PER_USEC;
     
     // If some error ocurred during the cache lookup then we need to fail out right away.
-    if (msidError)
+    if (!self.lookupPlan)
     {
         completionBlock([ADALAuthenticationResult resultFromMSIDError:msidError correlationId:correlationId]);
         return;
     }
-
-    // If we didn't find an item at all there's a chance that we might be dealing with an "ADFS" user
-    // and we need to check the unknown user ADFS token as well
-    if (!item)
+    
+    if (self.lookupPlan.isMiss)
     {
-        MSIDAccountIdentifier *account = [[MSIDAccountIdentifier alloc] initWithLegacyAccountId:@"" homeAccountId:nil];
-
-        item = [self.tokenCache getSingleResourceTokenForAccount:account
-                                                   configuration:configuration
-                                                         context:_requestParams
-                                                           error:&msidError];
-        
-        if (msidError)
-        {
-            completionBlock([ADALAuthenticationResult resultFromMSIDError:msidError correlationId:correlationId]);
-            return;
-        }
-
-        // If we still don't have anything from the cache to use then we should try to see if we have an MRRT
-        // that matches.
-        if (!item)
-        {
-            [self tryMRRT:completionBlock];
-            return;
-        }
+        [ADALCacheStatistics increment:ADALCacheCounterSilentMiss];
+        self.cacheLookupSource = ADAL_CACHE_LOOKUP_SOURCE_NONE;
+        [negativeLookupCache addMissForParams:_requestParams tokenCache:self.tokenCache writeGeneration:writeGeneration];
     }
     
-    BOOL enrollmentIdMatch = YES;
+    MSIDLegacySingleResourceToken *item = self.lookupPlan.accessTokenItem;
     
-    // If token is scoped down to a particular enrollmentId and app is capable for True MAM CA, verify that enrollmentIds match
-    // EnrollmentID matching is done on the request layer to ensure that expired access tokens get removed even if valid enrollmentId is not presented
-    if ([_requestParams isCapableForMAMCA] && ![NSString msidIsStringNilOrBlank:item.enrollmentId])
+    // If we don't have anything from the cache to use then we should try to see if we have an MRRT
+    // that matches.
+    if (!item)
     {
-        enrollmentIdMatch = configuration.enrollmentId && [configuration.enrollmentId isEqualToString:item.enrollmentId];
+        [self tryMRRT:completionBlock];
+        return;
     }
-
+    
     // If we have a good (non-expired) access token then return it right away
-    if (item.accessToken
-        && ![item isExpiredWithExpiryBuffer:[ADALAuthenticationSettings sharedInstance].expirationBuffer]
-        && !_requestParams.forceRefresh
-        && enrollmentIdMatch)
+    if (self.lookupPlan.accessTokenValid)
     {
-        [[MSIDLogger sharedLogger] logToken:item.accessToken
-                                  tokenType:@"AT"
-                              expiresOnDate:item.expiresOn
-                               additionaLog:@"Returning"
-                                    context:_requestParams];
+        [ADALCacheStatistics increment:ADALCacheCounterSilentAccessTokenHit];
+        self.cacheLookupSource = ADAL_CACHE_LOOKUP_SOURCE_ACCESS_TOKEN;
+        
+        if (ADAL_LOG_ENABLED(MSIDLogLevelInfo))
+        {
+            [[MSIDLogger sharedLogger] logToken:item.accessToken
+                                      tokenType:@"AT"
+                                  expiresOnDate:item.expiresOn
+                                   additionaLog:@"Returning"
+                                        context:_requestParams];
+        }
         
         ADALTokenCacheItem *adItem = [[ADALTokenCacheItem alloc] initWithLegacySingleResourceToken:item];
         
@@ -382,7 +420,7 @@
     if (item.accessToken
         && item.isExtendedLifetimeValid
         && !_requestParams.forceRefresh
-        && enrollmentIdMatch)
+        && self.lookupPlan.enrollmentIdMatch)
     {
         _extendedLifetimeAccessTokenItem = item;
     }
@@ -439,22 +477,14 @@
  */
 - (void)tryMRRT:(ADAuthenticationCallback)completionBlock
 {
-    // If we don't have an item yet see if we can pull one out of the cache
+    // If we don't have an item yet take the one the lookup plan found in the cache
     if (!_mrrtItem)
     {
-        NSError *msidError = nil;
-
-        MSIDRefreshToken *refreshToken = [self.tokenCache getRefreshTokenWithAccount:_requestParams.account
-                                                                            familyId:nil
-                                                                       configuration:_requestParams.msidConfig
-                                                                             context:_requestParams
-                                                                               error:&msidError];
+        _mrrtItem = self.lookupPlan.mrrtItem;
         
-        _mrrtItem = refreshToken;
-        
-        if (!_mrrtItem && msidError)
+        if (!_mrrtItem && self.lookupPlan.mrrtError)
         {
-            completionBlock([ADALAuthenticationResult resultFromMSIDError:msidError correlationId:[_requestParams correlationId]]);
+            completionBlock([ADALAuthenticationResult resultFromMSIDError:self.lookupPlan.mrrtError correlationId:[_requestParams correlationId]]);
             return;
         }
     }
@@ -475,6 +505,7 @@
     }
 
     // Otherwise try the MRRT
+    _attemptedMRRTGrant = YES;
     [self acquireTokenWithItem:_mrrtItem
                    refreshType:@"Multi Resource"
               useOpenidConnect:YES
@@ -514,11 +545,23 @@
         familyId = @"1";
     }
 
-    MSIDRefreshToken *refreshToken = [self.tokenCache getRefreshTokenWithAccount:_requestParams.account
-                                                                        familyId:familyId
-                                                                   configuration:_requestParams.msidConfig
-                                                                         context:_requestParams
-                                                                           error:&msidError];
+    MSIDRefreshToken *refreshToken = nil;
+    
+    if (!_attemptedMRRTGrant && [familyId isEqualToString:self.lookupPlan.frtFamilyId])
+    {
+        // Nothing was redeemed since the lookup plan read the FRT
+        refreshToken = self.lookupPlan.frtItem;
+        msidError = self.lookupPlan.frtError;
+    }
+    else
+    {
+        // Redeeming the MRRT may have rotated the FRT
+        refreshToken = [self.tokenCache getRefreshTokenWithAccount:_requestParams.account
+                                                          familyId:familyId
+                                                     configuration:_requestParams.msidConfig
+                                                           context:_requestParams
+                                                             error:&msidError];
+    }
     
     if (!refreshToken && msidError)
     {
@@ -560,6 +603,39 @@
      }];
 }
 
+- (void)recordGrantWithRefreshType:(NSString *)refreshType
+                            result:(ADALAuthenticationResult *)result
+                             start:(uint64_t)start
+{
+    ADALCacheCounter counter = ADALCacheCounterSilentRefreshTokenGrant;
+    NSString *source = ADAL_CACHE_LOOKUP_SOURCE_REFRESH_TOKEN;
+    NSString *phase = ADAL_LATENCY_PHASE_GRANT_REFRESH_TOKEN;
+    
+    if ([refreshType isEqualToString:@"Multi Resource"])
+    {
+        counter = ADALCacheCounterSilentMRRTGrant;
+        source = ADAL_CACHE_LOOKUP_SOURCE_MRRT;
+        phase = ADAL_LATENCY_PHASE_GRANT_MRRT;
+    }
+    else if ([refreshType isEqualToString:@"Family"])
+    {
+        counter = ADALCacheCounterSilentFRTGrant;
+        source = ADAL_CACHE_LOOKUP_SOURCE_FRT;
+        phase = ADAL_LATENCY_PHASE_GRANT_FRT;
+    }
+    
+    [ADALCacheStatistics increment:counter];
+    [ADALLatencyStatistics recordPhase:phase
+                                 since:start
+                                 apiId:_requestParams.apiId
+                                status:[ADALLatencyStatistics statusForResult:result]];
+    
+    if (result.status == AD_SUCCEEDED)
+    {
+        self.cacheLookupSource = source;
+    }
+}
+
 - (BOOL)isServerUnavailable:(ADALAuthenticationResult *)result
 {
     if (![[result.error domain] isEqualToString:ADHTTPErrorCodeDomain])
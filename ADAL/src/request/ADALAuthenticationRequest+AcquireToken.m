@@ -28,6 +28,11 @@
 #import "ADALHelpers.h"
 #import "ADALUserIdentifier.h"
 #import "ADALAcquireTokenSilentHandler.h"
+#import "ADALCacheStatistics.h"
+#import "ADALTelemetrySampler.h"
+#import "ADALLatencyStatistics.h"
+#import "ADALHistogram.h"
+#import "ADALTrace.h"
 #import "ADALTelemetry.h"
 #import "MSIDTelemetry+Internal.h"
 #import "ADALTelemetryAPIEvent.h"
@@ -68,67 +73,101 @@
      completionBlock:(ADAuthenticationCallback)completionBlock
 {
     THROW_ON_NIL_ARGUMENT(completionBlock);
-    [[MSIDTelemetry sharedInstance] startEvent:self.telemetryRequestId
-                                   eventName:MSID_TELEMETRY_EVENT_API_EVENT];
+    uint64_t acquireTokenStart = [ADALHistogram now];
+    ADALTraceSpanId apiSpan = [ADALTrace beginSpan:MSID_TELEMETRY_EVENT_API_EVENT requestId:self.telemetryRequestId];
+    _requestParams.apiId = apiId;
+    BOOL collecting = [ADALTelemetrySampler beginRequest:self.telemetryRequestId];
+    BOOL telemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_API_EVENT requestId:self.telemetryRequestId];
+    if (telemetryStarted)
+    {
+        [[MSIDTelemetry sharedInstance] startEvent:self.telemetryRequestId
+                                       eventName:MSID_TELEMETRY_EVENT_API_EVENT];
+    }
     
     AD_REQUEST_CHECK_ARGUMENT([_requestParams resource]);
     [self ensureRequest];
     NSString* telemetryRequestId = [_requestParams telemetryRequestId];
     
-    NSString *logMessage = [NSString stringWithFormat:@"%@ idtype = %@", _silent ? @"Silent" : @"", [_requestParams.identifier typeAsString]];
-    NSString *logMessagePII = [NSString stringWithFormat:@"resource = %@, clientId = %@, userId = %@", _requestParams.resource, _requestParams.clientId, _requestParams.identifier.userId];
-    
-    NSURL *authorityUrl = [NSURL URLWithString:_requestParams.authority];
-    
-    if ([ADALAuthorityUtils isKnownHost:authorityUrl]) {
-        logMessage = [NSString stringWithFormat:@"%@ authority host: %@", logMessage, authorityUrl.host];
-    } else {
-        logMessagePII = [NSString stringWithFormat:@"%@ authority: %@", logMessagePII, _requestParams.authority];
+    if (ADAL_LOG_ENABLED(MSIDLogLevelInfo))
+    {
+        NSString *logMessage = [self acquireTokenLogMessage];
+        MSID_LOG_INFO(_requestParams, @"##### BEGIN acquireToken %@ #####", logMessage);
+        if (ADAL_LOG_PII_ENABLED(MSIDLogLevelInfo))
+        {
+            MSID_LOG_INFO_PII(_requestParams, @"##### BEGIN acquireToken %@ %@#####", logMessage, [self acquireTokenLogMessagePII]);
+        }
     }
     
-    MSID_LOG_INFO(_requestParams, @"##### BEGIN acquireToken %@ #####", logMessage);
-    MSID_LOG_INFO_PII(_requestParams, @"##### BEGIN acquireToken %@ %@#####", logMessage, logMessagePII);
-    
     ADAuthenticationCallback wrappedCallback = ^void(ADALAuthenticationResult* result)
     {
-        if (result.status == AD_SUCCEEDED)
-        {
-            MSID_LOG_INFO(_requestParams, @"##### END succeeded. %@ #####", logMessage);
-            MSID_LOG_INFO_PII(_requestParams, @"##### END succeeded. %@ %@ #####", logMessage, logMessagePII);
-        }
-        else
+        [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_ACQUIRE_TOKEN
+                                     since:acquireTokenStart
+                                     apiId:apiId
+                                    status:[ADALLatencyStatistics statusForResult:result]];
+        [ADALTrace endSpan:apiSpan requestId:self.telemetryRequestId status:[ADALLatencyStatistics statusForResult:result]];
+        
+        if (ADAL_LOG_ENABLED(MSIDLogLevelInfo))
         {
-            ADALAuthenticationError* error = result.error;
-            MSID_LOG_INFO(_requestParams, @"##### END failed { domain: %@ code: %ld protocolCode: %@ %@ #####", error.domain, (long)error.code, error.protocolCode, logMessage);
-            MSID_LOG_INFO_PII(_requestParams, @"#### END failed { domain: %@ code: %ld protocolCode: %@ errorDetails: %@ %@ %@ #####", error.domain, (long)error.code, error.protocolCode, error.errorDetails, logMessage, logMessagePII);
+            NSString *logMessage = [self acquireTokenLogMessage];
+            BOOL logPII = ADAL_LOG_PII_ENABLED(MSIDLogLevelInfo);
+            
+            if (result.status == AD_SUCCEEDED)
+            {
+                MSID_LOG_INFO(_requestParams, @"##### END succeeded. %@ #####", logMessage);
+                if (logPII)
+                {
+                    MSID_LOG_INFO_PII(_requestParams, @"##### END succeeded. %@ %@ #####", logMessage, [self acquireTokenLogMessagePII]);
+                }
+            }
+            else
+            {
+                ADALAuthenticationError* error = result.error;
+                MSID_LOG_INFO(_requestParams, @"##### END failed { domain: %@ code: %ld protocolCode: %@ %@ #####", error.domain, (long)error.code, error.protocolCode, logMessage);
+                if (logPII)
+                {
+                    MSID_LOG_INFO_PII(_requestParams, @"#### END failed { domain: %@ code: %ld protocolCode: %@ errorDetails: %@ %@ %@ #####", error.domain, (long)error.code, error.protocolCode, error.errorDetails, logMessage, [self acquireTokenLogMessagePII]);
+                }
+            }
         }
 
-        ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_API_EVENT
-                                                                       context:self];
-        [event setApiId:apiId];
-        
-        [event setCorrelationId:self.correlationId];
-        [event setClientId:_requestParams.clientId];
-        [event setAuthority:_context.authority];
-        [event setExtendedExpiresOnSetting:[_requestParams extendedLifetime]? MSID_TELEMETRY_VALUE_YES:MSID_TELEMETRY_VALUE_NO];
-        [event setPromptBehavior:_promptBehavior];
-        if ([result tokenCacheItem])
+        if (telemetryStarted && [ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_API_EVENT
+                                                                     requestId:self.telemetryRequestId
+                                                                        failed:result.status != AD_SUCCEEDED])
         {
-            [event setUserInformation:result.tokenCacheItem.userInformation];
+            ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_API_EVENT
+                                                                           context:self];
+            [event setApiId:apiId];
+            
+            [event setCorrelationId:self.correlationId];
+            [event setClientId:_requestParams.clientId];
+            [event setAuthority:_context.authority];
+            [event setExtendedExpiresOnSetting:[_requestParams extendedLifetime]? MSID_TELEMETRY_VALUE_YES:MSID_TELEMETRY_VALUE_NO];
+            [event setPromptBehavior:_promptBehavior];
+            if ([result tokenCacheItem])
+            {
+                [event setUserInformation:result.tokenCacheItem.userInformation];
+            }
+            else
+            {
+                [event setUserId:_requestParams.identifier.userId];
+            }
+            [event setResultStatus:result.status];
+            [event setIsExtendedLifeTimeToken:[result extendedLifeTimeToken]? MSID_TELEMETRY_VALUE_YES:MSID_TELEMETRY_VALUE_NO];
+            [event setErrorCode:[result.error code]];
+            [event setErrorDomain:[result.error domain]];
+            [event setProtocolCode:[[result error] protocolCode]];
+            
+            [[MSIDTelemetry sharedInstance] stopEvent:self.telemetryRequestId event:event];
         }
-        else
+        //flush all events in the end of the acquireToken call, nothing was collected if no dispatcher was
+        //registered for the whole call. Dispatchers drop the events of a request that wasn't sampled, so
+        //aggregating dispatchers only send an aggregate if something of the request was kept
+        if (collecting || [ADALTelemetrySampler dispatchersRegistered])
         {
-            [event setUserId:_requestParams.identifier.userId];
+            [[MSIDTelemetry sharedInstance] flush:self.telemetryRequestId];
         }
-        [event setResultStatus:result.status];
-        [event setIsExtendedLifeTimeToken:[result extendedLifeTimeToken]? MSID_TELEMETRY_VALUE_YES:MSID_TELEMETRY_VALUE_NO];
-        [event setErrorCode:[result.error code]];
-        [event setErrorDomain:[result.error domain]];
-        [event setProtocolCode:[[result error] protocolCode]];
-        
-        [[MSIDTelemetry sharedInstance] stopEvent:self.telemetryRequestId event:event];
-        //flush all events in the end of the acquireToken call
-        [[MSIDTelemetry sharedInstance] flush:self.telemetryRequestId];
+        [ADALTelemetrySampler endRequest:self.telemetryRequestId];
+        [ADALTrace finishRequest:self.telemetryRequestId];
         
         completionBlock(result);
     };
@@ -185,18 +224,35 @@
         }
     }
     
-    [[MSIDTelemetry sharedInstance] startEvent:telemetryRequestId eventName:MSID_TELEMETRY_EVENT_AUTHORITY_VALIDATION];
+    BOOL validationTelemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_AUTHORITY_VALIDATION requestId:telemetryRequestId];
+    if (validationTelemetryStarted)
+    {
+        [[MSIDTelemetry sharedInstance] startEvent:telemetryRequestId eventName:MSID_TELEMETRY_EVENT_AUTHORITY_VALIDATION];
+    }
     
+    uint64_t authorityValidationStart = [ADALHistogram now];
+    ADALTraceSpanId authorityValidationSpan = [ADALTrace beginSpan:MSID_TELEMETRY_EVENT_AUTHORITY_VALIDATION requestId:telemetryRequestId];
     ADALAuthorityValidation* authorityValidation = [ADALAuthorityValidation sharedInstance];
     [authorityValidation checkAuthority:_requestParams
                       validateAuthority:_context.validateAuthority
                         completionBlock:^(BOOL validated, ADALAuthenticationError *error)
      {
-         ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_AUTHORITY_VALIDATION
-                                                                        context:_requestParams];
-         [event setAuthorityValidationStatus:validated ? MSID_TELEMETRY_VALUE_YES:MSID_TELEMETRY_VALUE_NO];
-         [event setAuthority:_context.authority];
-         [[MSIDTelemetry sharedInstance] stopEvent:telemetryRequestId event:event];
+         [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_AUTHORITY_VALIDATION
+                                      since:authorityValidationStart
+                                      apiId:apiId
+                                     status:error ? @"failed" : @"succeeded"];
+         [ADALTrace endSpan:authorityValidationSpan requestId:telemetryRequestId status:error ? @"failed" : @"succeeded"];
+         
+         if (validationTelemetryStarted && [ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_AUTHORITY_VALIDATION
+                                                                                requestId:telemetryRequestId
+                                                                                   failed:error != nil])
+         {
+             ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_AUTHORITY_VALIDATION
+                                                                            context:_requestParams];
+             [event setAuthorityValidationStatus:validated ? MSID_TELEMETRY_VALUE_YES:MSID_TELEMETRY_VALUE_NO];
+             [event setAuthority:_context.authority];
+             [[MSIDTelemetry sharedInstance] stopEvent:telemetryRequestId event:event];
+         }
          
          if (error)
          {
@@ -209,6 +265,30 @@
      }];    
 }
 
+// Only built when the BEGIN/END lines of acquireToken are actually logged
+- (NSString *)acquireTokenLogMessage
+{
+    NSString *logMessage = [NSString stringWithFormat:@"%@ idtype = %@", _silent ? @"Silent" : @"", [_requestParams.identifier typeAsString]];
+    NSURL *authorityUrl = [NSURL URLWithString:_requestParams.authority];
+    
+    if ([ADALAuthorityUtils isKnownHost:authorityUrl]) {
+        logMessage = [NSString stringWithFormat:@"%@ authority host: %@", logMessage, authorityUrl.host];
+    }
+    
+    return logMessage;
+}
+
+- (NSString *)acquireTokenLogMessagePII
+{
+    NSString *logMessagePII = [NSString stringWithFormat:@"resource = %@, clientId = %@, userId = %@", _requestParams.resource, _requestParams.clientId, _requestParams.identifier.userId];
+    
+    if (![ADALAuthorityUtils isKnownHost:[NSURL URLWithString:_requestParams.authority]]) {
+        logMessagePII = [NSString stringWithFormat:@"%@ authority: %@", logMessagePII, _requestParams.authority];
+    }
+    
+    return logMessagePII;
+}
+
 - (BOOL)checkExtraQueryParameters
 {
     if ([NSString msidIsStringNilOrBlank:_requestParams.extraQueryParameters])
@@ -283,16 +363,42 @@
 
 - (void)getAccessToken:(ADAuthenticationCallback)completionBlock
 {
-    [[MSIDTelemetry sharedInstance] startEvent:[self telemetryRequestId] eventName:MSID_TELEMETRY_EVENT_ACQUIRE_TOKEN_SILENT];
+    BOOL telemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_ACQUIRE_TOKEN_SILENT requestId:[self telemetryRequestId]];
+    if (telemetryStarted)
+    {
+        [[MSIDTelemetry sharedInstance] startEvent:[self telemetryRequestId] eventName:MSID_TELEMETRY_EVENT_ACQUIRE_TOKEN_SILENT];
+    }
+    ADALTraceSpanId silentSpan = [ADALTrace beginSpan:MSID_TELEMETRY_EVENT_ACQUIRE_TOKEN_SILENT requestId:[self telemetryRequestId]];
     ADALAcquireTokenSilentHandler *request = [ADALAcquireTokenSilentHandler requestWithParams:_requestParams
                                                                                tokenCache:self.tokenCache
+                                                                            writeBatching:self.tokenCacheWriteBatching
+                                                                               lookupPass:self.tokenCacheLookupPass
                                                                              verifyUserId:!_silent];
     
     [request getToken:^(ADALAuthenticationResult *result)
      {
-         ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_ACQUIRE_TOKEN_SILENT
-                                                                        context:_requestParams];
-         [[MSIDTelemetry sharedInstance] stopEvent:[self telemetryRequestId] event:event];
+         [ADALTrace endSpan:silentSpan requestId:[self telemetryRequestId] status:[ADALLatencyStatistics statusForResult:result]];
+         
+         if (request.cacheLookupSource)
+         {
+             [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_CACHE_LOOKUP
+                                   microseconds:request.cacheLookupDuration
+                                          apiId:_requestParams.apiId
+                                         status:[ADALLatencyStatistics statusForResult:result]];
+         }
+         
+         if (telemetryStarted && [ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_ACQUIRE_TOKEN_SILENT
+                                                                      requestId:[self telemetryRequestId]
+                                                                         failed:result.status != AD_SUCCEEDED])
+         {
+             ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_ACQUIRE_TOKEN_SILENT
+                                                                            context:_requestParams];
+             if ([ADALCacheStatistics eventsEnabled])
+             {
+                 [event setCacheLookupSource:request.cacheLookupSource durationInMicroseconds:request.cacheLookupDuration];
+             }
+             [[MSIDTelemetry sharedInstance] stopEvent:[self telemetryRequestId] event:event];
+         }
          completionBlock(result);
      }];
 }
@@ -309,6 +415,7 @@
             ADALAuthenticationResult *result = [ADALResponseCacheHandler processAndCacheResponse:response
                                                                             fromRefreshToken:nil
                                                                                        cache:self.tokenCache
+                                                                               writeBatching:self.tokenCacheWriteBatching
                                                                                       params:_requestParams
                                                                                configuration:_requestParams.msidConfig
                                                                                 verifyUserId:YES];
@@ -393,16 +500,33 @@
             return;
         }
         
-        [[MSIDTelemetry sharedInstance] startEvent:[self telemetryRequestId] eventName:MSID_TELEMETRY_EVENT_LAUNCH_BROKER];
+        BOOL telemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_LAUNCH_BROKER requestId:[self telemetryRequestId]];
+        if (telemetryStarted)
+        {
+            [[MSIDTelemetry sharedInstance] startEvent:[self telemetryRequestId] eventName:MSID_TELEMETRY_EVENT_LAUNCH_BROKER];
+        }
+        uint64_t brokerStart = [ADALHistogram now];
+        ADALTraceSpanId brokerSpan = [ADALTrace beginSpan:MSID_TELEMETRY_EVENT_LAUNCH_BROKER requestId:[self telemetryRequestId]];
         [ADALBrokerHelper invokeBroker:brokerURL completionHandler:^(ADALAuthenticationResult* result)
          {
-             ADALTelemetryBrokerEvent* event = [[ADALTelemetryBrokerEvent alloc] initWithName:MSID_TELEMETRY_EVENT_LAUNCH_BROKER
-                                                                                requestId:_requestParams.telemetryRequestId
-                                                                            correlationId:_requestParams.correlationId];
-             [event setResultStatus:[result status]];
-             [event setBrokerAppVersion:s_brokerAppVersion];
-             [event setBrokerProtocolVersion:s_brokerProtocolVersion];
-             [[MSIDTelemetry sharedInstance] stopEvent:[self telemetryRequestId] event:event];
+             [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_BROKER
+                                          since:brokerStart
+                                          apiId:_requestParams.apiId
+                                         status:[ADALLatencyStatistics statusForResult:result]];
+             [ADALTrace endSpan:brokerSpan requestId:[self telemetryRequestId] status:[ADALLatencyStatistics statusForResult:result]];
+             
+             if (telemetryStarted && [ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_LAUNCH_BROKER
+                                                                          requestId:[self telemetryRequestId]
+                                                                             failed:result.status != AD_SUCCEEDED])
+             {
+                 ADALTelemetryBrokerEvent* event = [[ADALTelemetryBrokerEvent alloc] initWithName:MSID_TELEMETRY_EVENT_LAUNCH_BROKER
+                                                                                    requestId:_requestParams.telemetryRequestId
+                                                                                correlationId:_requestParams.correlationId];
+                 [event setResultStatus:[result status]];
+                 [event setBrokerAppVersion:s_brokerAppVersion];
+                 [event setBrokerProtocolVersion:s_brokerProtocolVersion];
+                 [[MSIDTelemetry sharedInstance] stopEvent:[self telemetryRequestId] event:event];
+             }
 
 #if !AD_BROKER
              [ADALAuthenticationRequest releaseExclusionLock];
@@ -453,19 +577,27 @@
     NSString* telemetryRequestId = [_requestParams telemetryRequestId];
     
     // Get the code first:
-    [[MSIDTelemetry sharedInstance] startEvent:telemetryRequestId eventName:MSID_TELEMETRY_EVENT_AUTHORIZATION_CODE];
+    BOOL telemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_AUTHORIZATION_CODE requestId:telemetryRequestId];
+    if (telemetryStarted)
+    {
+        [[MSIDTelemetry sharedInstance] startEvent:telemetryRequestId eventName:MSID_TELEMETRY_EVENT_AUTHORIZATION_CODE];
+    }
     
     [self requestCode:^(MSIDWebviewResponse *response, ADALAuthenticationError *error) {
-        ADALTelemetryAPIEvent* event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_AUTHORIZATION_CODE
-                                                                       context:_requestParams];
+        // nil when the event wasn't started, the response handlers then record nothing
+        ADALTelemetryAPIEvent* event = nil;
+        if (telemetryStarted)
+        {
+            event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_AUTHORIZATION_CODE
+                                                        context:_requestParams];
+        }
         
         if (error)
         {
             ADALAuthenticationResult *result = (AD_ERROR_UI_USER_CANCEL == error.code) ? [ADALAuthenticationResult resultFromCancellation:_requestParams.correlationId]
             : [ADALAuthenticationResult resultFromError:error correlationId:_requestParams.correlationId];
             
-            [event setAPIStatus:(AD_ERROR_UI_USER_CANCEL == error.code) ? MSID_TELEMETRY_VALUE_CANCELLED:MSID_TELEMETRY_VALUE_FAILED];
-            [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+            [self stopAuthorizationCodeEvent:event apiStatus:(AD_ERROR_UI_USER_CANCEL == error.code) ? MSID_TELEMETRY_VALUE_CANCELLED:MSID_TELEMETRY_VALUE_FAILED failed:YES];
             completionBlock(result);
             return;
         }
@@ -483,14 +615,29 @@
        if (![self processOAuthResponse:response telemetryEvent:event completionHandler:completionBlock])
        {
            ADALAuthenticationResult *result = [ADALAuthenticationResult resultFromError:[ADALAuthenticationError unexpectedInternalError:@"Received invalid response" correlationId:_context.correlationId]];
-           [event setAPIStatus: MSID_TELEMETRY_VALUE_FAILED];
-           [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+           [self stopAuthorizationCodeEvent:event apiStatus:MSID_TELEMETRY_VALUE_FAILED failed:YES];
            
            completionBlock(result);
        }
     }];
 }
 
+// event is nil when the AUTHORIZATION_CODE event wasn't started
+- (void)stopAuthorizationCodeEvent:(ADALTelemetryAPIEvent *)event
+                         apiStatus:(NSString *)apiStatus
+                            failed:(BOOL)failed
+{
+    if (!event || ![ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_AUTHORIZATION_CODE
+                                                        requestId:_requestParams.telemetryRequestId
+                                                           failed:failed])
+    {
+        return;
+    }
+    
+    [event setAPIStatus:apiStatus];
+    [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+}
+
 // Generic OAuth2 Authorization Request, obtains a token from an authorization code.
 - (void)requestTokenByCode:(NSString *)code
            completionBlock:(MSIDTokenResponseCallback)completionBlock
@@ -551,6 +698,8 @@
 {
     ADALAcquireTokenSilentHandler *request = [ADALAcquireTokenSilentHandler requestWithParams:_requestParams
                                                                                tokenCache:self.tokenCache
+                                                                            writeBatching:self.tokenCacheWriteBatching
+                                                                               lookupPass:self.tokenCacheLookupPass
                                                                              verifyUserId:!_silent];
     
     // Construct a refresh token object to wrap up the refresh token provided by developer
@@ -581,8 +730,7 @@
         return NO;
     }
     
-    [event setAPIStatus:@"try to prompt to install broker"];
-    [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+    [self stopAuthorizationCodeEvent:event apiStatus:@"try to prompt to install broker" failed:NO];
     
     MSIDWebMSAuthResponse *authResponse = (MSIDWebMSAuthResponse *)response;
     
@@ -633,8 +781,7 @@
         
         ADALAuthenticationResult *result = [ADALAuthenticationResult resultFromError:error correlationId:_requestParams.correlationId];
         
-        [event setAPIStatus: MSID_TELEMETRY_VALUE_FAILED];
-        [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+        [self stopAuthorizationCodeEvent:event apiStatus:MSID_TELEMETRY_VALUE_FAILED failed:YES];
         
         completionHandler(result);
         return YES;
@@ -644,8 +791,7 @@
 #endif
     ADALAuthenticationResult *result = [ADALAuthenticationResult resultFromCancellation:_requestParams.correlationId];
     
-    [event setAPIStatus: MSID_TELEMETRY_VALUE_CANCELLED];
-    [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+    [self stopAuthorizationCodeEvent:event apiStatus:MSID_TELEMETRY_VALUE_CANCELLED failed:YES];
     
     completionHandler(result);
     return YES;
@@ -669,16 +815,37 @@
             [self setCloudInstanceHostname:((MSIDWebAADAuthResponse *)response).cloudHostName];
         }
         
-        [event setAPIStatus:MSID_TELEMETRY_VALUE_SUCCEEDED];
-        [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+        [self stopAuthorizationCodeEvent:event apiStatus:MSID_TELEMETRY_VALUE_SUCCEEDED failed:NO];
         
-        [[MSIDTelemetry sharedInstance] startEvent:_requestParams.telemetryRequestId eventName:MSID_TELEMETRY_EVENT_TOKEN_GRANT];
+        BOOL grantTelemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_TOKEN_GRANT requestId:_requestParams.telemetryRequestId];
+        if (grantTelemetryStarted)
+        {
+            [[MSIDTelemetry sharedInstance] startEvent:_requestParams.telemetryRequestId eventName:MSID_TELEMETRY_EVENT_TOKEN_GRANT];
+        }
         
+        uint64_t grantStart = [ADALHistogram now];
+        ADALTraceSpanId grantSpan = [ADALTrace beginSpan:MSID_TELEMETRY_EVENT_TOKEN_GRANT requestId:_requestParams.telemetryRequestId];
         [self requestTokenByCode:oauthResponse.authorizationCode
                  completionBlock:^(MSIDTokenResponse *tokenResponse, ADALAuthenticationError *error)
          {
              if (error)
              {
+                 [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_GRANT_AUTHORIZATION_CODE
+                                              since:grantStart
+                                              apiId:_requestParams.apiId
+                                             status:@"failed"];
+                 [ADALTrace endSpan:grantSpan requestId:_requestParams.telemetryRequestId status:@"failed"];
+                 
+                 if (grantTelemetryStarted && [ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_TOKEN_GRANT
+                                                                                   requestId:_requestParams.telemetryRequestId
+                                                                                      failed:YES])
+                 {
+                     ADALTelemetryAPIEvent *event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_TOKEN_GRANT
+                                                                                    context:_requestParams];
+                     [event setGrantType:MSID_TELEMETRY_VALUE_BY_CODE];
+                     [event setResultStatus:AD_FAILED];
+                     [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+                 }
                  completionHandler([ADALAuthenticationResult resultFromError:error correlationId:_requestParams.correlationId]);
                  return;
              }
@@ -686,17 +853,29 @@
              ADALAuthenticationResult *result = [ADALResponseCacheHandler processAndCacheResponse:tokenResponse
                                                                              fromRefreshToken:nil
                                                                                         cache:self.tokenCache
+                                                                                writeBatching:self.tokenCacheWriteBatching
                                                                                        params:_requestParams
                                                                                 configuration:_requestParams.msidConfig
                                                                                  verifyUserId:!_silent];
              
              [result setCloudAuthority:_cloudAuthority];
              
-             ADALTelemetryAPIEvent *event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_TOKEN_GRANT
-                                                                            context:_requestParams];
-             [event setGrantType:MSID_TELEMETRY_VALUE_BY_CODE];
-             [event setResultStatus:[result status]];
-             [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+             [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_GRANT_AUTHORIZATION_CODE
+                                          since:grantStart
+                                          apiId:_requestParams.apiId
+                                         status:[ADALLatencyStatistics statusForResult:result]];
+             [ADALTrace endSpan:grantSpan requestId:_requestParams.telemetryRequestId status:[ADALLatencyStatistics statusForResult:result]];
+             
+             if (grantTelemetryStarted && [ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_TOKEN_GRANT
+                                                                               requestId:_requestParams.telemetryRequestId
+                                                                                  failed:result.status != AD_SUCCEEDED])
+             {
+                 ADALTelemetryAPIEvent *event = [[ADALTelemetryAPIEvent alloc] initWithName:MSID_TELEMETRY_EVENT_TOKEN_GRANT
+                                                                                context:_requestParams];
+                 [event setGrantType:MSID_TELEMETRY_VALUE_BY_CODE];
+                 [event setResultStatus:[result status]];
+                 [[MSIDTelemetry sharedInstance] stopEvent:_requestParams.telemetryRequestId event:event];
+             }
              
              completionHandler(result);
          }];
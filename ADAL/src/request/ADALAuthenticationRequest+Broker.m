@@ -35,6 +35,7 @@
 #import "MSIDTelemetry+Internal.h"
 #import "ADALTelemetryBrokerEvent.h"
 #import "ADALEnrollmentGateway.h"
+#import "ADALNegativeLookupCache.h"
 #import "MSIDAuthority.h"
 #import "MSIDLegacyTokenCacheAccessor.h"
 #import "MSIDBrokerResponse.h"
@@ -302,6 +303,8 @@ NSString *kAdalSDKObjc = @"adal-objc";
                         MSID_LOG_WARN(nil, @"Failed to save Intune token");
                     }
                     
+                    [[ADALNegativeLookupCache sharedCache] invalidateAll];
+                    
                     [self saveApplicationToken:decryptedIntuneTokenResponse[@"application_token"]
                                  keychainGroup:keychainGroup
                                       clientId:decryptedIntuneTokenResponse[@"client_id"]];
@@ -388,6 +391,8 @@ NSString *kAdalSDKObjc = @"adal-objc";
             MSID_LOG_ERROR_PII(nil, @"Failed to save tokens in cache, error %@", msidError);
         }
         
+        [[ADALNegativeLookupCache sharedCache] invalidateAll];
+        
         [self saveApplicationToken:queryParamsMap[@"application_token"] keychainGroup:keychainGroup clientId:queryParamsMap[@"client_id"]];
         
         [ADALAuthenticationContext updateResult:result
@@ -78,6 +78,10 @@
 
 @property (nonatomic, readonly) MSIDLegacyTokenCacheAccessor *tokenCache;
 @property (nonatomic) NSString *sharedGroup;
+// Commits all tokens from a single response with one cache write. May be nil.
+@property (nonatomic) id<ADALTokenCacheWriteBatching> tokenCacheWriteBatching;
+// Serves all silent lookups of the request from one cache load. May be nil.
+@property (nonatomic) id<ADALTokenCacheLookupPass> tokenCacheLookupPass;
 
 @property (retain) NSString* logComponent;
 @property (nonatomic, readonly) NSDictionary *appRequestMetadata;
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "ADALTokenCacheDataSource.h"
+
+@class MSIDLegacySingleResourceToken;
+@class MSIDRefreshToken;
+@class MSIDLegacyTokenCacheAccessor;
+
+/*!
+ The cache items a silent request can use, in the order they are tried: a valid access token,
+ the single resource refresh token stored with it, the MRRT and the FRT. All of them are looked up
+ in a single pass over the cache, refresh tokens only when the access token can't be returned.
+ Redeeming the MRRT may rotate the FRT, so the FRT is only valid until an MRRT grant was made.
+ */
+@interface ADALSilentLookupPlan : NSObject
+
+// Access token item for the user, or for the unknown ADFS user. May be nil.
+@property (readonly) MSIDLegacySingleResourceToken *accessTokenItem;
+// NO if the access token item is scoped down to an enrollment the request doesn't have
+@property (readonly) BOOL enrollmentIdMatch;
+// YES if the access token item can be returned without a refresh
+@property (readonly) BOOL accessTokenValid;
+
+// Only looked up when the silent flow can fall back to them, lookup errors are kept
+// to be reported at the point the flow would have looked the item up.
+@property (readonly) MSIDRefreshToken *mrrtItem;
+@property (readonly) NSError *mrrtError;
+// FRT of the MRRT's family, or of the default family when there is no MRRT. Not looked up
+// when the MRRT has no family or its lookup failed, then frtFamilyId is nil.
+@property (readonly) MSIDRefreshToken *frtItem;
+@property (readonly) NSError *frtError;
+@property (readonly) NSString *frtFamilyId;
+
+// YES if the cache holds nothing the request can use
+@property (readonly) BOOL isMiss;
+
+/*!
+ Returns nil and fills error if the access token lookup fails.
+ */
++ (ADALSilentLookupPlan *)planWithParams:(ADALRequestParameters *)requestParams
+                              tokenCache:(MSIDLegacyTokenCacheAccessor *)tokenCache
+                              lookupPass:(id<ADALTokenCacheLookupPass>)lookupPass
+                                   error:(NSError * __autoreleasing *)error;
+
+@end
@@ -0,0 +1,167 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALSilentLookupPlan.h"
+#import "ADALAuthenticationSettings.h"
+#import "MSIDLegacyTokenCacheAccessor.h"
+#import "MSIDLegacySingleResourceToken.h"
+#import "MSIDRefreshToken.h"
+#import "MSIDAccountIdentifier.h"
+#import "MSIDConfiguration.h"
+
+@interface ADALSilentLookupPlan()
+
+@property MSIDLegacySingleResourceToken *accessTokenItem;
+@property BOOL enrollmentIdMatch;
+@property BOOL accessTokenValid;
+@property MSIDRefreshToken *mrrtItem;
+@property NSError *mrrtError;
+@property MSIDRefreshToken *frtItem;
+@property NSError *frtError;
+@property NSString *frtFamilyId;
+
+@end
+
+@implementation ADALSilentLookupPlan
+
++ (ADALSilentLookupPlan *)planWithParams:(ADALRequestParameters *)requestParams
+                              tokenCache:(MSIDLegacyTokenCacheAccessor *)tokenCache
+                              lookupPass:(id<ADALTokenCacheLookupPass>)lookupPass
+                                   error:(NSError * __autoreleasing *)error
+{
+    [lookupPass beginLookupPass];
+    
+    ADALSilentLookupPlan *plan = [ADALSilentLookupPlan new];
+    BOOL result = [plan lookupAccessTokenWithParams:requestParams tokenCache:tokenCache error:error];
+    
+    if (result && [plan needsRefreshTokens])
+    {
+        [plan lookupRefreshTokensWithParams:requestParams tokenCache:tokenCache];
+    }
+    
+    [lookupPass endLookupPass];
+    
+    return result ? plan : nil;
+}
+
+- (BOOL)lookupAccessTokenWithParams:(ADALRequestParameters *)requestParams
+                         tokenCache:(MSIDLegacyTokenCacheAccessor *)tokenCache
+                              error:(NSError * __autoreleasing *)error
+{
+    NSError *msidError = nil;
+    MSIDConfiguration *configuration = requestParams.msidConfig;
+    
+    MSIDLegacySingleResourceToken *item = [tokenCache getSingleResourceTokenForAccount:requestParams.account
+                                                                         configuration:configuration
+                                                                               context:requestParams
+                                                                                 error:&msidError];
+    
+    // If we didn't find an item at all there's a chance that we might be dealing with an "ADFS" user
+    // and we need to check the unknown user ADFS token as well
+    if (!item && !msidError)
+    {
+        MSIDAccountIdentifier *account = [[MSIDAccountIdentifier alloc] initWithLegacyAccountId:@"" homeAccountId:nil];
+        
+        item = [tokenCache getSingleResourceTokenForAccount:account
+                                              configuration:configuration
+                                                    context:requestParams
+                                                      error:&msidError];
+    }
+    
+    if (msidError)
+    {
+        if (error) *error = msidError;
+        return NO;
+    }
+    
+    self.accessTokenItem = item;
+    self.enrollmentIdMatch = YES;
+    
+    // If token is scoped down to a particular enrollmentId and app is capable for True MAM CA, verify that enrollmentIds match
+    // EnrollmentID matching is done on the request layer to ensure that expired access tokens get removed even if valid enrollmentId is not presented
+    if ([requestParams isCapableForMAMCA] && ![NSString msidIsStringNilOrBlank:item.enrollmentId])
+    {
+        self.enrollmentIdMatch = configuration.enrollmentId && [configuration.enrollmentId isEqualToString:item.enrollmentId];
+    }
+    
+    self.accessTokenValid = item.accessToken
+        && ![item isExpiredWithExpiryBuffer:[ADALAuthenticationSettings sharedInstance].expirationBuffer]
+        && !requestParams.forceRefresh
+        && self.enrollmentIdMatch;
+    
+    return YES;
+}
+
+- (BOOL)needsRefreshTokens
+{
+    if (!self.accessTokenItem)
+    {
+        return YES;
+    }
+    
+    // A single resource refresh token means we aren't talking to AAD, and an item without
+    // an id token came from an authority that doesn't support MRRTs or FRTs either.
+    return !self.accessTokenValid && !self.accessTokenItem.refreshToken && self.accessTokenItem.idToken;
+}
+
+- (void)lookupRefreshTokensWithParams:(ADALRequestParameters *)requestParams
+                           tokenCache:(MSIDLegacyTokenCacheAccessor *)tokenCache
+{
+    NSError *msidError = nil;
+    
+    self.mrrtItem = [tokenCache getRefreshTokenWithAccount:requestParams.account
+                                                  familyId:nil
+                                             configuration:requestParams.msidConfig
+                                                   context:requestParams
+                                                     error:&msidError];
+    self.mrrtError = self.mrrtItem ? nil : msidError;
+    
+    if (self.mrrtError)
+    {
+        return;
+    }
+    
+    // Without an MRRT the default family ID is used to preserve the previous ADAL functionality
+    NSString *familyId = self.mrrtItem ? self.mrrtItem.familyId : @"1";
+    
+    if (!familyId)
+    {
+        return;
+    }
+    
+    msidError = nil;
+    self.frtItem = [tokenCache getRefreshTokenWithAccount:requestParams.account
+                                                 familyId:familyId
+                                            configuration:requestParams.msidConfig
+                                                  context:requestParams
+                                                    error:&msidError];
+    self.frtError = self.frtItem ? nil : msidError;
+    self.frtFamilyId = familyId;
+}
+
+- (BOOL)isMiss
+{
+    return !self.accessTokenItem && !self.mrrtItem && !self.mrrtError && !self.frtItem && !self.frtError;
+}
+
+@end
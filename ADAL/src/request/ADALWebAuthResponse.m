@@ -267,11 +267,13 @@ static NSString *const kPKeyAuthName = @"PKeyAuth";
     }
     
     // Request failure
-    NSString* body = [[NSString alloc] initWithData:webResponse.body encoding:NSUTF8StringEncoding];
-    NSString* errorData = [NSString stringWithFormat:@"Full response: %@", body];
-    
     MSID_LOG_WARN(_request, @"HTTP Error %ld", (long)webResponse.statusCode);
-    MSID_LOG_WARN_PII(_request, @"%@", errorData);
+    
+    if (ADAL_LOG_PII_ENABLED(MSIDLogLevelWarning))
+    {
+        NSString* body = [[NSString alloc] initWithData:webResponse.body encoding:NSUTF8StringEncoding];
+        MSID_LOG_WARN_PII(_request, @"Full response: %@", body);
+    }
     
     ADALAuthenticationError* adError = [ADALAuthenticationError errorFromHTTPErrorCode:webResponse.statusCode
                                                                               body:[NSString stringWithFormat:@"(%lu bytes)", (unsigned long)webResponse.body.length]
@@ -371,17 +373,21 @@ static NSString *const kPKeyAuthName = @"PKeyAuth";
     }
     else
     {
-        if ([body length] < 1024)
-        {
-            bodyStr = [[NSString alloc] initWithData:body encoding:NSUTF8StringEncoding];
-        }
-        else
+        MSID_LOG_ERROR(_request, @"JSON deserialization error:");
+        
+        if (ADAL_LOG_PII_ENABLED(MSIDLogLevelError))
         {
-            bodyStr = [[NSString alloc] initWithFormat:@"large response, probably HTML, <%lu bytes>", (unsigned long)[body length]];
+            if ([body length] < 1024)
+            {
+                bodyStr = [[NSString alloc] initWithData:body encoding:NSUTF8StringEncoding];
+            }
+            else
+            {
+                bodyStr = [[NSString alloc] initWithFormat:@"large response, probably HTML, <%lu bytes>", (unsigned long)[body length]];
+            }
+            
+            MSID_LOG_ERROR_PII(_request, @"JSON deserialization error: %@ - %@", jsonError.description, bodyStr);
         }
-        
-        MSID_LOG_ERROR(_request, @"JSON deserialization error:");
-        MSID_LOG_ERROR_PII(_request, @"JSON deserialization error: %@ - %@", jsonError.description, bodyStr);
     }
     
     [self handleNSError:jsonError completionBlock:completionBlock];
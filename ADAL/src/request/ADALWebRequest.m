@@ -36,9 +36,20 @@
 #import "MSIDDeviceId.h"
 #import "MSIDAuthorityFactory.h"
 #import "MSIDAuthority.h"
+#import "ADALTelemetrySampler.h"
+#import "ADALLatencyStatistics.h"
+#import "ADALHistogram.h"
+#import "ADALTrace.h"
+#import "ADALRequestParameters.h"
 
 @interface ADALWebRequest ()
 
+// Used to break down HTTP latency statistics by public API
+@property (nonatomic) NSString *apiId;
+@property (nonatomic) uint64_t sendStart;
+@property (nonatomic) ADALTraceSpanId traceSpan;
+@property (nonatomic) BOOL telemetryStarted;
+
 - (void)completeWithError:(NSError *)error andResponse:(ADALWebResponse *)response;
 - (void)send;
 
@@ -99,6 +110,11 @@
     
     _logComponent       = context.logComponent;
     
+    if ([(NSObject *)context isKindOfClass:[ADALRequestParameters class]])
+    {
+        _apiId = ((ADALRequestParameters *)context).apiId;
+    }
+    
     NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
     _session = [NSURLSession sessionWithConfiguration:configuration delegate:self delegateQueue:nil];
     
@@ -137,7 +153,13 @@
 
 - (void)send
 {
-    [[MSIDTelemetry sharedInstance] startEvent:_telemetryRequestId eventName:MSID_TELEMETRY_EVENT_HTTP_REQUEST];
+    self.sendStart = [ADALHistogram now];
+    self.traceSpan = [ADALTrace beginSpan:MSID_TELEMETRY_EVENT_HTTP_REQUEST requestId:_telemetryRequestId];
+    self.telemetryStarted = [ADALTelemetrySampler shouldStartEvent:MSID_TELEMETRY_EVENT_HTTP_REQUEST requestId:_telemetryRequestId];
+    if (self.telemetryStarted)
+    {
+        [[MSIDTelemetry sharedInstance] startEvent:_telemetryRequestId eventName:MSID_TELEMETRY_EVENT_HTTP_REQUEST];
+    }
     [_requestHeaders addEntriesFromDictionary:[MSIDDeviceId deviceId]];
 
     if (self.appRequestMetadata)
@@ -256,6 +278,17 @@
 - (void)stopTelemetryEvent:(NSError *)error
                   response:(ADALWebResponse *)response
 {
+    BOOL failed = error || response.statusCode >= 400;
+    
+    NSString *status = error ? @"error" : [ADALLatencyStatistics statusForHTTPStatusCode:response.statusCode];
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_HTTP since:self.sendStart apiId:self.apiId status:status];
+    [ADALTrace endSpan:self.traceSpan requestId:_telemetryRequestId status:status];
+    
+    if (!self.telemetryStarted || ![ADALTelemetrySampler shouldRecordStartedEvent:MSID_TELEMETRY_EVENT_HTTP_REQUEST requestId:_telemetryRequestId failed:failed])
+    {
+        return;
+    }
+    
     MSIDTelemetryHttpEvent* event = [[MSIDTelemetryHttpEvent alloc] initWithName:MSID_TELEMETRY_EVENT_HTTP_REQUEST requestId:_telemetryRequestId correlationId:_correlationId];
     
     [event setHttpMethod:_isGetRequest ? @"GET" : @"POST"];
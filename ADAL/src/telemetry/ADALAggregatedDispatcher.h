@@ -25,4 +25,17 @@
 
 @interface ADALAggregatedDispatcher : ADALDefaultDispatcher
 
+// Most unflushed requests this dispatcher keeps, the oldest one is evicted when a new one exceeds it
+@property (nonatomic) NSUInteger maxPendingRequests;
+// Age in seconds past which an unflushed request is evicted, checked on flush: and on new requests
+// at most every tenth of this age
+@property (nonatomic) NSTimeInterval maxPendingAge;
+
+// Requests with events waiting for flush:, across all aggregating dispatchers
++ (NSUInteger)pendingRequestCount;
+// Requests whose events were dropped because they were never flushed, since launch
++ (NSUInteger)evictedRequestCount;
+// Events dropped because their request already had the most events kept per request, since launch
++ (NSUInteger)droppedEventCount;
+
 @end
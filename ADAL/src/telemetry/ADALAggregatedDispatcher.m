@@ -21,11 +21,15 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#import <os/lock.h>
+#include <stdatomic.h>
+#include <time.h>
 #import "ADALTelemetry.h"
 #import "MSIDTelemetryEventInterface.h"
 #import "ADALAggregatedDispatcher.h"
 #import "MSIDTelemetryEventStrings.h"
 #import "ADALTelemetryCollectionRules.h"
+#import "ADALTelemetrySampler.h"
 #import "ADALTelemetryAPIEvent.h"
 #import "MSIDTelemetryUIEvent.h"
 #import "MSIDTelemetryHttpEvent.h"
@@ -33,30 +37,179 @@
 #import "ADALTelemetryBrokerEvent.h"
 #import "NSMutableDictionary+MSIDExtensions.h"
 
+// Must be a power of two, request IDs are assigned to a stripe by masking their hash
+#define ADAL_AGGREGATED_DISPATCHER_STRIPE_COUNT 16
+
+// Defaults for the unflushed request buffers, see maxPendingRequests and maxPendingAge
+#define ADAL_AGGREGATED_DISPATCHER_MAX_PENDING_REQUESTS 256
+#define ADAL_AGGREGATED_DISPATCHER_MAX_PENDING_AGE      600
+// Expired requests are swept every maxPendingAge / this, so none outlives the limit by more than 10%
+#define ADAL_AGGREGATED_DISPATCHER_SWEEPS_PER_AGE       10
+// Events past this are dropped and counted, a single request produces a few dozen at most
+#define ADAL_AGGREGATED_DISPATCHER_MAX_REQUEST_EVENTS   512
+
+// Upper bound on distinct CollectAndCount properties across all aggregated event classes
+#define ADAL_AGGREGATED_DISPATCHER_MAX_COUNTERS 8
+
+// One entry of an event class's compiled schema, the property names are constant strings
+typedef struct
+{
+    __unsafe_unretained NSString *name;
+    ADALTelemetryCollectionBehavior behavior;
+    NSUInteger counterIndex;
+} ADALAggregatedProperty;
+
+// Events received for one request ID that hasn't been flushed yet
+@interface ADALPendingRequest : NSObject
+
+@property (nonatomic, readonly) NSMutableArray *events;
+@property (nonatomic, readonly) uint64_t startTime;
+// Events received past ADAL_AGGREGATED_DISPATCHER_MAX_REQUEST_EVENTS
+@property (nonatomic) NSUInteger droppedEventCount;
+
+@end
+
+@implementation ADALPendingRequest
+
+- (instancetype)initWithStartTime:(uint64_t)startTime
+{
+    self = [super init];
+    if (self)
+    {
+        _events = [NSMutableArray new];
+        _startTime = startTime;
+    }
+    return self;
+}
+
+@end
+
+/*
+ Events are buffered per request ID in a fixed set of stripes, each guarded by its own
+ unfair lock, so concurrent requests only contend when their IDs hash to the same stripe.
+ The stripe array is created once and never mutated, so it can be read without a lock.
+ */
+@interface ADALAggregatedDispatcher ()
+{
+    NSArray<NSMutableDictionary<NSString *, ADALPendingRequest *> *> *_stripes;
+    os_unfair_lock _stripeLocks[ADAL_AGGREGATED_DISPATCHER_STRIPE_COUNT];
+    // Requests buffered by this dispatcher, the count maxPendingRequests applies to
+    atomic_ulong _pendingCount;
+    // Uptime in nanoseconds after which the next flush: or new request sweeps expired requests
+    atomic_ullong _nextSweepTime;
+}
+
+@end
+
 @implementation ADALAggregatedDispatcher
 
-static NSDictionary *s_eventPropertiesDictionary;
+// Event class -> NSData holding a flat array of ADALAggregatedProperty
+static NSDictionary *s_eventSchemas;
+// Counter index -> property name of every CollectAndCount property
+static NSArray<NSString *> *s_counterKeys;
+
+// Across all aggregating dispatchers, reported through ADALTelemetry
+static atomic_ullong s_pendingRequestCount;
+static atomic_ullong s_evictedRequestCount;
+static atomic_ullong s_droppedEventCount;
 
-- (id)initWithDispatcher:(id<ADDispatcher>)dispatcher
+- (instancetype)initWithDispatcher:(id<ADDispatcher>)dispatcher
+                      asynchronous:(BOOL)asynchronous
 {
-    self = [super initWithDispatcher:dispatcher];
+    self = [super initWithDispatcher:dispatcher asynchronous:asynchronous];
+    if (self)
+    {
+        NSMutableArray *stripes = [NSMutableArray arrayWithCapacity:ADAL_AGGREGATED_DISPATCHER_STRIPE_COUNT];
+        for (NSUInteger i = 0; i < ADAL_AGGREGATED_DISPATCHER_STRIPE_COUNT; i++)
+        {
+            [stripes addObject:[NSMutableDictionary new]];
+            _stripeLocks[i] = OS_UNFAIR_LOCK_INIT;
+        }
+        _stripes = stripes;
+        
+        _maxPendingRequests = ADAL_AGGREGATED_DISPATCHER_MAX_PENDING_REQUESTS;
+        _maxPendingAge = ADAL_AGGREGATED_DISPATCHER_MAX_PENDING_AGE;
+    }
     return self;
 }
 
+- (void)dealloc
+{
+    atomic_fetch_sub(&s_pendingRequestCount, atomic_load(&_pendingCount));
+}
+
+- (NSUInteger)stripeForRequestId:(NSString *)requestId
+{
+    return requestId.hash & (ADAL_AGGREGATED_DISPATCHER_STRIPE_COUNT - 1);
+}
+
 - (void)flush:(NSString*)requestId
 {
-    [_dispatchLock lock]; //avoid access conflict when manipulating _objectsToBeDispatched
-    NSArray* eventsToBeDispatched = [_objectsToBeDispatched objectForKey:requestId];
-    [_objectsToBeDispatched removeObjectForKey:requestId];
-    [_dispatchLock unlock];
+    if (!requestId)
+    {
+        return;
+    }
     
+    NSUInteger stripe = [self stripeForRequestId:requestId];
+    NSMutableDictionary *buffers = _stripes[stripe];
+    
+    // The pending count is only changed with the stripe locked, so it can't drop below
+    // the requests this stripe actually holds
+    os_unfair_lock_lock(&_stripeLocks[stripe]);
+    ADALPendingRequest *pendingRequest = [buffers objectForKey:requestId];
+    if (pendingRequest)
+    {
+        [buffers removeObjectForKey:requestId];
+        [self removedPendingRequests:1];
+    }
+    os_unfair_lock_unlock(&_stripeLocks[stripe]);
+    
+    [self sweepExpiredRequestsIfDue:clock_gettime_nsec_np(CLOCK_UPTIME_RAW)];
+    
+    NSArray* eventsToBeDispatched = pendingRequest.events;
+    
+    // Nothing of the request was sampled, or it was already flushed or evicted
+    if (!eventsToBeDispatched.count)
+    {
+        return;
+    }
+    
+    // When dispatching asynchronously the caller only detaches the request's events
+    if (_deliveryQueue)
+    {
+        dispatch_async(_deliveryQueue, ^{
+            [self dispatchEvent:[self aggregateEvents:eventsToBeDispatched]];
+        });
+        return;
+    }
+    
+    [self dispatchEvent:[self aggregateEvents:eventsToBeDispatched]];
+}
+
+- (NSDictionary *)aggregateEvents:(NSArray<id<MSIDTelemetryEventInterface>> *)eventsToBeDispatched
+{
     NSMutableDictionary* aggregatedEvent = [NSMutableDictionary new];
+    if (eventsToBeDispatched.count)
+    {
+        [aggregatedEvent addEntriesFromDictionary:[MSIDTelemetryBaseEvent defaultParameters]];
+    }
+    
+    // Counters stay integers while aggregating and are only formatted once per aggregate
+    NSUInteger counters[ADAL_AGGREGATED_DISPATCHER_MAX_COUNTERS] = {0};
     for (id<MSIDTelemetryEventInterface> event in eventsToBeDispatched)
     {
-        [self addPropertiesToDictionary:aggregatedEvent event:event];
+        [self addPropertiesToDictionary:aggregatedEvent counters:counters event:event];
+    }
+    
+    for (NSUInteger i = 0; i < s_counterKeys.count; i++)
+    {
+        if (counters[i])
+        {
+            [aggregatedEvent setObject:[NSString stringWithFormat:@"%lu", (unsigned long)counters[i]] forKey:s_counterKeys[i]];
+        }
     }
     
-    [self dispatchEvent:aggregatedEvent];
+    return aggregatedEvent;
 }
 
 - (void)receive:(NSString *)requestId
@@ -68,59 +221,279 @@ static NSDictionary *s_eventPropertiesDictionary;
         
     }
     
-    [_dispatchLock lock]; //make sure no one changes _objectsToBeDispatched while using it
-    NSMutableArray* eventsForRequestId = [_objectsToBeDispatched objectForKey:requestId];
-    if (!eventsForRequestId)
+    if (![ADALTelemetrySampler shouldDispatchEvent:event requestId:requestId])
     {
-        eventsForRequestId = [NSMutableArray new];
-        [_objectsToBeDispatched setObject:eventsForRequestId forKey:requestId];
+        return;
     }
     
-    [eventsForRequestId addObject:event];
-    [_dispatchLock unlock];
+    NSUInteger stripe = [self stripeForRequestId:requestId];
+    NSMutableDictionary *buffers = _stripes[stripe];
+    
+    uint64_t now = 0;
+    BOOL firstDroppedEvent = NO;
     
+    os_unfair_lock_lock(&_stripeLocks[stripe]);
+    ADALPendingRequest *pendingRequest = [buffers objectForKey:requestId];
+    if (!pendingRequest)
+    {
+        now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+        pendingRequest = [[ADALPendingRequest alloc] initWithStartTime:now];
+        [buffers setObject:pendingRequest forKey:requestId];
+        atomic_fetch_add(&_pendingCount, 1);
+        atomic_fetch_add(&s_pendingRequestCount, 1);
+    }
+    
+    if (pendingRequest.events.count < ADAL_AGGREGATED_DISPATCHER_MAX_REQUEST_EVENTS)
+    {
+        [pendingRequest.events addObject:event];
+    }
+    else
+    {
+        firstDroppedEvent = (pendingRequest.droppedEventCount++ == 0);
+        atomic_fetch_add(&s_droppedEventCount, 1);
+    }
+    os_unfair_lock_unlock(&_stripeLocks[stripe]);
+    
+    // Only a new request can take the dispatcher over its limits
+    if (now)
+    {
+        [self sweepExpiredRequestsIfDue:now];
+        
+        while (atomic_load(&_pendingCount) > _maxPendingRequests)
+        {
+            if (![self evictOldestRequest])
+            {
+                break;
+            }
+        }
+    }
+    
+    if (firstDroppedEvent)
+    {
+        MSID_LOG_WARN(nil, @"Request has more than %d telemetry events, dropping the rest", ADAL_AGGREGATED_DISPATCHER_MAX_REQUEST_EVENTS);
+    }
 }
 
-- (void)addPropertiesToDictionary:(NSMutableDictionary*)aggregatedEvent event:(id<MSIDTelemetryEventInterface>)event
+#pragma mark - Eviction
+
+/*
+ Requests that never reach flush: would otherwise keep their events for the rest of the process.
+ Requests older than maxPendingAge are dropped from every stripe by a sweep that flush: and new
+ requests run at most every maxPendingAge / ADAL_AGGREGATED_DISPATCHER_SWEEPS_PER_AGE, and the
+ oldest request is dropped whenever the dispatcher holds more than maxPendingRequests.
+ Both are called without any stripe locked.
+ */
+- (void)sweepExpiredRequestsIfDue:(uint64_t)now
 {
-    [aggregatedEvent addEntriesFromDictionary:[MSIDTelemetryBaseEvent defaultParameters]];
+    unsigned long long nextSweepTime = atomic_load(&_nextSweepTime);
+    if (now < nextSweepTime)
+    {
+        return;
+    }
+    
+    uint64_t maxAge = (uint64_t)(_maxPendingAge * NSEC_PER_SEC);
     
-    NSString *eventClassName = NSStringFromClass([event class]);
+    // Another thread claimed this sweep
+    if (!atomic_compare_exchange_strong(&_nextSweepTime, &nextSweepTime, now + maxAge / ADAL_AGGREGATED_DISPATCHER_SWEEPS_PER_AGE))
+    {
+        return;
+    }
     
-    NSArray* eventProperties = [s_eventPropertiesDictionary objectForKey:eventClassName];
+    NSUInteger evictedCount = 0;
     
-    for (NSString* propertyName in eventProperties)
+    for (NSUInteger stripe = 0; stripe < ADAL_AGGREGATED_DISPATCHER_STRIPE_COUNT; stripe++)
     {
-        ADALTelemetryCollectionBehavior collectionBehavior = [ADALTelemetryCollectionRules getTelemetryCollectionRule:propertyName];
+        NSMutableDictionary<NSString *, ADALPendingRequest *> *buffers = _stripes[stripe];
+        NSMutableArray *expiredRequestIds = nil;
+        
+        os_unfair_lock_lock(&_stripeLocks[stripe]);
+        for (NSString *requestId in buffers)
+        {
+            // Requests added after now was read have a later start time
+            uint64_t startTime = buffers[requestId].startTime;
+            
+            if (startTime < now && now - startTime > maxAge)
+            {
+                if (!expiredRequestIds)
+                {
+                    expiredRequestIds = [NSMutableArray new];
+                }
+                
+                [expiredRequestIds addObject:requestId];
+            }
+        }
         
-        NSString* propertyKey = propertyName;
+        if (expiredRequestIds.count)
+        {
+            [buffers removeObjectsForKeys:expiredRequestIds];
+            [self removedPendingRequests:expiredRequestIds.count];
+            evictedCount += expiredRequestIds.count;
+        }
+        os_unfair_lock_unlock(&_stripeLocks[stripe]);
+    }
+    
+    [self evictedPendingRequests:evictedCount];
+}
+
+/*! Returns NO if there was no request to evict */
+- (BOOL)evictOldestRequest
+{
+    NSString *oldestRequestId = nil;
+    NSUInteger oldestStripe = 0;
+    uint64_t oldestStartTime = UINT64_MAX;
+    
+    for (NSUInteger stripe = 0; stripe < ADAL_AGGREGATED_DISPATCHER_STRIPE_COUNT; stripe++)
+    {
+        NSMutableDictionary<NSString *, ADALPendingRequest *> *buffers = _stripes[stripe];
         
-        if (collectionBehavior == CollectAndUpdate)
+        os_unfair_lock_lock(&_stripeLocks[stripe]);
+        for (NSString *requestId in buffers)
         {
-            //erase the previous event properties only if there were any previously
-            if ([aggregatedEvent objectForKey:propertyKey])
+            uint64_t startTime = buffers[requestId].startTime;
+            
+            if (startTime < oldestStartTime)
             {
-                [aggregatedEvent removeObjectForKey:propertyKey];
+                oldestStartTime = startTime;
+                oldestRequestId = requestId;
+                oldestStripe = stripe;
             }
         }
+        os_unfair_lock_unlock(&_stripeLocks[stripe]);
+    }
+    
+    if (!oldestRequestId)
+    {
+        return NO;
+    }
+    
+    NSMutableDictionary<NSString *, ADALPendingRequest *> *buffers = _stripes[oldestStripe];
+    
+    // The request may have been flushed since the stripes were scanned, then there's room again
+    os_unfair_lock_lock(&_stripeLocks[oldestStripe]);
+    BOOL evicted = buffers[oldestRequestId].startTime == oldestStartTime;
+    if (evicted)
+    {
+        [buffers removeObjectForKey:oldestRequestId];
+        [self removedPendingRequests:1];
+    }
+    os_unfair_lock_unlock(&_stripeLocks[oldestStripe]);
+    
+    [self evictedPendingRequests:evicted ? 1 : 0];
+    
+    return YES;
+}
+
+/*! Called with the stripe that held the requests locked, so the counts can't drop below what the stripes hold */
+- (void)removedPendingRequests:(NSUInteger)count
+{
+    atomic_fetch_sub(&_pendingCount, count);
+    atomic_fetch_sub(&s_pendingRequestCount, count);
+}
+
+- (void)evictedPendingRequests:(NSUInteger)count
+{
+    if (!count)
+    {
+        return;
+    }
+    
+    atomic_fetch_add(&s_evictedRequestCount, count);
+    MSID_LOG_WARN(nil, @"Evicted telemetry events of %lu requests that were never flushed", (unsigned long)count);
+}
+
++ (NSUInteger)pendingRequestCount
+{
+    return (NSUInteger)atomic_load(&s_pendingRequestCount);
+}
+
++ (NSUInteger)evictedRequestCount
+{
+    return (NSUInteger)atomic_load(&s_evictedRequestCount);
+}
+
++ (NSUInteger)droppedEventCount
+{
+    return (NSUInteger)atomic_load(&s_droppedEventCount);
+}
+
+- (void)addPropertiesToDictionary:(NSMutableDictionary*)aggregatedEvent
+                         counters:(NSUInteger *)counters
+                            event:(id<MSIDTelemetryEventInterface>)event
+{
+    NSData *schema = [s_eventSchemas objectForKey:[event class]];
+    const ADALAggregatedProperty *properties = schema.bytes;
+    NSUInteger propertyCount = schema.length / sizeof(ADALAggregatedProperty);
+    
+    for (NSUInteger i = 0; i < propertyCount; i++)
+    {
+        const ADALAggregatedProperty *property = &properties[i];
         
-        if (collectionBehavior != CollectAndCount)
+        switch (property->behavior)
         {
-            [aggregatedEvent msidSetObjectIfNotNil:[event propertyWithName:propertyName] forKey:propertyKey];
+            case CollectAndCount:
+                counters[property->counterIndex]++;
+                break;
+                
+            case CollectAndUpdate:
+                //erase the previous event property even if this event doesn't have one
+                [aggregatedEvent removeObjectForKey:property->name];
+                // fall through
+                
+            default:
+                [aggregatedEvent msidSetObjectIfNotNil:[event propertyWithName:property->name] forKey:property->name];
+                break;
         }
-        else
+    }
+}
+
+/*
+ Resolves every event class's property list against ADALTelemetryCollectionRules once,
+ so aggregating an event is a walk over a flat array instead of per property lookups.
+ */
++ (void)compileSchemas:(NSDictionary<NSString *, NSArray<NSString *> *> *)eventProperties
+{
+    NSMutableDictionary *schemas = [NSMutableDictionary new];
+    NSMutableArray *counterKeys = [NSMutableArray new];
+    
+    for (NSString *eventClassName in eventProperties)
+    {
+        NSArray<NSString *> *propertyNames = eventProperties[eventClassName];
+        NSMutableData *schema = [NSMutableData dataWithLength:propertyNames.count * sizeof(ADALAggregatedProperty)];
+        ADALAggregatedProperty *properties = schema.mutableBytes;
+        
+        for (NSUInteger i = 0; i < propertyNames.count; i++)
         {
-            int eventCount = [[aggregatedEvent objectForKey:propertyKey] intValue];
-            [aggregatedEvent setObject:[NSString stringWithFormat:@"%d", ++eventCount] forKey:propertyKey];
+            NSString *propertyName = propertyNames[i];
+            ADALTelemetryCollectionBehavior behavior = [ADALTelemetryCollectionRules getTelemetryCollectionRule:propertyName];
+            NSUInteger counterIndex = 0;
+            
+            if (behavior == CollectAndCount)
+            {
+                counterIndex = [counterKeys indexOfObject:propertyName];
+                if (counterIndex == NSNotFound)
+                {
+                    counterIndex = counterKeys.count;
+                    [counterKeys addObject:propertyName];
+                }
+            }
+            
+            properties[i] = (ADALAggregatedProperty){ propertyName, behavior, counterIndex };
         }
+        
+        schemas[(id<NSCopying>)NSClassFromString(eventClassName)] = schema;
     }
+    
+    NSAssert(counterKeys.count <= ADAL_AGGREGATED_DISPATCHER_MAX_COUNTERS, @"Raise ADAL_AGGREGATED_DISPATCHER_MAX_COUNTERS");
+    
+    s_eventSchemas = schemas;
+    s_counterKeys = counterKeys;
 }
 
 + (void)initialize
 {
     if (self == [ADALAggregatedDispatcher class])
     {
-        s_eventPropertiesDictionary = @{
+        [self compileSchemas:@{
                                       NSStringFromClass([ADALTelemetryAPIEvent class]): @[
                                               // default properties apply to all events
                                               MSID_TELEMETRY_KEY_REQUEST_ID,
@@ -186,7 +559,7 @@ static NSDictionary *s_eventPropertiesDictionary;
                                               MSID_TELEMETRY_KEY_BROKER_APP,
                                               MSID_TELEMETRY_KEY_BROKER_VERSION
                                               ],
-                                      };
+                                      }];
     }
 }
 
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+typedef NS_ENUM(NSUInteger, ADALCacheCounter)
+{
+    ADALCacheCounterSilentAccessTokenHit,
+    ADALCacheCounterSilentRefreshTokenGrant,
+    ADALCacheCounterSilentMRRTGrant,
+    ADALCacheCounterSilentFRTGrant,
+    ADALCacheCounterSilentMiss,
+    ADALCacheCounterSilentRememberedMiss,
+    ADALCacheCounterRead,
+    ADALCacheCounterReadHit,
+    ADALCacheCounterReadMiss,
+    ADALCacheCounterItemsRead,
+    ADALCacheCounterWrite,
+    ADALCacheCounterRemoval,
+    
+    ADALCacheCounterCount
+};
+
+// Gauges hold the last value observed
+typedef NS_ENUM(NSUInteger, ADALCacheGauge)
+{
+    ADALCacheGaugeItemCount,
+    ADALCacheGaugeSerializedBytes,
+    
+    ADALCacheGaugeCount
+};
+
+typedef NS_ENUM(NSUInteger, ADALCacheHistogram)
+{
+    ADALCacheHistogramRead,
+    ADALCacheHistogramSerialize,
+    ADALCacheHistogramDeserialize,
+    
+    ADALCacheHistogramCount
+};
+
+/*!
+ Process wide counters and latency histograms of token cache access. Recording is lock free
+ and cheap enough to stay on in production builds.
+ */
+@interface ADALCacheStatistics : NSObject
+
++ (void)increment:(ADALCacheCounter)counter;
++ (void)add:(uint64_t)value toCounter:(ADALCacheCounter)counter;
++ (void)set:(uint64_t)value forGauge:(ADALCacheGauge)gauge;
+
+/*! start is an [ADALHistogram now] timestamp */
++ (void)recordSince:(uint64_t)start inHistogram:(ADALCacheHistogram)histogram;
+
+/*!
+ Counters, gauges and histograms keyed by name. Histograms have <name>_count, <name>_min_us,
+ <name>_max_us, <name>_mean_us, <name>_p50_us, <name>_p90_us and <name>_p99_us entries.
+ */
++ (NSDictionary<NSString *, NSNumber *> *)snapshot;
++ (void)reset;
+
+/*! If YES, silent acquire token telemetry events tell how the cache served the request. */
++ (BOOL)eventsEnabled;
++ (void)setEventsEnabled:(BOOL)eventsEnabled;
+
+@end
@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALCacheStatistics.h"
+#import "ADALHistogram.h"
+#include <stdatomic.h>
+
+static NSString *const s_counterNames[ADALCacheCounterCount] =
+{
+    @"silent_access_token_hits",
+    @"silent_refresh_token_grants",
+    @"silent_mrrt_grants",
+    @"silent_frt_grants",
+    @"silent_misses",
+    @"silent_remembered_misses",
+    @"cache_reads",
+    @"cache_read_hits",
+    @"cache_read_misses",
+    @"cache_items_read",
+    @"cache_writes",
+    @"cache_removals",
+};
+
+static NSString *const s_gaugeNames[ADALCacheGaugeCount] =
+{
+    @"cache_item_count",
+    @"cache_serialized_bytes",
+};
+
+static NSString *const s_histogramNames[ADALCacheHistogramCount] =
+{
+    @"cache_read",
+    @"cache_serialize",
+    @"cache_deserialize",
+};
+
+static atomic_uint_fast64_t s_counters[ADALCacheCounterCount];
+static atomic_uint_fast64_t s_gauges[ADALCacheGaugeCount];
+static ADALHistogram *s_histograms[ADALCacheHistogramCount];
+static atomic_bool s_eventsEnabled;
+
+@implementation ADALCacheStatistics
+
++ (void)initialize
+{
+    if (self != [ADALCacheStatistics class])
+    {
+        return;
+    }
+    
+    for (NSUInteger i = 0; i < ADALCacheHistogramCount; i++)
+    {
+        s_histograms[i] = [ADALHistogram new];
+    }
+}
+
++ (void)increment:(ADALCacheCounter)counter
+{
+    [self add:1 toCounter:counter];
+}
+
++ (void)add:(uint64_t)value toCounter:(ADALCacheCounter)counter
+{
+    if (counter >= ADALCacheCounterCount)
+    {
+        return;
+    }
+    
+    atomic_fetch_add_explicit(&s_counters[counter], value, memory_order_relaxed);
+}
+
++ (void)set:(uint64_t)value forGauge:(ADALCacheGauge)gauge
+{
+    if (gauge >= ADALCacheGaugeCount)
+    {
+        return;
+    }
+    
+    atomic_store_explicit(&s_gauges[gauge], value, memory_order_relaxed);
+}
+
++ (void)recordSince:(uint64_t)start inHistogram:(ADALCacheHistogram)histogram
+{
+    if (histogram >= ADALCacheHistogramCount)
+    {
+        return;
+    }
+    
+    [s_histograms[histogram] recordSince:start];
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)snapshot
+{
+    NSMutableDictionary *snapshot = [NSMutableDictionary new];
+    
+    for (NSUInteger i = 0; i < ADALCacheCounterCount; i++)
+    {
+        snapshot[s_counterNames[i]] = @(atomic_load_explicit(&s_counters[i], memory_order_relaxed));
+    }
+    
+    for (NSUInteger i = 0; i < ADALCacheGaugeCount; i++)
+    {
+        snapshot[s_gaugeNames[i]] = @(atomic_load_explicit(&s_gauges[i], memory_order_relaxed));
+    }
+    
+    for (NSUInteger i = 0; i < ADALCacheHistogramCount; i++)
+    {
+        NSString *name = s_histogramNames[i];
+        
+        [[s_histograms[i] summary] enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSNumber *value, __unused BOOL *stop) {
+            snapshot[[NSString stringWithFormat:@"%@_%@", name, key]] = value;
+        }];
+    }
+    
+    return snapshot;
+}
+
++ (void)reset
+{
+    for (NSUInteger i = 0; i < ADALCacheCounterCount; i++)
+    {
+        atomic_store_explicit(&s_counters[i], 0, memory_order_relaxed);
+    }
+    
+    for (NSUInteger i = 0; i < ADALCacheGaugeCount; i++)
+    {
+        atomic_store_explicit(&s_gauges[i], 0, memory_order_relaxed);
+    }
+    
+    for (NSUInteger i = 0; i < ADALCacheHistogramCount; i++)
+    {
+        [s_histograms[i] reset];
+    }
+}
+
++ (BOOL)eventsEnabled
+{
+    return atomic_load_explicit(&s_eventsEnabled, memory_order_relaxed);
+}
+
++ (void)setEventsEnabled:(BOOL)eventsEnabled
+{
+    atomic_store_explicit(&s_eventsEnabled, eventsEnabled, memory_order_relaxed);
+}
+
+@end
@@ -28,11 +28,33 @@
     NSMutableDictionary* _objectsToBeDispatched;
     id<ADDispatcher> _dispatcher;
     NSLock* _dispatchLock;
+    // Serial queue events are delivered on, nil when dispatching synchronously
+    dispatch_queue_t _deliveryQueue;
 }
 
+// Events coalesced into one delivery when dispatching asynchronously
+@property (nonatomic) NSUInteger batchSize;
+// Most events held while waiting for delivery, the oldest ones are dropped beyond it
+@property (nonatomic) NSUInteger queueLimit;
+// Longest time an event waits for its batch to fill, in seconds
+@property (nonatomic) NSTimeInterval batchInterval;
+
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithDispatcher:(id<ADDispatcher>)dispatcher;
 
+/*!
+ If asynchronous is YES, events are queued and handed to the dispatcher in batches on a
+ background queue, instead of on the thread that produced them.
+ */
+- (instancetype)initWithDispatcher:(id<ADDispatcher>)dispatcher
+                      asynchronous:(BOOL)asynchronous;
+
 - (void)dispatchEvent:(NSDictionary<NSString*, NSString*> *)event;
 
+/*!
+ Hands every queued event to the dispatcher now, without waiting for its batch to fill, and
+ returns once they are delivered. Does nothing when dispatching synchronously.
+ */
+- (void)flushPendingEvents;
+
 @end
@@ -26,10 +26,34 @@
 #import "ADALDefaultDispatcher.h"
 #import "MSIDTelemetryEventInterface.h"
 #import "MSIDTelemetryEventStrings.h"
+#import "ADALTelemetrySampler.h"
+
+#define ADAL_ASYNC_DISPATCH_BATCH_SIZE      20
+#define ADAL_ASYNC_DISPATCH_QUEUE_LIMIT     500
+#define ADAL_ASYNC_DISPATCH_BATCH_INTERVAL  2.0
+
+// Tags each delivery queue with its dispatcher, so a flush from the app's dispatcher doesn't wait on itself
+static void *s_deliveryQueueKey = &s_deliveryQueueKey;
+
+@interface ADALDefaultDispatcher ()
+{
+    NSMutableArray<NSDictionary *> *_pendingEvents;
+    NSUInteger _droppedEventCount;
+    BOOL _batchDeliveryScheduled;
+    BOOL _timedDeliveryScheduled;
+}
+
+@end
 
 @implementation ADALDefaultDispatcher
 
 - (instancetype)initWithDispatcher:(id<ADDispatcher>)dispatcher
+{
+    return [self initWithDispatcher:dispatcher asynchronous:NO];
+}
+
+- (instancetype)initWithDispatcher:(id<ADDispatcher>)dispatcher
+                      asynchronous:(BOOL)asynchronous
 {
     self = [super init];
     if (self)
@@ -38,6 +62,17 @@
         _dispatchLock = [NSLock new];
         
         _dispatcher = dispatcher;
+        
+        if (asynchronous)
+        {
+            dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_BACKGROUND, 0);
+            _deliveryQueue = dispatch_queue_create("com.microsoft.adal.telemetry.dispatch", attr);
+            dispatch_queue_set_specific(_deliveryQueue, s_deliveryQueueKey, (__bridge void *)self, NULL);
+            _pendingEvents = [NSMutableArray new];
+            _batchSize = ADAL_ASYNC_DISPATCH_BATCH_SIZE;
+            _queueLimit = ADAL_ASYNC_DISPATCH_QUEUE_LIMIT;
+            _batchInterval = ADAL_ASYNC_DISPATCH_BATCH_INTERVAL;
+        }
     }
     return self;
 }
@@ -54,9 +89,14 @@
     //so here is empty
 }
 
-- (void)receive:(__unused NSString *)requestId
+- (void)receive:(NSString *)requestId
           event:(id<MSIDTelemetryEventInterface>)event
 {
+    if (![ADALTelemetrySampler shouldDispatchEvent:event requestId:requestId])
+    {
+        return;
+    }
+    
     [event addDefaultProperties]; // Always append default properties to each non-aggregated event in ADAL
     
     NSDictionary *properties = [event getProperties];
@@ -69,19 +109,130 @@
 
 - (void)dispatchEvent:(NSDictionary<NSString*, NSString*> *)event;
 {
-    [_dispatcher dispatchEvent:[self appendPrefixForEvent:event]];
+    if (!_deliveryQueue)
+    {
+        [_dispatcher dispatchEvent:[self appendPrefixForEvent:event]];
+        return;
+    }
+    
+    [self enqueueEvent:event];
 }
 
 - (NSDictionary *)appendPrefixForEvent:(NSDictionary *)event
 {
-    NSMutableDictionary *eventWithPrefix = [NSMutableDictionary new];
+    NSMutableDictionary *eventWithPrefix = [[NSMutableDictionary alloc] initWithCapacity:event.count];
+    
+    [event enumerateKeysAndObjectsUsingBlock:^(NSString *propertyName, id value, __unused BOOL *stop) {
+        [eventWithPrefix setValue:value forKey:TELEMETRY_KEY(propertyName)];
+    }];
+    
+    return eventWithPrefix;
+}
+
+#pragma mark - Asynchronous dispatch
+
+/*
+ The producing thread only takes a copy of the event's properties and queues it. Prefixing and the
+ call into the app's dispatcher happen on the delivery queue, once a batch fills up or
+ batchInterval passes. When the app's dispatcher can't keep up, the oldest pending events
+ are dropped so a slow sink never holds on to unbounded memory.
+ */
+- (void)enqueueEvent:(NSDictionary *)event
+{
+    // The dictionary can belong to the event and change after this returns, it's read later on the delivery queue
+    event = [event copy];
     
-    for (NSString *propertyName in [event allKeys])
+    BOOL deliverBatch = NO;
+    BOOL deliverLater = NO;
+    
+    [_dispatchLock lock];
+    if (_queueLimit && _pendingEvents.count >= _queueLimit)
     {
-        [eventWithPrefix setValue:event[propertyName] forKey:TELEMETRY_KEY(propertyName)];
+        [_pendingEvents removeObjectAtIndex:0];
+        _droppedEventCount++;
     }
     
-    return eventWithPrefix;
+    [_pendingEvents addObject:event];
+    
+    if (_pendingEvents.count >= _batchSize && !_batchDeliveryScheduled)
+    {
+        _batchDeliveryScheduled = YES;
+        deliverBatch = YES;
+    }
+    else if (!_timedDeliveryScheduled)
+    {
+        _timedDeliveryScheduled = YES;
+        deliverLater = YES;
+    }
+    [_dispatchLock unlock];
+    
+    if (deliverBatch)
+    {
+        dispatch_async(_deliveryQueue, ^{ [self deliverPendingEventsClearingFlag:&self->_batchDeliveryScheduled]; });
+    }
+    else if (deliverLater)
+    {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_batchInterval * NSEC_PER_SEC)), _deliveryQueue, ^{ [self deliverPendingEventsClearingFlag:&self->_timedDeliveryScheduled]; });
+    }
+}
+
+- (void)flushPendingEvents
+{
+    if (!_deliveryQueue)
+    {
+        return;
+    }
+    
+    if (dispatch_get_specific(s_deliveryQueueKey) == (__bridge void *)self)
+    {
+        [self deliverPendingEventsClearingFlag:NULL];
+        return;
+    }
+    
+    // Work queued before the flush, like aggregating a finished request, runs first
+    dispatch_sync(_deliveryQueue, ^{ [self deliverPendingEventsClearingFlag:NULL]; });
+}
+
+// scheduledFlag is the flag of the scheduled delivery being run, NULL for a flush
+- (void)deliverPendingEventsClearingFlag:(BOOL *)scheduledFlag
+{
+    [_dispatchLock lock];
+    NSArray *batch = _pendingEvents;
+    _pendingEvents = [NSMutableArray new];
+    NSUInteger droppedEventCount = _droppedEventCount;
+    _droppedEventCount = 0;
+    if (scheduledFlag)
+    {
+        *scheduledFlag = NO;
+    }
+    [_dispatchLock unlock];
+    
+    if (droppedEventCount)
+    {
+        MSID_LOG_WARN(nil, @"Telemetry dispatcher is falling behind, dropped %lu events", (unsigned long)droppedEventCount);
+    }
+    
+    if (!batch.count)
+    {
+        return;
+    }
+    
+    NSMutableArray *prefixedEvents = [[NSMutableArray alloc] initWithCapacity:batch.count];
+    for (NSDictionary *event in batch)
+    {
+        [prefixedEvents addObject:[self appendPrefixForEvent:event]];
+    }
+    
+    if ([_dispatcher respondsToSelector:@selector(dispatchEvents:)])
+    {
+        [_dispatcher dispatchEvents:prefixedEvents];
+        return;
+    }
+    
+    for (NSDictionary *event in prefixedEvents)
+    {
+        [_dispatcher dispatchEvent:event];
+    }
 }
 
 @end
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/*!
+ Lock free log-linear latency histogram with 16 sub-buckets per power of two, so percentiles are
+ within about 6% of the recorded values while each histogram stays a fixed few KB. Values are in
+ microseconds and clamped to 2^40, about 12 days.
+ */
+@interface ADALHistogram : NSObject
+
+/*! Monotonic timestamp in nanoseconds, the clock all ADAL latency statistics are measured with */
++ (uint64_t)now;
+
+- (void)recordSince:(uint64_t)start;
+- (void)record:(uint64_t)microseconds;
+
+/*! Values are 0 while the histogram is empty */
+- (uint64_t)count;
+- (uint64_t)percentile:(double)percentile;
+
+/*! count, min_us, max_us, mean_us, p50_us, p90_us and p99_us */
+- (NSDictionary<NSString *, NSNumber *> *)summary;
+
+- (void)reset;
+
+@end
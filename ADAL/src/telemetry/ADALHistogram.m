@@ -0,0 +1,173 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALHistogram.h"
+#include <stdatomic.h>
+#include <time.h>
+
+// 16 sub-buckets per power of two
+#define SUB_BUCKET_BITS     4
+#define SUB_BUCKET_COUNT    (1 << SUB_BUCKET_BITS)
+#define MAX_VALUE_BITS      40
+#define MAX_VALUE           ((1ULL << MAX_VALUE_BITS) - 1)
+#define BUCKET_COUNT        ((MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT)
+
+/*
+ Values below 2 * SUB_BUCKET_COUNT get a bucket each. Above that, every power of two is split
+ into SUB_BUCKET_COUNT equal buckets, indexed by the bits right below the most significant one.
+ */
+static inline NSUInteger bucketIndex(uint64_t value)
+{
+    if (value < SUB_BUCKET_COUNT)
+    {
+        return (NSUInteger)value;
+    }
+    
+    NSUInteger msb = 63 - __builtin_clzll(value);
+    NSUInteger group = msb - SUB_BUCKET_BITS + 1;
+    NSUInteger subBucket = (NSUInteger)(value >> (msb - SUB_BUCKET_BITS)) - SUB_BUCKET_COUNT;
+    return group * SUB_BUCKET_COUNT + subBucket;
+}
+
+static inline uint64_t bucketUpperBound(NSUInteger index)
+{
+    NSUInteger group = index / SUB_BUCKET_COUNT;
+    NSUInteger subBucket = index % SUB_BUCKET_COUNT;
+    
+    if (group == 0)
+    {
+        return subBucket;
+    }
+    
+    uint64_t width = 1ULL << (group - 1);
+    return (SUB_BUCKET_COUNT + subBucket) * width + width - 1;
+}
+
+@implementation ADALHistogram
+{
+    atomic_uint_fast64_t _buckets[BUCKET_COUNT];
+    atomic_uint_fast64_t _count;
+    atomic_uint_fast64_t _total;
+    // Smallest value plus one, so that the zeroed state means no value yet
+    atomic_uint_fast64_t _minPlusOne;
+    atomic_uint_fast64_t _max;
+}
+
++ (uint64_t)now
+{
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+- (void)recordSince:(uint64_t)start
+{
+    [self record:([ADALHistogram now] - start) / NSEC_PER_USEC];
+}
+
+- (void)record:(uint64_t)microseconds
+{
+    uint64_t value = MIN(microseconds, MAX_VALUE);
+    
+    atomic_fetch_add_explicit(&_buckets[bucketIndex(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_total, value, memory_order_relaxed);
+    
+    uint_fast64_t min = atomic_load_explicit(&_minPlusOne, memory_order_relaxed);
+    while (min == 0 || value + 1 < min)
+    {
+        if (atomic_compare_exchange_weak_explicit(&_minPlusOne, &min, value + 1, memory_order_relaxed, memory_order_relaxed))
+        {
+            break;
+        }
+    }
+    
+    uint_fast64_t max = atomic_load_explicit(&_max, memory_order_relaxed);
+    while (value > max)
+    {
+        if (atomic_compare_exchange_weak_explicit(&_max, &max, value, memory_order_relaxed, memory_order_relaxed))
+        {
+            break;
+        }
+    }
+}
+
+- (uint64_t)count
+{
+    return atomic_load_explicit(&_count, memory_order_relaxed);
+}
+
+- (uint64_t)percentile:(double)percentile
+{
+    // Buckets are read one by one while other threads may record, take the rank from their sum
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t count = 0;
+    
+    for (NSUInteger i = 0; i < BUCKET_COUNT; i++)
+    {
+        counts[i] = atomic_load_explicit(&_buckets[i], memory_order_relaxed);
+        count += counts[i];
+    }
+    
+    uint64_t max = atomic_load_explicit(&_max, memory_order_relaxed);
+    uint64_t rank = MAX((uint64_t)ceil(percentile * count), 1);
+    uint64_t seen = 0;
+    
+    for (NSUInteger i = 0; i < BUCKET_COUNT && count; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return MIN(bucketUpperBound(i), max);
+        }
+    }
+    
+    return max;
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)summary
+{
+    uint64_t count = [self count];
+    uint64_t minPlusOne = atomic_load_explicit(&_minPlusOne, memory_order_relaxed);
+    
+    return @{ @"count" : @(count),
+              @"min_us" : @(minPlusOne ? minPlusOne - 1 : 0),
+              @"max_us" : @(atomic_load_explicit(&_max, memory_order_relaxed)),
+              @"mean_us" : @(count ? atomic_load_explicit(&_total, memory_order_relaxed) / count : 0),
+              @"p50_us" : @([self percentile:0.5]),
+              @"p90_us" : @([self percentile:0.9]),
+              @"p99_us" : @([self percentile:0.99]) };
+}
+
+- (void)reset
+{
+    for (NSUInteger i = 0; i < BUCKET_COUNT; i++)
+    {
+        atomic_store_explicit(&_buckets[i], 0, memory_order_relaxed);
+    }
+    
+    atomic_store_explicit(&_count, 0, memory_order_relaxed);
+    atomic_store_explicit(&_total, 0, memory_order_relaxed);
+    atomic_store_explicit(&_minPlusOne, 0, memory_order_relaxed);
+    atomic_store_explicit(&_max, 0, memory_order_relaxed);
+}
+
+@end
@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "ADALAuthenticationResult.h"
+
+#define ADAL_LATENCY_PHASE_ACQUIRE_TOKEN            @"acquire_token"
+#define ADAL_LATENCY_PHASE_AUTHORITY_VALIDATION     @"authority_validation"
+#define ADAL_LATENCY_PHASE_CACHE_LOOKUP             @"cache_lookup"
+#define ADAL_LATENCY_PHASE_GRANT_REFRESH_TOKEN      @"grant_refresh_token"
+#define ADAL_LATENCY_PHASE_GRANT_MRRT               @"grant_mrrt"
+#define ADAL_LATENCY_PHASE_GRANT_FRT                @"grant_frt"
+#define ADAL_LATENCY_PHASE_GRANT_AUTHORIZATION_CODE @"grant_authorization_code"
+#define ADAL_LATENCY_PHASE_HTTP                     @"http"
+#define ADAL_LATENCY_PHASE_BROKER                   @"broker"
+
+/*!
+ Process wide latency histograms of acquire token phases, one per phase, API ID and status.
+ Each is an ADALHistogram, timestamps come from [ADALHistogram now].
+ */
+@interface ADALLatencyStatistics : NSObject
+
++ (void)recordPhase:(NSString *)phase
+              since:(uint64_t)start
+              apiId:(NSString *)apiId
+             status:(NSString *)status;
+
++ (void)recordPhase:(NSString *)phase
+       microseconds:(uint64_t)microseconds
+              apiId:(NSString *)apiId
+             status:(NSString *)status;
+
+/*! succeeded, failed or cancelled */
++ (NSString *)statusForResult:(ADALAuthenticationResult *)result;
+
+/*! 1xx to 5xx, or other for codes outside of those classes */
++ (NSString *)statusForHTTPStatusCode:(NSInteger)statusCode;
+
+/*!
+ Histograms keyed by <phase>.<apiId>.<status>, each with count, min_us, max_us, mean_us,
+ p50_us, p90_us and p99_us.
+ */
++ (NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *)snapshot;
++ (void)reset;
+
+@end
@@ -0,0 +1,143 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALLatencyStatistics.h"
+#import "ADALHistogram.h"
+#import <os/lock.h>
+
+// Most distinct phase, API ID and status combinations tracked, later ones are dropped
+#define MAX_HISTOGRAMS      512
+
+static os_unfair_lock s_lock = OS_UNFAIR_LOCK_INIT;
+// Phase -> API ID -> status -> histogram, so recording looks up the parts without building a key
+static NSMutableDictionary<NSString *, NSMutableDictionary<NSString *, NSMutableDictionary<NSString *, ADALHistogram *> *> *> *s_histograms = nil;
+static NSUInteger s_histogramCount = 0;
+
+@implementation ADALLatencyStatistics
+
++ (void)recordPhase:(NSString *)phase
+              since:(uint64_t)start
+              apiId:(NSString *)apiId
+             status:(NSString *)status
+{
+    [self recordPhase:phase microseconds:([ADALHistogram now] - start) / NSEC_PER_USEC apiId:apiId status:status];
+}
+
++ (void)recordPhase:(NSString *)phase
+       microseconds:(uint64_t)microseconds
+              apiId:(NSString *)apiId
+             status:(NSString *)status
+{
+    apiId = apiId ?: @"unknown";
+    status = status ?: @"unknown";
+    
+    os_unfair_lock_lock(&s_lock);
+    if (!s_histograms)
+    {
+        s_histograms = [NSMutableDictionary new];
+    }
+    
+    NSMutableDictionary *apiIds = s_histograms[phase];
+    if (!apiIds)
+    {
+        apiIds = [NSMutableDictionary new];
+        s_histograms[phase] = apiIds;
+    }
+    
+    NSMutableDictionary *statuses = apiIds[apiId];
+    if (!statuses)
+    {
+        statuses = [NSMutableDictionary new];
+        apiIds[apiId] = statuses;
+    }
+    
+    ADALHistogram *histogram = statuses[status];
+    if (!histogram && s_histogramCount < MAX_HISTOGRAMS)
+    {
+        histogram = [ADALHistogram new];
+        statuses[status] = histogram;
+        s_histogramCount++;
+    }
+    os_unfair_lock_unlock(&s_lock);
+    
+    // Histograms are lock free and never removed while the process runs, reset only clears them
+    [histogram record:microseconds];
+}
+
++ (NSString *)statusForResult:(ADALAuthenticationResult *)result
+{
+    switch (result.status)
+    {
+        case AD_SUCCEEDED: return @"succeeded";
+        case AD_USER_CANCELLED: return @"cancelled";
+        default: return @"failed";
+    }
+}
+
++ (NSString *)statusForHTTPStatusCode:(NSInteger)statusCode
+{
+    switch (statusCode / 100)
+    {
+        case 1: return @"1xx";
+        case 2: return @"2xx";
+        case 3: return @"3xx";
+        case 4: return @"4xx";
+        case 5: return @"5xx";
+        default: return @"other";
+    }
+}
+
++ (NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *)snapshot
+{
+    NSMutableDictionary *snapshot = [NSMutableDictionary new];
+    
+    os_unfair_lock_lock(&s_lock);
+    [s_histograms enumerateKeysAndObjectsUsingBlock:^(NSString *phase, NSDictionary *apiIds, __unused BOOL *stop) {
+        [apiIds enumerateKeysAndObjectsUsingBlock:^(NSString *apiId, NSDictionary *statuses, __unused BOOL *stop) {
+            [statuses enumerateKeysAndObjectsUsingBlock:^(NSString *status, ADALHistogram *histogram, __unused BOOL *stop) {
+                if ([histogram count])
+                {
+                    snapshot[[NSString stringWithFormat:@"%@.%@.%@", phase, apiId, status]] = [histogram summary];
+                }
+            }];
+        }];
+    }];
+    os_unfair_lock_unlock(&s_lock);
+    
+    return snapshot;
+}
+
++ (void)reset
+{
+    os_unfair_lock_lock(&s_lock);
+    [s_histograms enumerateKeysAndObjectsUsingBlock:^(__unused NSString *phase, NSDictionary *apiIds, __unused BOOL *stop) {
+        [apiIds enumerateKeysAndObjectsUsingBlock:^(__unused NSString *apiId, NSDictionary *statuses, __unused BOOL *stop) {
+            [statuses enumerateKeysAndObjectsUsingBlock:^(__unused NSString *status, ADALHistogram *histogram, __unused BOOL *stop) {
+                [histogram reset];
+            }];
+        }];
+    }];
+    os_unfair_lock_unlock(&s_lock);
+}
+
+@end
@@ -26,8 +26,17 @@
 #import "MSIDTelemetry+Internal.h"
 #import "ADALDefaultDispatcher.h"
 #import "ADALAggregatedDispatcher.h"
+#import "ADALCacheStatistics.h"
+#import "ADALTelemetrySampler.h"
+#import "ADALLatencyStatistics.h"
+#import "ADALTrace.h"
 
 @implementation ADALTelemetry
+{
+    // Wrappers of the dispatchers handed to us by the app, to know whether any are registered
+    // and to flush the asynchronous ones when they are removed or the app terminates
+    NSMutableArray<ADALDefaultDispatcher *> *_dispatchers;
+}
 
 - (id)init
 {
@@ -38,7 +47,24 @@
 
 -(id)initInternal
 {
-    return [super init];
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _dispatchers = [NSMutableArray new];
+    
+#if TARGET_OS_IPHONE
+    NSNotificationName terminateNotification = UIApplicationWillTerminateNotification;
+#else
+    NSNotificationName terminateNotification = NSApplicationWillTerminateNotification;
+#endif
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(flushPendingEvents)
+                                                 name:terminateNotification
+                                               object:nil];
+    
+    return self;
 }
 
 + (ADALTelemetry*)sharedInstance
@@ -55,29 +81,163 @@
 
 - (void)addDispatcher:(nonnull id<ADDispatcher>)dispatcher
        aggregationRequired:(BOOL)aggregationRequired
+{
+    [self addDispatcher:dispatcher aggregationRequired:aggregationRequired dispatchAsynchronously:NO];
+}
+
+- (void)addDispatcher:(nonnull id<ADDispatcher>)dispatcher
+  aggregationRequired:(BOOL)aggregationRequired
+dispatchAsynchronously:(BOOL)dispatchAsynchronously
 {
     ADALDefaultDispatcher *telemetryDispatcher = nil;
     
     if (aggregationRequired)
     {
-        telemetryDispatcher = [[ADALAggregatedDispatcher alloc] initWithDispatcher:dispatcher];
+        telemetryDispatcher = [[ADALAggregatedDispatcher alloc] initWithDispatcher:dispatcher asynchronous:dispatchAsynchronously];
     }
     else
     {
-        telemetryDispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:dispatcher];
+        telemetryDispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:dispatcher asynchronous:dispatchAsynchronously];
     }
     
     [[MSIDTelemetry sharedInstance] addDispatcher:telemetryDispatcher];
+    
+    @synchronized(self)
+    {
+        [_dispatchers addObject:telemetryDispatcher];
+        [ADALTelemetrySampler setDispatchersRegistered:YES];
+    }
 }
 
 - (void)removeDispatcher:(nonnull id<ADDispatcher>)dispatcher
 {
     [[MSIDTelemetry sharedInstance] findAndRemoveDispatcher:dispatcher];
+    
+    NSMutableArray<ADALDefaultDispatcher *> *removedDispatchers = [NSMutableArray new];
+    
+    @synchronized(self)
+    {
+        for (ADALDefaultDispatcher *telemetryDispatcher in _dispatchers)
+        {
+            if ([telemetryDispatcher containsDispatcher:dispatcher])
+            {
+                [removedDispatchers addObject:telemetryDispatcher];
+            }
+        }
+        [_dispatchers removeObjectsInArray:removedDispatchers];
+        [ADALTelemetrySampler setDispatchersRegistered:_dispatchers.count > 0];
+    }
+    
+    // Events already queued for the dispatcher are still delivered to it
+    [removedDispatchers makeObjectsPerformSelector:@selector(flushPendingEvents)];
 }
 
 - (void)removeAllDispatchers
 {
     [[MSIDTelemetry sharedInstance] removeAllDispatchers];
+    
+    NSArray<ADALDefaultDispatcher *> *removedDispatchers = nil;
+    
+    @synchronized(self)
+    {
+        removedDispatchers = [_dispatchers copy];
+        [_dispatchers removeAllObjects];
+        [ADALTelemetrySampler setDispatchersRegistered:NO];
+    }
+    
+    [removedDispatchers makeObjectsPerformSelector:@selector(flushPendingEvents)];
+}
+
+- (void)flushPendingEvents
+{
+    NSArray<ADALDefaultDispatcher *> *dispatchers = nil;
+    
+    @synchronized(self)
+    {
+        dispatchers = [_dispatchers copy];
+    }
+    
+    [dispatchers makeObjectsPerformSelector:@selector(flushPendingEvents)];
+}
+
+- (ADALTraceCallback)traceCallback
+{
+    return [ADALTrace callback];
+}
+
+- (void)setTraceCallback:(ADALTraceCallback)traceCallback
+{
+    [ADALTrace setCallback:traceCallback];
+}
+
+- (NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *)latencyStatistics
+{
+    return [ADALLatencyStatistics snapshot];
+}
+
+- (void)resetLatencyStatistics
+{
+    [ADALLatencyStatistics reset];
+}
+
+- (double)samplingRate
+{
+    return [ADALTelemetrySampler defaultRate];
+}
+
+- (void)setSamplingRate:(double)samplingRate
+{
+    [ADALTelemetrySampler setDefaultRate:samplingRate];
+}
+
+- (void)setSamplingRate:(double)samplingRate forEventName:(NSString *)eventName
+{
+    [ADALTelemetrySampler setRate:samplingRate forEventName:eventName];
+}
+
+- (BOOL)samplingKeepsFailures
+{
+    return [ADALTelemetrySampler keepsFailures];
+}
+
+- (void)setSamplingKeepsFailures:(BOOL)samplingKeepsFailures
+{
+    [ADALTelemetrySampler setKeepsFailures:samplingKeepsFailures];
+}
+
+- (NSUInteger)pendingAggregatedRequestCount
+{
+    return [ADALAggregatedDispatcher pendingRequestCount];
+}
+
+- (NSUInteger)evictedAggregatedRequestCount
+{
+    return [ADALAggregatedDispatcher evictedRequestCount];
+}
+
+- (NSUInteger)droppedAggregatedEventCount
+{
+    return [ADALAggregatedDispatcher droppedEventCount];
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)cacheStatistics
+{
+    return [ADALCacheStatistics snapshot];
+}
+
+- (void)resetCacheStatistics
+{
+    [ADALCacheStatistics reset];
+}
+
+- (BOOL)cacheStatisticsEventsEnabled
+{
+    return [ADALCacheStatistics eventsEnabled];
+}
+
+- (void)setCacheStatisticsEventsEnabled:(BOOL)cacheStatisticsEventsEnabled
+{
+    [ADALCacheStatistics setEventsEnabled:cacheStatisticsEventsEnabled];
 }
 
 - (BOOL)piiEnabled
@@ -30,5 +30,6 @@
 - (void)setUserInformation:(ADALUserInformation *)userInfo;
 - (void)setProtocolCode:(NSString *)protocolCode;
 - (void)setErrorCode:(NSUInteger)errorCode;
+- (void)setCacheLookupSource:(NSString *)source durationInMicroseconds:(uint64_t)duration;
 
 @end
@@ -30,6 +30,9 @@
 #import "MSIDAuthority.h"
 #import "MSIDAuthorityFactory.h"
 
+#define ADAL_TELEMETRY_KEY_CACHE_LOOKUP_SOURCE      @"cache_lookup_source"
+#define ADAL_TELEMETRY_KEY_CACHE_LOOKUP_DURATION    @"cache_lookup_duration_us"
+
 @implementation ADALTelemetryAPIEvent
 
 - (void)setResultStatus:(ADALAuthenticationResultStatus)status
@@ -69,6 +72,12 @@
     [self setProperty:MSID_TELEMETRY_KEY_API_ERROR_CODE value:errorString];
 }
 
+- (void)setCacheLookupSource:(NSString *)source durationInMicroseconds:(uint64_t)duration
+{
+    [self setProperty:ADAL_TELEMETRY_KEY_CACHE_LOOKUP_SOURCE value:source];
+    [self setProperty:ADAL_TELEMETRY_KEY_CACHE_LOOKUP_DURATION value:[NSString stringWithFormat:@"%llu", duration]];
+}
+
 - (void)setProtocolCode:(NSString *)protocolCode
 {
     [self setProperty:MSID_TELEMETRY_KEY_PROTOCOL_CODE value:protocolCode];
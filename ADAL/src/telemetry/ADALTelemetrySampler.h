@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "MSIDTelemetryEventInterface.h"
+
+/*!
+ Decides which requests have their telemetry collected. The decision is a pure function of the
+ telemetry request ID, so every event of a request agrees, and a request kept at a low rate is
+ also kept by any event type with a higher rate. Call sites check it before building an event,
+ and dispatchers check it again for events built outside ADAL, like IdentityCore's cache events.
+ 
+ acquireToken brackets a request with beginRequest: and endRequest:, which hashes the request ID
+ once and remembers the events kept only because they failed.
+ */
+@interface ADALTelemetrySampler : NSObject
+
+/*! Rate used by event types without their own rate, 1.0 (keep everything) by default */
++ (double)defaultRate;
++ (void)setDefaultRate:(double)rate;
+
+/*! Rate for one event name, a negative rate falls back to the default rate */
++ (double)rateForEventName:(NSString *)eventName;
++ (void)setRate:(double)rate forEventName:(NSString *)eventName;
+
+/*! If YES, events of failed operations are kept even when their request isn't sampled. YES by default */
++ (BOOL)keepsFailures;
++ (void)setKeepsFailures:(BOOL)keepsFailures;
+
+/*!
+ Whether any dispatcher is registered with ADALTelemetry. Without one every event would be
+ thrown away, so both decisions below are NO and call sites skip building events entirely.
+ */
++ (BOOL)dispatchersRegistered;
++ (void)setDispatchersRegistered:(BOOL)dispatchersRegistered;
+
+/*!
+ Called when a request starts. Returns whether any of its telemetry can be collected, NO when
+ no dispatcher is registered. If it returns YES, the request has to be flushed when it ends.
+ */
++ (BOOL)beginRequest:(NSString *)requestId;
++ (void)endRequest:(NSString *)requestId;
+
+/*! Whether to start timing an event, it may still be recorded if the operation fails */
++ (BOOL)shouldStartEvent:(NSString *)eventName requestId:(NSString *)requestId;
+
+/*! Whether to build and record an event for an operation that finished */
++ (BOOL)shouldRecordEvent:(NSString *)eventName requestId:(NSString *)requestId failed:(BOOL)failed;
+
+/*!
+ Same as shouldRecordEvent:requestId:failed:, for an event that was started. When it returns NO
+ the event is stopped without dispatching anything, so MSIDTelemetry doesn't keep its start time.
+ */
++ (BOOL)shouldRecordStartedEvent:(NSString *)eventName requestId:(NSString *)requestId failed:(BOOL)failed;
+
+/*! Whether a dispatcher should pass on an event it received */
++ (BOOL)shouldDispatchEvent:(id<MSIDTelemetryEventInterface>)event requestId:(NSString *)requestId;
+
+/*! Restores the default rates, dispatcher registration is left alone */
++ (void)reset;
+
+@end
@@ -0,0 +1,308 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALTelemetrySampler.h"
+#import "MSIDTelemetry.h"
+#import "MSIDTelemetryBaseEvent.h"
+#import "MSIDTelemetryEventStrings.h"
+#import <os/lock.h>
+#include <stdatomic.h>
+
+// Set on the placeholder events that close a started event nobody records, dispatchers drop them
+#define ADAL_TELEMETRY_KEY_DISCARDED @"discarded"
+
+// The sampling decision of a request, made once in beginRequest:
+@interface ADALSampledRequest : NSObject
+
+@property (nonatomic) double position;
+// Event names kept only because their operation failed, these get past dispatchers unsampled
+@property (nonatomic, readonly) NSMutableSet<NSString *> *keptFailures;
+
+@end
+
+@implementation ADALSampledRequest
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        _keptFailures = [NSMutableSet new];
+    }
+    return self;
+}
+
+@end
+
+static os_unfair_lock s_lock = OS_UNFAIR_LOCK_INIT;
+static double s_defaultRate = 1.0;
+static NSDictionary<NSString *, NSNumber *> *s_eventRates = nil;
+static atomic_bool s_keepsFailures = true;
+// Set while any rate is below 1.0, so the default configuration costs one atomic load
+static atomic_bool s_samplingEnabled = false;
+static atomic_bool s_dispatchersRegistered = false;
+// Requests between beginRequest: and endRequest: while sampling is enabled, guarded by s_lock
+static NSMutableDictionary<NSString *, ADALSampledRequest *> *s_requests = nil;
+
+@implementation ADALTelemetrySampler
+
+#pragma mark - Configuration
+
++ (double)defaultRate
+{
+    os_unfair_lock_lock(&s_lock);
+    double rate = s_defaultRate;
+    os_unfair_lock_unlock(&s_lock);
+    return rate;
+}
+
++ (void)setDefaultRate:(double)rate
+{
+    os_unfair_lock_lock(&s_lock);
+    s_defaultRate = MIN(MAX(rate, 0.0), 1.0);
+    [self updateSamplingEnabled];
+    os_unfair_lock_unlock(&s_lock);
+}
+
++ (double)rateForEventName:(NSString *)eventName
+{
+    os_unfair_lock_lock(&s_lock);
+    double rate = [self lockedRateForEventName:eventName];
+    os_unfair_lock_unlock(&s_lock);
+    return rate;
+}
+
++ (void)setRate:(double)rate forEventName:(NSString *)eventName
+{
+    if (!eventName)
+    {
+        return;
+    }
+    
+    os_unfair_lock_lock(&s_lock);
+    NSMutableDictionary *eventRates = [NSMutableDictionary dictionaryWithDictionary:s_eventRates];
+    eventRates[eventName] = rate < 0 ? nil : @(MIN(rate, 1.0));
+    s_eventRates = eventRates;
+    [self updateSamplingEnabled];
+    os_unfair_lock_unlock(&s_lock);
+}
+
++ (BOOL)keepsFailures
+{
+    return atomic_load_explicit(&s_keepsFailures, memory_order_relaxed);
+}
+
++ (void)setKeepsFailures:(BOOL)keepsFailures
+{
+    atomic_store_explicit(&s_keepsFailures, keepsFailures, memory_order_relaxed);
+}
+
++ (BOOL)dispatchersRegistered
+{
+    return atomic_load_explicit(&s_dispatchersRegistered, memory_order_relaxed);
+}
+
++ (void)setDispatchersRegistered:(BOOL)dispatchersRegistered
+{
+    atomic_store_explicit(&s_dispatchersRegistered, dispatchersRegistered, memory_order_relaxed);
+}
+
++ (void)reset
+{
+    os_unfair_lock_lock(&s_lock);
+    s_defaultRate = 1.0;
+    s_eventRates = nil;
+    [s_requests removeAllObjects];
+    [self updateSamplingEnabled];
+    os_unfair_lock_unlock(&s_lock);
+    
+    [self setKeepsFailures:YES];
+}
+
+// Called with s_lock held
++ (void)updateSamplingEnabled
+{
+    BOOL enabled = s_defaultRate < 1.0;
+    
+    for (NSNumber *rate in s_eventRates.allValues)
+    {
+        enabled |= rate.doubleValue < 1.0;
+    }
+    
+    atomic_store_explicit(&s_samplingEnabled, enabled, memory_order_relaxed);
+}
+
+// Called with s_lock held
++ (double)lockedRateForEventName:(NSString *)eventName
+{
+    NSNumber *rate = eventName ? s_eventRates[eventName] : nil;
+    return rate ? rate.doubleValue : s_defaultRate;
+}
+
+#pragma mark - Decisions
+
+/*
+ FNV-1a of the request ID mapped onto [0, 1). Request IDs are UUIDs, so this is uniform enough
+ and, unlike NSString's hash, stable across processes and OS versions.
+ */
++ (double)positionForRequestId:(NSString *)requestId
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    
+    for (const char *c = requestId.UTF8String; c && *c; c++)
+    {
+        hash ^= (uint8_t)*c;
+        hash *= 0x100000001b3ULL;
+    }
+    
+    return (double)(hash >> 11) / (double)(1ULL << 53);
+}
+
++ (BOOL)isRequestSampled:(NSString *)requestId eventName:(NSString *)eventName
+{
+    return [self isRequestSampled:requestId eventName:eventName keepFailure:NO];
+}
+
+// With keepFailure, a request that isn't sampled remembers eventName as kept for a failure
++ (BOOL)isRequestSampled:(NSString *)requestId eventName:(NSString *)eventName keepFailure:(BOOL)keepFailure
+{
+    if (!atomic_load_explicit(&s_samplingEnabled, memory_order_relaxed))
+    {
+        return YES;
+    }
+    
+    os_unfair_lock_lock(&s_lock);
+    double rate = [self lockedRateForEventName:eventName];
+    ADALSampledRequest *request = requestId ? s_requests[requestId] : nil;
+    double position = request ? request.position : [self positionForRequestId:requestId];
+    BOOL sampled = position < rate;
+    if (!sampled && keepFailure && eventName)
+    {
+        [request.keptFailures addObject:eventName];
+    }
+    os_unfair_lock_unlock(&s_lock);
+    
+    return sampled;
+}
+
++ (BOOL)beginRequest:(NSString *)requestId
+{
+    if (![self dispatchersRegistered])
+    {
+        return NO;
+    }
+    
+    if (requestId && atomic_load_explicit(&s_samplingEnabled, memory_order_relaxed))
+    {
+        ADALSampledRequest *request = [ADALSampledRequest new];
+        request.position = [self positionForRequestId:requestId];
+        
+        os_unfair_lock_lock(&s_lock);
+        if (!s_requests)
+        {
+            s_requests = [NSMutableDictionary new];
+        }
+        s_requests[requestId] = request;
+        os_unfair_lock_unlock(&s_lock);
+    }
+    
+    return YES;
+}
+
++ (void)endRequest:(NSString *)requestId
+{
+    if (!requestId)
+    {
+        return;
+    }
+    
+    os_unfair_lock_lock(&s_lock);
+    [s_requests removeObjectForKey:requestId];
+    os_unfair_lock_unlock(&s_lock);
+}
+
++ (BOOL)shouldStartEvent:(NSString *)eventName requestId:(NSString *)requestId
+{
+    if (![self dispatchersRegistered])
+    {
+        return NO;
+    }
+    
+    return [self keepsFailures] || [self isRequestSampled:requestId eventName:eventName];
+}
+
++ (BOOL)shouldRecordEvent:(NSString *)eventName requestId:(NSString *)requestId failed:(BOOL)failed
+{
+    if (![self dispatchersRegistered])
+    {
+        return NO;
+    }
+    
+    BOOL keepFailure = failed && [self keepsFailures];
+    return [self isRequestSampled:requestId eventName:eventName keepFailure:keepFailure] || keepFailure;
+}
+
++ (BOOL)shouldRecordStartedEvent:(NSString *)eventName requestId:(NSString *)requestId failed:(BOOL)failed
+{
+    if ([self shouldRecordEvent:eventName requestId:requestId failed:failed])
+    {
+        return YES;
+    }
+    
+    [self discardEvent:eventName requestId:requestId];
+    return NO;
+}
+
+// Stops a started event with a placeholder that dispatchers drop
++ (void)discardEvent:(NSString *)eventName requestId:(NSString *)requestId
+{
+    MSIDTelemetryBaseEvent *event = [[MSIDTelemetryBaseEvent alloc] initWithName:eventName requestId:requestId correlationId:nil];
+    [event setProperty:ADAL_TELEMETRY_KEY_DISCARDED value:MSID_TELEMETRY_VALUE_YES];
+    [[MSIDTelemetry sharedInstance] stopEvent:requestId event:event];
+}
+
++ (BOOL)shouldDispatchEvent:(id<MSIDTelemetryEventInterface>)event requestId:(NSString *)requestId
+{
+    if ([event propertyWithName:ADAL_TELEMETRY_KEY_DISCARDED])
+    {
+        return NO;
+    }
+    
+    if (!atomic_load_explicit(&s_samplingEnabled, memory_order_relaxed))
+    {
+        return YES;
+    }
+    
+    NSString *eventName = [event propertyWithName:MSID_TELEMETRY_KEY_EVENT_NAME];
+    
+    os_unfair_lock_lock(&s_lock);
+    ADALSampledRequest *request = requestId ? s_requests[requestId] : nil;
+    BOOL dispatch = !request
+        || request.position < [self lockedRateForEventName:eventName]
+        || (eventName && [request.keptFailures containsObject:eventName]);
+    os_unfair_lock_unlock(&s_lock);
+    
+    return dispatch;
+}
+
+@end
@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "ADALTelemetry.h"
+
+typedef uint64_t ADALTraceSpanId;
+
+/*!
+ Records the phases of an acquire token call as nested spans while a trace callback is set.
+ A span's parent is the innermost span of the same request that was still open when it began.
+ When the request finishes its spans are handed to the callback as trace event JSON, which
+ loads in chrome://tracing, Perfetto and similar viewers.
+ */
+@interface ADALTrace : NSObject
+
++ (ADALTraceCallback)callback;
++ (void)setCallback:(ADALTraceCallback)callback;
+
+/*! Returns 0 without recording anything when no callback is set */
++ (ADALTraceSpanId)beginSpan:(NSString *)name requestId:(NSString *)requestId;
++ (void)endSpan:(ADALTraceSpanId)spanId requestId:(NSString *)requestId status:(NSString *)status;
+
+/*! Hands the request's spans to the callback on a background queue and forgets them */
++ (void)finishRequest:(NSString *)requestId;
+
+/*! Trace event JSON object for the request's spans, spans still open end at the time of the call */
++ (NSDictionary *)traceEventsForRequest:(NSString *)requestId;
+
+@end
@@ -0,0 +1,268 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALTrace.h"
+#import <os/lock.h>
+#import <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+// Requests that never finish are evicted, oldest first, past this many
+#define MAX_TRACED_REQUESTS 64
+// Spans past this in a single request are not recorded
+#define MAX_REQUEST_SPANS   256
+
+@interface ADALTraceSpan : NSObject
+{
+@public
+    ADALTraceSpanId _spanId;
+    ADALTraceSpanId _parentId;
+    NSString *_name;
+    NSString *_status;
+    uint64_t _start;
+    uint64_t _end;
+    uint64_t _threadId;
+}
+
+@end
+
+@implementation ADALTraceSpan
+
+@end
+
+@interface ADALTraceRequest : NSObject
+{
+@public
+    NSMutableArray<ADALTraceSpan *> *_spans;
+    // Spans that have begun and not ended yet, innermost last
+    NSMutableArray<ADALTraceSpan *> *_openSpans;
+    uint64_t _start;
+}
+
+@end
+
+@implementation ADALTraceRequest
+
+@end
+
+static os_unfair_lock s_lock = OS_UNFAIR_LOCK_INIT;
+static NSMutableDictionary<NSString *, ADALTraceRequest *> *s_requests = nil;
+static ADALTraceCallback s_callback = nil;
+static ADALTraceSpanId s_lastSpanId = 0;
+static atomic_bool s_enabled = false;
+
+@implementation ADALTrace
+
++ (uint64_t)now
+{
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
++ (ADALTraceCallback)callback
+{
+    os_unfair_lock_lock(&s_lock);
+    ADALTraceCallback callback = s_callback;
+    os_unfair_lock_unlock(&s_lock);
+    return callback;
+}
+
++ (void)setCallback:(ADALTraceCallback)callback
+{
+    os_unfair_lock_lock(&s_lock);
+    s_callback = [callback copy];
+    if (!s_callback)
+    {
+        [s_requests removeAllObjects];
+    }
+    atomic_store_explicit(&s_enabled, s_callback != nil, memory_order_relaxed);
+    os_unfair_lock_unlock(&s_lock);
+}
+
+#pragma mark - Spans
+
++ (ADALTraceSpanId)beginSpan:(NSString *)name requestId:(NSString *)requestId
+{
+    if (!atomic_load_explicit(&s_enabled, memory_order_relaxed) || !requestId)
+    {
+        return 0;
+    }
+    
+    uint64_t threadId = 0;
+    pthread_threadid_np(NULL, &threadId);
+    
+    ADALTraceSpan *span = [ADALTraceSpan new];
+    span->_name = name;
+    span->_start = [self now];
+    span->_threadId = threadId;
+    
+    os_unfair_lock_lock(&s_lock);
+    ADALTraceRequest *request = [self lockedRequestForId:requestId start:span->_start];
+    if (request->_spans.count < MAX_REQUEST_SPANS)
+    {
+        span->_spanId = ++s_lastSpanId;
+        ADALTraceSpan *parent = request->_openSpans.lastObject;
+        span->_parentId = parent ? parent->_spanId : 0;
+        [request->_spans addObject:span];
+        [request->_openSpans addObject:span];
+    }
+    os_unfair_lock_unlock(&s_lock);
+    
+    return span->_spanId;
+}
+
++ (void)endSpan:(ADALTraceSpanId)spanId requestId:(NSString *)requestId status:(NSString *)status
+{
+    if (!spanId || !requestId)
+    {
+        return;
+    }
+    
+    uint64_t end = [self now];
+    
+    os_unfair_lock_lock(&s_lock);
+    ADALTraceRequest *request = s_requests[requestId];
+    NSMutableArray<ADALTraceSpan *> *openSpans = request ? request->_openSpans : nil;
+    
+    // Spans end in roughly the reverse order they began in, search the open ones from the top
+    for (NSInteger i = (NSInteger)openSpans.count - 1; i >= 0; i--)
+    {
+        ADALTraceSpan *span = openSpans[i];
+        if (span->_spanId == spanId)
+        {
+            span->_end = end;
+            span->_status = status;
+            [openSpans removeObjectAtIndex:i];
+            break;
+        }
+    }
+    os_unfair_lock_unlock(&s_lock);
+}
+
++ (void)finishRequest:(NSString *)requestId
+{
+    if (!atomic_load_explicit(&s_enabled, memory_order_relaxed) || !requestId)
+    {
+        return;
+    }
+    
+    os_unfair_lock_lock(&s_lock);
+    BOOL traced = s_requests[requestId] != nil;
+    ADALTraceCallback callback = s_callback;
+    os_unfair_lock_unlock(&s_lock);
+    
+    if (!traced || !callback)
+    {
+        return;
+    }
+    
+    // Serializing isn't free, keep it off the thread completing the request
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        NSDictionary *trace = [self traceEventsForRequest:requestId];
+        
+        os_unfair_lock_lock(&s_lock);
+        [s_requests removeObjectForKey:requestId];
+        os_unfair_lock_unlock(&s_lock);
+        
+        NSData *json = [NSJSONSerialization dataWithJSONObject:trace options:0 error:nil];
+        if (json)
+        {
+            callback(requestId, json);
+        }
+    });
+}
+
+// Called with s_lock held
++ (ADALTraceRequest *)lockedRequestForId:(NSString *)requestId start:(uint64_t)start
+{
+    if (!s_requests)
+    {
+        s_requests = [NSMutableDictionary new];
+    }
+    
+    ADALTraceRequest *request = s_requests[requestId];
+    if (request)
+    {
+        return request;
+    }
+    
+    if (s_requests.count >= MAX_TRACED_REQUESTS)
+    {
+        __block NSString *oldestRequestId = nil;
+        __block uint64_t oldestStart = UINT64_MAX;
+        [s_requests enumerateKeysAndObjectsUsingBlock:^(NSString *key, ADALTraceRequest *obj, __unused BOOL *stop) {
+            if (obj->_start < oldestStart)
+            {
+                oldestStart = obj->_start;
+                oldestRequestId = key;
+            }
+        }];
+        [s_requests removeObjectForKey:oldestRequestId];
+    }
+    
+    request = [ADALTraceRequest new];
+    request->_spans = [NSMutableArray new];
+    request->_openSpans = [NSMutableArray new];
+    request->_start = start;
+    s_requests[requestId] = request;
+    return request;
+}
+
+#pragma mark - Export
+
++ (NSDictionary *)traceEventsForRequest:(NSString *)requestId
+{
+    uint64_t now = [self now];
+    NSNumber *pid = @(getpid());
+    NSMutableArray *events = [NSMutableArray new];
+    
+    os_unfair_lock_lock(&s_lock);
+    ADALTraceRequest *request = s_requests[requestId];
+    for (ADALTraceSpan *span in request ? request->_spans : nil)
+    {
+        uint64_t end = span->_end ?: now;
+        
+        NSMutableDictionary *args = [NSMutableDictionary new];
+        args[@"span_id"] = @(span->_spanId);
+        args[@"parent_id"] = span->_parentId ? @(span->_parentId) : nil;
+        args[@"status"] = span->_status;
+        args[@"incomplete"] = span->_end ? nil : @YES;
+        
+        // Complete events, timestamps and durations in microseconds
+        [events addObject:@{ @"name" : span->_name ?: @"",
+                             @"cat" : @"adal",
+                             @"ph" : @"X",
+                             @"ts" : @(span->_start / NSEC_PER_USEC),
+                             @"dur" : @((end - span->_start) / NSEC_PER_USEC),
+                             @"pid" : pid,
+                             @"tid" : @(span->_threadId),
+                             @"args" : args }];
+    }
+    os_unfair_lock_unlock(&s_lock);
+    
+    return @{ @"traceEvents" : events,
+              @"displayTimeUnit" : @"ms",
+              @"otherData" : @{ @"request_id" : requestId } };
+}
+
+@end
@@ -31,8 +31,44 @@
 #import "ADAL_Internal.h"
 #import "ADALAuthorityUtils.h"
 
+// Apps work with a handful of authorities, the limit only bounds memory for unexpected input
+#define ADAL_AUTHORITY_MEMO_COUNT_LIMIT 64
+
+typedef NS_ENUM(NSInteger, ADALAuthorityCheckResult)
+{
+    ADALAuthorityCheckValid,
+    ADALAuthorityCheckInvalidURL,
+    ADALAuthorityCheckMissingTenant,
+};
+
 @implementation ADALHelpers
 
++ (NSCache<NSString *, id> *)authorityMemo
+{
+    static NSCache *s_authorityMemo = nil;
+    static dispatch_once_t s_once;
+    
+    dispatch_once(&s_once, ^{
+        s_authorityMemo = [NSCache new];
+        s_authorityMemo.countLimit = ADAL_AUTHORITY_MEMO_COUNT_LIMIT;
+    });
+    
+    return s_authorityMemo;
+}
+
++ (NSCache<NSString *, NSNumber *> *)authorityCheckMemo
+{
+    static NSCache *s_authorityCheckMemo = nil;
+    static dispatch_once_t s_once;
+    
+    dispatch_once(&s_once, ^{
+        s_authorityCheckMemo = [NSCache new];
+        s_authorityCheckMemo.countLimit = ADAL_AUTHORITY_MEMO_COUNT_LIMIT;
+    });
+    
+    return s_authorityCheckMemo;
+}
+
 + (void)removeNullStringFrom:(NSDictionary *)dict
 {
     for (NSString* key in dict.allKeys)
@@ -274,6 +310,31 @@
 }
 
 + (NSString*)canonicalizeAuthority:(NSString *)authority
+{
+    if (!authority)
+    {
+        return nil;
+    }
+    
+    NSString *canonicalAuthority = [self.authorityMemo objectForKey:authority];
+    
+    if (canonicalAuthority)
+    {
+        return canonicalAuthority;
+    }
+    
+    canonicalAuthority = [self canonicalizeAuthorityWithoutMemo:authority];
+    
+    // Only valid authorities are remembered, so that invalid ones keep being logged
+    if (canonicalAuthority)
+    {
+        [self.authorityMemo setObject:canonicalAuthority forKey:[authority copy]];
+    }
+    
+    return canonicalAuthority;
+}
+
++ (NSString *)canonicalizeAuthorityWithoutMemo:(NSString *)authority
 {
     if ([NSString msidIsStringNilOrBlank:authority])
     {
@@ -332,26 +393,50 @@
  Otherwise, returns an error if the protocol is not https or the authority is not a valid URL.*/
 + (ADALAuthenticationError *)checkAuthority:(NSString *)authority
                             correlationId:(NSUUID *)correlationId
+{
+    // The outcome is remembered rather than the error, as the error carries the correlation id
+    NSNumber *checkResult = authority ? [self.authorityCheckMemo objectForKey:authority] : nil;
+    
+    if (!checkResult)
+    {
+        checkResult = @([self checkAuthorityWithoutMemo:authority]);
+        
+        if (authority)
+        {
+            [self.authorityCheckMemo setObject:checkResult forKey:[authority copy]];
+        }
+    }
+    
+    switch (checkResult.integerValue)
+    {
+        case ADALAuthorityCheckInvalidURL:
+            return [ADALAuthenticationError errorFromArgument:authority argumentName:@"authority" correlationId:correlationId];
+        case ADALAuthorityCheckMissingTenant:
+            return [ADALAuthenticationError errorFromAuthenticationError:AD_ERROR_DEVELOPER_INVALID_ARGUMENT
+                                                            protocolCode:nil
+                                                            errorDetails:@"Missing tenant in the authority URL. Please add the tenant or use 'common', e.g. https://login.windows.net/example.com."
+                                                           correlationId:correlationId];
+        default:
+            return nil;
+    }
+}
+
++ (ADALAuthorityCheckResult)checkAuthorityWithoutMemo:(NSString *)authority
 {
     NSURL* fullUrl = [NSURL URLWithString:authority.lowercaseString];
     
-    ADALAuthenticationError* adError = nil;
     if (!fullUrl || ![fullUrl.scheme isEqualToString:@"https"])
     {
-        adError = [ADALAuthenticationError errorFromArgument:authority argumentName:@"authority" correlationId:correlationId];
+        return ADALAuthorityCheckInvalidURL;
     }
-    else
+    
+    NSArray* paths = fullUrl.pathComponents;
+    if (paths.count < 2)
     {
-        NSArray* paths = fullUrl.pathComponents;
-        if (paths.count < 2)
-        {
-            adError = [ADALAuthenticationError errorFromAuthenticationError:AD_ERROR_DEVELOPER_INVALID_ARGUMENT
-                                                             protocolCode:nil
-                                                             errorDetails:@"Missing tenant in the authority URL. Please add the tenant or use 'common', e.g. https://login.windows.net/example.com."
-                                                            correlationId:correlationId];
-        }
+        return ADALAuthorityCheckMissingTenant;
     }
-    return adError;
+    
+    return ADALAuthorityCheckValid;
 }
 
 + (NSString *)stringFromDate:(NSDate *)date
@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/*!
+ Bounded multi-producer, multi-consumer queue of log records. Pushing and popping are lock-free,
+ a record costs one slot claim and one retain, so logging threads never wait on each other or on
+ whoever is draining the buffer.
+ */
+@interface ADALLogRingBuffer : NSObject
+
+/*! Number of slots, the requested capacity rounded up to a power of two */
+@property (readonly) NSUInteger capacity;
+
+/*! Records thrown away because the buffer was full, since creation */
+@property (readonly) NSUInteger droppedCount;
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+/*!
+ Adds a record. When the buffer is full either the oldest record is discarded to make room, or
+ this one is. Either way the loss is counted in droppedCount.
+ 
+ @return NO if the record itself was discarded
+ */
+- (BOOL)pushLevel:(NSInteger)level
+          message:(NSString *)message
+      containsPii:(BOOL)containsPii
+       dropOldest:(BOOL)dropOldest;
+
+/*! Removes the oldest record, NO if the buffer is empty */
+- (BOOL)popLevel:(NSInteger *)level
+         message:(NSString **)message
+     containsPii:(BOOL *)containsPii;
+
+@end
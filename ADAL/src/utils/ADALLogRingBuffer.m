@@ -0,0 +1,216 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "ADALLogRingBuffer.h"
+#include <stdatomic.h>
+
+// Producers that keep losing the race for the oldest slot give up and drop their own record
+#define ADAL_LOG_RING_BUFFER_MAX_EVICTIONS 4
+
+/*
+ Slot sequence numbers follow Vyukov's bounded queue: a slot is free for the producer of
+ position p when its sequence is p, and holds a record for the consumer of position p when its
+ sequence is p + 1. Consuming sets it to p + capacity, handing the slot to the next lap.
+ */
+typedef struct
+{
+    atomic_ullong sequence;
+    void *message;
+    NSInteger level;
+    BOOL containsPii;
+} ADALLogSlot;
+
+@implementation ADALLogRingBuffer
+{
+    ADALLogSlot *_slots;
+    uint64_t _mask;
+    atomic_ullong _enqueuePosition;
+    atomic_ullong _dequeuePosition;
+    atomic_ullong _droppedCount;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    uint64_t slotCount = 2;
+    while (slotCount < capacity)
+    {
+        slotCount <<= 1;
+    }
+    
+    _slots = calloc(slotCount, sizeof(ADALLogSlot));
+    if (!_slots)
+    {
+        return nil;
+    }
+    
+    for (uint64_t i = 0; i < slotCount; i++)
+    {
+        atomic_init(&_slots[i].sequence, i);
+    }
+    
+    _mask = slotCount - 1;
+    atomic_init(&_enqueuePosition, 0);
+    atomic_init(&_dequeuePosition, 0);
+    atomic_init(&_droppedCount, 0);
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    NSString *message = nil;
+    while ([self popLevel:NULL message:&message containsPii:NULL])
+    {
+        message = nil;
+    }
+    
+    free(_slots);
+}
+
+- (NSUInteger)capacity
+{
+    return (NSUInteger)(_mask + 1);
+}
+
+- (NSUInteger)droppedCount
+{
+    return (NSUInteger)atomic_load_explicit(&_droppedCount, memory_order_relaxed);
+}
+
+#pragma mark - Queue
+
+- (BOOL)pushLevel:(NSInteger)level
+          message:(NSString *)message
+      containsPii:(BOOL)containsPii
+       dropOldest:(BOOL)dropOldest
+{
+    for (int evictions = 0; ; evictions++)
+    {
+        if ([self tryPushLevel:level message:message containsPii:containsPii])
+        {
+            return YES;
+        }
+        
+        if (!dropOldest || evictions == ADAL_LOG_RING_BUFFER_MAX_EVICTIONS)
+        {
+            atomic_fetch_add_explicit(&_droppedCount, 1, memory_order_relaxed);
+            return NO;
+        }
+        
+        NSString *evicted = nil;
+        if ([self popLevel:NULL message:&evicted containsPii:NULL])
+        {
+            atomic_fetch_add_explicit(&_droppedCount, 1, memory_order_relaxed);
+        }
+    }
+}
+
+- (BOOL)tryPushLevel:(NSInteger)level
+             message:(NSString *)message
+         containsPii:(BOOL)containsPii
+{
+    uint64_t position = atomic_load_explicit(&_enqueuePosition, memory_order_relaxed);
+    ADALLogSlot *slot = NULL;
+    
+    for (;;)
+    {
+        slot = &_slots[position & _mask];
+        uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t difference = (int64_t)(sequence - position);
+        
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&_enqueuePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The slot still holds the record from the previous lap, the buffer is full
+            return NO;
+        }
+        else
+        {
+            position = atomic_load_explicit(&_enqueuePosition, memory_order_relaxed);
+        }
+    }
+    
+    slot->message = (__bridge_retained void *)message;
+    slot->level = level;
+    slot->containsPii = containsPii;
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    
+    return YES;
+}
+
+- (BOOL)popLevel:(NSInteger *)level
+         message:(NSString **)message
+     containsPii:(BOOL *)containsPii
+{
+    uint64_t position = atomic_load_explicit(&_dequeuePosition, memory_order_relaxed);
+    ADALLogSlot *slot = NULL;
+    
+    for (;;)
+    {
+        slot = &_slots[position & _mask];
+        uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t difference = (int64_t)(sequence - (position + 1));
+        
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&_dequeuePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // Nothing published at this position yet
+            return NO;
+        }
+        else
+        {
+            position = atomic_load_explicit(&_dequeuePosition, memory_order_relaxed);
+        }
+    }
+    
+    NSString *record = (__bridge_transfer NSString *)slot->message;
+    if (level) *level = slot->level;
+    if (containsPii) *containsPii = slot->containsPii;
+    slot->message = NULL;
+    atomic_store_explicit(&slot->sequence, position + _mask + 1, memory_order_release);
+    
+    if (message) *message = record;
+    
+    return YES;
+}
+
+@end
@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <os/lock.h>
+#import "NSString+ADALInterning.h"
+
+// Strings are spread over independently locked stripes by hash, so concurrent decoding
+// of different strings rarely contends on the same lock.
+#define ADAL_INTERNED_STRINGS_STRIPE_COUNT 16
+
+// Authorities, resources and client ids of a single app are few, the limit only protects
+// against unbounded growth when the cache holds items of arbitrary apps. A full stripe
+// evicts an arbitrary entry, which only costs sharing for strings still in use.
+#define ADAL_INTERNED_STRINGS_STRIPE_MAX_COUNT 256
+
+static os_unfair_lock s_stripeLocks[ADAL_INTERNED_STRINGS_STRIPE_COUNT];
+static NSMutableSet<NSString *> *s_stripes[ADAL_INTERNED_STRINGS_STRIPE_COUNT];
+
+@implementation NSString (ADALInterning)
+
+- (NSString *)adInternedString
+{
+    static dispatch_once_t s_once;
+    
+    dispatch_once(&s_once, ^{
+        for (NSUInteger i = 0; i < ADAL_INTERNED_STRINGS_STRIPE_COUNT; i++)
+        {
+            s_stripeLocks[i] = OS_UNFAIR_LOCK_INIT;
+            s_stripes[i] = [NSMutableSet new];
+        }
+    });
+    
+    NSUInteger stripe = self.hash % ADAL_INTERNED_STRINGS_STRIPE_COUNT;
+    NSMutableSet<NSString *> *strings = s_stripes[stripe];
+    
+    os_unfair_lock_lock(&s_stripeLocks[stripe]);
+    NSString *interned = [strings member:self];
+    os_unfair_lock_unlock(&s_stripeLocks[stripe]);
+    
+    if (interned)
+    {
+        return interned;
+    }
+    
+    // Copied outside of the lock, a concurrent caller interning the same string wins the race below
+    NSString *copy = [self copy];
+    
+    os_unfair_lock_lock(&s_stripeLocks[stripe]);
+    interned = [strings member:copy];
+    
+    if (!interned)
+    {
+        if (strings.count >= ADAL_INTERNED_STRINGS_STRIPE_MAX_COUNT)
+        {
+            [strings removeObject:[strings anyObject]];
+        }
+        
+        [strings addObject:copy];
+        interned = copy;
+    }
+    
+    os_unfair_lock_unlock(&s_stripeLocks[stripe]);
+    
+    return interned;
+}
+
+@end
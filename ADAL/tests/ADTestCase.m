@@ -30,6 +30,8 @@
 #import "ADALAuthorityValidation+TestUtil.h"
 #import "ADTestWebAuthController.h"
 #import "ADALLogger.h"
+#import "ADALNegativeLookupCache.h"
+#import "ADALTelemetrySampler.h"
 
 #if TARGET_OS_IPHONE
 #import "ADApplicationTestUtil.h"
@@ -48,6 +50,8 @@
     XCTAssertTrue([ADTestURLSession noResponsesLeft]);
     [ADTestURLSession clearResponses];
     [ADALAuthorityValidation clearAadCache];
+    [[ADALNegativeLookupCache sharedCache] invalidateAll];
+    [ADALTelemetrySampler reset];
     
 #if TARGET_OS_IPHONE
     [ADApplicationTestUtil reset];
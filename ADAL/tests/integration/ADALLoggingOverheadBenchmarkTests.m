@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "XCTestCase+TestHelperMethods.h"
+#import "ADALAllocationCounter.h"
+#import "ADALLogger.h"
+#import "MSIDLegacyTokenCacheAccessor.h"
+#import "MSIDAADV1Oauth2Factory.h"
+#import "ADALAuthenticationContext+TestUtil.h"
+
+#if TARGET_OS_IPHONE
+#import "MSIDKeychainTokenCache+MSIDTestsUtil.h"
+#import "MSIDKeychainTokenCache.h"
+#import "ADLegacyKeychainTokenCache.h"
+#else
+#import "ADALTokenCache+Internal.h"
+#endif
+
+// Silent cache hits per measured block
+#define BENCHMARK_CALLS 200
+
+/*
+ Allocations made by a silent call answered from the cache, with logging off and with verbose
+ logging to a callback. Every allocation call is counted, including the eagerly formatted log
+ messages that are released before the calls return.
+ */
+@interface ADALLoggingOverheadBenchmarkTests : ADTestCase
+
+@property (nonatomic) MSIDLegacyTokenCacheAccessor *tokenCache;
+@property (nonatomic) id<ADALTokenCacheDataSource> cacheDataSource;
+@property (nonatomic) BOOL enableNSLogging;
+
+@end
+
+@implementation ADALLoggingOverheadBenchmarkTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // Only the callback should see messages, console output would dominate the measurement
+    self.enableNSLogging = [ADALLogger getNSLogging];
+    [ADALLogger setNSLogging:NO];
+    
+#if TARGET_OS_IPHONE
+    [MSIDKeychainTokenCache reset];
+    
+    self.cacheDataSource = ADLegacyKeychainTokenCache.defaultKeychainCache;
+    self.tokenCache = [[MSIDLegacyTokenCacheAccessor alloc] initWithDataSource:MSIDKeychainTokenCache.defaultKeychainCache otherCacheAccessors:nil factory:[MSIDAADV1Oauth2Factory new]];
+#else
+    ADALTokenCache *adalTokenCache = [ADALTokenCache new];
+    self.cacheDataSource = adalTokenCache;
+    self.tokenCache = [[MSIDLegacyTokenCacheAccessor alloc] initWithDataSource:adalTokenCache.macTokenCache otherCacheAccessors:nil factory:[MSIDAADV1Oauth2Factory new]];
+#endif
+    
+    ADALAuthenticationError *error = nil;
+    XCTAssertTrue([self.cacheDataSource addOrUpdateItem:[self adCreateCacheItem] correlationId:nil error:&error]);
+    XCTAssertNil(error);
+}
+
+- (void)tearDown
+{
+    [ADALLogger setLoggerCallback:nil];
+    [ADALLogger setPiiEnabled:NO];
+    [ADALLogger setLevel:ADAL_LOG_LEVEL_NO_LOG];
+    [ADALLogger setNSLogging:self.enableNSLogging];
+    
+    [super tearDown];
+}
+
+#pragma mark - Helpers
+
+- (ADALAuthenticationContext *)benchmarkContext
+{
+    ADALAuthenticationContext *context = [[ADALAuthenticationContext alloc] initWithAuthority:TEST_AUTHORITY
+                                                                        validateAuthority:NO
+                                                                                    error:nil];
+    context.tokenCache = self.tokenCache;
+    [context setCorrelationId:TEST_CORRELATION_ID];
+    
+    return context;
+}
+
+- (void)acquireTokenSilentFromContext:(ADALAuthenticationContext *)context
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"acquireTokenSilentWithResource"];
+    
+    [context acquireTokenSilentWithResource:TEST_RESOURCE
+                                   clientId:TEST_CLIENT_ID
+                                redirectUri:TEST_REDIRECT_URL
+                                     userId:TEST_USER_ID
+                            completionBlock:^(ADALAuthenticationResult *result)
+     {
+         XCTAssertEqual(result.status, AD_SUCCEEDED);
+         [expectation fulfill];
+     }];
+    
+    [self waitForExpectations:@[expectation] timeout:1];
+}
+
+/*! Measures the calls with XCTest and returns the allocations per call of the fastest run */
+- (double)measureSilentCacheHits
+{
+    ADALAuthenticationContext *context = [self benchmarkContext];
+    __block uint64_t bestNanoseconds = UINT64_MAX;
+    __block uint64_t allocations = 0;
+    
+    // Warm up the cache lookup and logger singletons outside of the measurement
+    [self acquireTokenSilentFromContext:context];
+    
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        @autoreleasepool
+        {
+            uint64_t allocationsBefore = [ADALAllocationCounter allocationCount];
+            uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+            
+            [self startMeasuring];
+            for (NSUInteger i = 0; i < BENCHMARK_CALLS; i++)
+            {
+                [self acquireTokenSilentFromContext:context];
+            }
+            [self stopMeasuring];
+            
+            uint64_t elapsed = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start;
+            uint64_t allocationsAfter = [ADALAllocationCounter allocationCount];
+            
+            if (elapsed < bestNanoseconds)
+            {
+                bestNanoseconds = elapsed;
+                allocations = allocationsAfter - allocationsBefore;
+            }
+        }
+    }];
+    
+    return (double)allocations / BENCHMARK_CALLS;
+}
+
+#pragma mark - Benchmarks
+
+- (void)testLoggingOverhead_whenLoggingOff
+{
+    [ADALLogger setLevel:ADAL_LOG_LEVEL_NO_LOG];
+    
+    double allocations = [self measureSilentCacheHits];
+    NSLog(@"Silent cache hit with logging off: %.1f allocations per call", allocations);
+}
+
+- (void)testLoggingOverhead_whenVerboseLoggingWithPii
+{
+    [ADALLogger setLevel:ADAL_LOG_LEVEL_VERBOSE];
+    [ADALLogger setPiiEnabled:YES];
+    [ADALLogger setLoggerCallback:^(__unused ADAL_LOG_LEVEL logLevel, __unused NSString *message, __unused BOOL containsPii) {}];
+    
+    double allocations = [self measureSilentCacheHits];
+    NSLog(@"Silent cache hit with verbose logging: %.1f allocations per call", allocations);
+}
+
+@end
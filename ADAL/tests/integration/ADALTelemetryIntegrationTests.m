@@ -611,4 +611,30 @@
     ADAssertStringEquals([dictionary objectForKey:TELEMETRY_KEY(MSID_TELEMETRY_KEY_USER_ID)], [NSString msidHexStringFromData:[[@"id1234" dataUsingEncoding:NSUTF8StringEncoding] msidSHA256]]);
 }
 
+- (void)testRemoveAllDispatchers_whenAggregatedEventsPendingAsynchronously_shouldDeliverThem
+{
+    ADALTelemetryTestDispatcher* dispatcher = [ADALTelemetryTestDispatcher new];
+    [dispatcher setTestCallback:^(NSDictionary* event)
+     {
+         XCTAssertFalse([NSThread isMainThread]);
+         [_receivedEvents addObject:event];
+     }];
+    
+    [[ADALTelemetry sharedInstance] addDispatcher:dispatcher aggregationRequired:YES dispatchAsynchronously:YES];
+    
+    NSString* requestId = [[MSIDTelemetry sharedInstance] generateRequestId];
+    [[MSIDTelemetry sharedInstance] startEvent:requestId eventName:@"testEvent"];
+    [[MSIDTelemetry sharedInstance] stopEvent:requestId
+                                        event:[[MSIDTelemetryHttpEvent alloc] initWithName:MSID_TELEMETRY_EVENT_HTTP_REQUEST
+                                                                                 requestId:requestId
+                                                                             correlationId:nil]];
+    [[MSIDTelemetry sharedInstance] flush:requestId];
+    
+    // Aggregation and delivery happen on the delivery queue, removing the dispatcher waits for both
+    [[ADALTelemetry sharedInstance] removeAllDispatchers];
+    
+    XCTAssertEqual([_receivedEvents count], 1);
+    XCTAssertEqualObjects([_receivedEvents.firstObject objectForKey:TELEMETRY_KEY(MSID_TELEMETRY_KEY_REQUEST_ID)], requestId);
+}
+
 @end
@@ -0,0 +1,160 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "XCTestCase+TestHelperMethods.h"
+#import "ADALTelemetryTestDispatcher.h"
+#import "ADALTelemetrySampler.h"
+#import "MSIDLegacyTokenCacheAccessor.h"
+#import "MSIDAADV1Oauth2Factory.h"
+#import "ADALAuthenticationContext+TestUtil.h"
+
+#if TARGET_OS_IPHONE
+#import "MSIDKeychainTokenCache+MSIDTestsUtil.h"
+#import "MSIDKeychainTokenCache.h"
+#import "ADLegacyKeychainTokenCache.h"
+#else
+#import "ADALTokenCache+Internal.h"
+#endif
+
+// Silent cache hits per measured block, so per call overhead isn't lost in measurement noise
+#define BENCHMARK_CALLS 200
+
+/*
+ Per call cost of telemetry on the cheapest acquireToken path, a silent call answered from the
+ cache. Compare the three configurations to see what a dispatcher adds on top of the zero
+ dispatcher path, which should build no telemetry events at all.
+ */
+@interface ADALTelemetryOverheadBenchmarkTests : ADTestCase
+
+@property (nonatomic) MSIDLegacyTokenCacheAccessor *tokenCache;
+@property (nonatomic) id<ADALTokenCacheDataSource> cacheDataSource;
+
+@end
+
+@implementation ADALTelemetryOverheadBenchmarkTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+#if TARGET_OS_IPHONE
+    [MSIDKeychainTokenCache reset];
+    
+    self.cacheDataSource = ADLegacyKeychainTokenCache.defaultKeychainCache;
+    self.tokenCache = [[MSIDLegacyTokenCacheAccessor alloc] initWithDataSource:MSIDKeychainTokenCache.defaultKeychainCache otherCacheAccessors:nil factory:[MSIDAADV1Oauth2Factory new]];
+#else
+    ADALTokenCache *adalTokenCache = [ADALTokenCache new];
+    self.cacheDataSource = adalTokenCache;
+    self.tokenCache = [[MSIDLegacyTokenCacheAccessor alloc] initWithDataSource:adalTokenCache.macTokenCache otherCacheAccessors:nil factory:[MSIDAADV1Oauth2Factory new]];
+#endif
+    
+    ADALAuthenticationError *error = nil;
+    XCTAssertTrue([self.cacheDataSource addOrUpdateItem:[self adCreateCacheItem] correlationId:nil error:&error]);
+    XCTAssertNil(error);
+}
+
+- (void)tearDown
+{
+    [[ADALTelemetry sharedInstance] removeAllDispatchers];
+    
+    [super tearDown];
+}
+
+#pragma mark - Helpers
+
+- (ADALAuthenticationContext *)benchmarkContext
+{
+    ADALAuthenticationContext *context = [[ADALAuthenticationContext alloc] initWithAuthority:TEST_AUTHORITY
+                                                                        validateAuthority:NO
+                                                                                    error:nil];
+    context.tokenCache = self.tokenCache;
+    [context setCorrelationId:TEST_CORRELATION_ID];
+    
+    return context;
+}
+
+- (void)addDispatcherWithAggregationRequired:(BOOL)aggregationRequired
+{
+    ADALTelemetryTestDispatcher *dispatcher = [ADALTelemetryTestDispatcher new];
+    [dispatcher setTestCallback:^(__unused NSDictionary *event) {}];
+    
+    [[ADALTelemetry sharedInstance] addDispatcher:dispatcher aggregationRequired:aggregationRequired];
+}
+
+- (void)acquireTokenSilentFromContext:(ADALAuthenticationContext *)context
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"acquireTokenSilentWithResource"];
+    
+    [context acquireTokenSilentWithResource:TEST_RESOURCE
+                                   clientId:TEST_CLIENT_ID
+                                redirectUri:TEST_REDIRECT_URL
+                                     userId:TEST_USER_ID
+                            completionBlock:^(ADALAuthenticationResult *result)
+     {
+         XCTAssertEqual(result.status, AD_SUCCEEDED);
+         [expectation fulfill];
+     }];
+    
+    [self waitForExpectations:@[expectation] timeout:1];
+}
+
+- (void)measureSilentCacheHits
+{
+    ADALAuthenticationContext *context = [self benchmarkContext];
+    
+    // Warm up the cache lookup and telemetry singletons outside of the measurement
+    [self acquireTokenSilentFromContext:context];
+    
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < BENCHMARK_CALLS; i++)
+        {
+            [self acquireTokenSilentFromContext:context];
+        }
+    }];
+}
+
+#pragma mark - Benchmarks
+
+- (void)testTelemetryOverhead_whenNoDispatcher
+{
+    XCTAssertFalse([ADALTelemetrySampler dispatchersRegistered]);
+    
+    [self measureSilentCacheHits];
+}
+
+- (void)testTelemetryOverhead_whenDefaultDispatcher
+{
+    [self addDispatcherWithAggregationRequired:NO];
+    
+    [self measureSilentCacheHits];
+}
+
+- (void)testTelemetryOverhead_whenAggregatedDispatcher
+{
+    [self addDispatcherWithAggregationRequired:YES];
+    
+    [self measureSilentCacheHits];
+}
+
+@end
@@ -0,0 +1,341 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALAggregatedDispatcher.h"
+#import "ADALTelemetryTestDispatcher.h"
+#import "ADALAllocationCounter.h"
+#import "MSIDTelemetryHttpEvent.h"
+#import "MSIDTelemetryEventStrings.h"
+
+// Events sent per request in the contention benchmark, roughly one silent acquireToken call
+#define BENCHMARK_EVENTS_PER_REQUEST    8
+#define BENCHMARK_REQUESTS_PER_THREAD   200
+
+@interface ADALAggregatedDispatcherTests : ADTestCase
+
+@end
+
+@implementation ADALAggregatedDispatcherTests
+
+#pragma mark - Helpers
+
+- (ADALAggregatedDispatcher *)dispatcherWithCallback:(TestCallback)callback
+{
+    ADALTelemetryTestDispatcher *testDispatcher = [ADALTelemetryTestDispatcher new];
+    [testDispatcher setTestCallback:callback];
+    return [[ADALAggregatedDispatcher alloc] initWithDispatcher:testDispatcher];
+}
+
+- (void)sendRequest:(NSString *)requestId eventCount:(NSUInteger)eventCount toDispatcher:(ADALAggregatedDispatcher *)dispatcher
+{
+    for (NSUInteger i = 0; i < eventCount; i++)
+    {
+        [dispatcher receive:requestId event:[[MSIDTelemetryHttpEvent alloc] initWithName:MSID_TELEMETRY_EVENT_HTTP_REQUEST
+                                                                                requestId:requestId
+                                                                            correlationId:nil]];
+    }
+    
+    [dispatcher flush:requestId];
+}
+
+- (void)measureConcurrency:(NSUInteger)threadCount
+{
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:nil];
+    NSArray<NSString *> *requestIds = [self requestIds:threadCount * BENCHMARK_REQUESTS_PER_THREAD];
+    
+    [self measureBlock:^{
+        dispatch_apply(threadCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t thread) {
+            for (NSUInteger request = 0; request < BENCHMARK_REQUESTS_PER_THREAD; request++)
+            {
+                [self sendRequest:requestIds[thread * BENCHMARK_REQUESTS_PER_THREAD + request]
+                       eventCount:BENCHMARK_EVENTS_PER_REQUEST
+                     toDispatcher:dispatcher];
+            }
+        });
+    }];
+}
+
+- (NSArray<NSString *> *)requestIds:(NSUInteger)count
+{
+    NSMutableArray *requestIds = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        [requestIds addObject:[NSUUID UUID].UUIDString];
+    }
+    return requestIds;
+}
+
+#pragma mark - Aggregation
+
+- (void)testFlush_whenRequestsReceivedConcurrently_shouldAggregateEachRequestSeparately
+{
+    NSUInteger requestCount = 64;
+    NSArray<NSString *> *requestIds = [self requestIds:requestCount];
+    NSMutableDictionary<NSString *, NSDictionary *> *dispatched = [NSMutableDictionary new];
+    
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:^(NSDictionary *event) {
+        @synchronized (dispatched)
+        {
+            dispatched[event[TELEMETRY_KEY(MSID_TELEMETRY_KEY_REQUEST_ID)]] = event;
+        }
+    }];
+    
+    dispatch_apply(requestCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        [self sendRequest:requestIds[i] eventCount:3 toDispatcher:dispatcher];
+    });
+    
+    XCTAssertEqual(dispatched.count, requestCount);
+    for (NSString *requestId in requestIds)
+    {
+        XCTAssertEqualObjects(dispatched[requestId][TELEMETRY_KEY(MSID_TELEMETRY_KEY_HTTP_EVENT_COUNT)], @"3");
+    }
+}
+
+- (void)testFlush_whenRequestNotReceived_shouldDispatchEmptyAggregate
+{
+    __block NSUInteger dispatchedCount = 0;
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:^(__unused NSDictionary *event) {
+        dispatchedCount++;
+    }];
+    
+    [self sendRequest:@"request" eventCount:1 toDispatcher:dispatcher];
+    [dispatcher flush:@"request"];
+    
+    XCTAssertEqual(dispatchedCount, 2);
+}
+
+- (void)testFlush_whenEventsUpdateProperty_shouldKeepLastValueAndCountEvents
+{
+    __block NSDictionary *dispatched = nil;
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:^(NSDictionary *event) {
+        dispatched = event;
+    }];
+    
+    for (NSString *code in @[ @"500", @"200" ])
+    {
+        MSIDTelemetryHttpEvent *event = [[MSIDTelemetryHttpEvent alloc] initWithName:MSID_TELEMETRY_EVENT_HTTP_REQUEST
+                                                                           requestId:@"request"
+                                                                       correlationId:nil];
+        [event setProperty:MSID_TELEMETRY_KEY_HTTP_RESPONSE_CODE value:code];
+        [dispatcher receive:@"request" event:event];
+    }
+    
+    [dispatcher flush:@"request"];
+    
+    XCTAssertEqualObjects(dispatched[TELEMETRY_KEY(MSID_TELEMETRY_KEY_HTTP_RESPONSE_CODE)], @"200");
+    XCTAssertEqualObjects(dispatched[TELEMETRY_KEY(MSID_TELEMETRY_KEY_HTTP_EVENT_COUNT)], @"2");
+    XCTAssertNotNil(dispatched[TELEMETRY_KEY(MSID_TELEMETRY_KEY_DEVICE_ID)]);
+}
+
+#pragma mark - Eviction
+
+- (void)receiveRequests:(NSArray<NSString *> *)requestIds dispatcher:(ADALAggregatedDispatcher *)dispatcher
+{
+    for (NSString *requestId in requestIds)
+    {
+        [dispatcher receive:requestId event:[[MSIDTelemetryHttpEvent alloc] initWithName:MSID_TELEMETRY_EVENT_HTTP_REQUEST
+                                                                               requestId:requestId
+                                                                           correlationId:nil]];
+    }
+}
+
+- (void)testReceive_whenRequestFlushed_shouldNotBePending
+{
+    NSUInteger pendingBefore = [ADALAggregatedDispatcher pendingRequestCount];
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:nil];
+    NSArray *requestIds = [self requestIds:3];
+    
+    [self receiveRequests:requestIds dispatcher:dispatcher];
+    [self receiveRequests:requestIds dispatcher:dispatcher];
+    XCTAssertEqual([ADALAggregatedDispatcher pendingRequestCount] - pendingBefore, 3);
+    
+    for (NSString *requestId in requestIds)
+    {
+        [dispatcher flush:requestId];
+    }
+    XCTAssertEqual([ADALAggregatedDispatcher pendingRequestCount], pendingBefore);
+}
+
+- (void)testReceive_whenRequestHasTooManyEvents_shouldCountDroppedEvents
+{
+    NSUInteger droppedBefore = [ADALAggregatedDispatcher droppedEventCount];
+    
+    __block NSDictionary *dispatched = nil;
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:^(NSDictionary *event) {
+        dispatched = event;
+    }];
+    
+    [self sendRequest:@"request" eventCount:520 toDispatcher:dispatcher];
+    
+    XCTAssertEqual([ADALAggregatedDispatcher droppedEventCount] - droppedBefore, 8);
+    XCTAssertEqualObjects(dispatched[TELEMETRY_KEY(MSID_TELEMETRY_KEY_HTTP_EVENT_COUNT)], @"512");
+}
+
+- (void)testReceive_whenPendingRequestsExpire_shouldEvictThem
+{
+    NSUInteger pendingBefore = [ADALAggregatedDispatcher pendingRequestCount];
+    NSUInteger evictedBefore = [ADALAggregatedDispatcher evictedRequestCount];
+    
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:nil];
+    dispatcher.maxPendingRequests = 10000;
+    dispatcher.maxPendingAge = 0;
+    
+    // Every new request sweeps the ones received before it
+    [self receiveRequests:[self requestIds:64] dispatcher:dispatcher];
+    
+    NSUInteger evicted = [ADALAggregatedDispatcher evictedRequestCount] - evictedBefore;
+    NSUInteger pending = [ADALAggregatedDispatcher pendingRequestCount] - pendingBefore;
+    XCTAssertGreaterThanOrEqual(evicted, 48);
+    XCTAssertEqual(evicted + pending, 64);
+}
+
+- (void)testFlush_whenOtherStripeHoldsExpiredRequest_shouldEvictIt
+{
+    NSUInteger evictedBefore = [ADALAggregatedDispatcher evictedRequestCount];
+    
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:nil];
+    dispatcher.maxPendingAge = 0.01;
+    
+    [self receiveRequests:@[ @"abandoned" ] dispatcher:dispatcher];
+    [NSThread sleepForTimeInterval:0.05];
+    
+    // No new request lands next to the abandoned one, an unrelated flush still drops it
+    [dispatcher flush:@"unrelated"];
+    
+    XCTAssertEqual([ADALAggregatedDispatcher evictedRequestCount] - evictedBefore, 1);
+}
+
+- (void)testReceive_whenRequestIdsShareStripe_shouldKeepUpToMaxPendingRequests
+{
+    NSUInteger evictedBefore = [ADALAggregatedDispatcher evictedRequestCount];
+    
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:nil];
+    dispatcher.maxPendingRequests = 16;
+    
+    NSMutableArray<NSString *> *requestIds = [NSMutableArray new];
+    for (NSUInteger i = 0; requestIds.count < 16; i++)
+    {
+        NSString *requestId = [NSString stringWithFormat:@"request-%lu", (unsigned long)i];
+        if ((requestId.hash & 15) == 0)
+        {
+            [requestIds addObject:requestId];
+        }
+    }
+    
+    [self receiveRequests:requestIds dispatcher:dispatcher];
+    
+    XCTAssertEqual([ADALAggregatedDispatcher evictedRequestCount] - evictedBefore, 0);
+}
+
+- (void)testReceive_whenTooManyPendingRequests_shouldEvictOldest
+{
+    NSUInteger pendingBefore = [ADALAggregatedDispatcher pendingRequestCount];
+    NSUInteger evictedBefore = [ADALAggregatedDispatcher evictedRequestCount];
+    
+    __block NSDictionary *dispatched = nil;
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:^(NSDictionary *event) {
+        dispatched = event;
+    }];
+    dispatcher.maxPendingRequests = 16;
+    
+    NSArray<NSString *> *requestIds = [self requestIds:64];
+    [self receiveRequests:requestIds dispatcher:dispatcher];
+    
+    NSUInteger evicted = [ADALAggregatedDispatcher evictedRequestCount] - evictedBefore;
+    NSUInteger pending = [ADALAggregatedDispatcher pendingRequestCount] - pendingBefore;
+    XCTAssertEqual(evicted, 48);
+    XCTAssertEqual(pending, 16);
+    
+    // The newest request always survives
+    [dispatcher flush:requestIds.lastObject];
+    XCTAssertEqualObjects(dispatched[TELEMETRY_KEY(MSID_TELEMETRY_KEY_REQUEST_ID)], requestIds.lastObject);
+}
+
+#pragma mark - Aggregation benchmark
+
+/*
+ Aggregates one large request per run and logs the per event CPU time and allocations,
+ which is the cost flush adds on top of the caller's own dispatcher.
+ */
+- (void)testAggregationCost
+{
+    NSUInteger eventCount = 1000;
+    ADALAggregatedDispatcher *dispatcher = [self dispatcherWithCallback:nil];
+    
+    __block uint64_t bestNanoseconds = UINT64_MAX;
+    __block uint64_t allocations = 0;
+    
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        for (NSUInteger i = 0; i < eventCount; i++)
+        {
+            [dispatcher receive:@"request" event:[[MSIDTelemetryHttpEvent alloc] initWithName:MSID_TELEMETRY_EVENT_HTTP_REQUEST
+                                                                                    requestId:@"request"
+                                                                                correlationId:nil]];
+        }
+        
+        @autoreleasepool
+        {
+            uint64_t allocationsBefore = [ADALAllocationCounter allocationCount];
+            uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+            
+            [self startMeasuring];
+            [dispatcher flush:@"request"];
+            [self stopMeasuring];
+            
+            uint64_t elapsed = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start;
+            uint64_t allocationsAfter = [ADALAllocationCounter allocationCount];
+            
+            if (elapsed < bestNanoseconds)
+            {
+                bestNanoseconds = elapsed;
+                allocations = allocationsAfter - allocationsBefore;
+            }
+        }
+    }];
+    
+    NSLog(@"Aggregation: %.1f ns and %.2f allocations per event", (double)bestNanoseconds / eventCount, (double)allocations / eventCount);
+}
+
+#pragma mark - Contention benchmark
+
+/*
+ Each thread pushes its own requests through receive and flush. With per-request stripes the
+ time per run should grow with the total number of events, not with lock contention between threads.
+ */
+- (void)testContention_1Thread
+{
+    [self measureConcurrency:1];
+}
+
+- (void)testContention_4Threads
+{
+    [self measureConcurrency:4];
+}
+
+- (void)testContention_16Threads
+{
+    [self measureConcurrency:16];
+}
+
+@end
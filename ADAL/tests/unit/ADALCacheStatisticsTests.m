@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALCacheStatistics.h"
+#import "ADALHistogram.h"
+#import "ADALTelemetry.h"
+#import "XCTestCase+TestHelperMethods.h"
+
+@interface ADALCacheStatisticsTests : ADTestCase
+
+@end
+
+@implementation ADALCacheStatisticsTests
+
+- (void)setUp
+{
+    [super setUp];
+    [ADALCacheStatistics reset];
+}
+
+- (void)tearDown
+{
+    [ADALCacheStatistics reset];
+    [super tearDown];
+}
+
+- (void)testSnapshot_whenCountersIncremented_shouldReturnCounts
+{
+    [ADALCacheStatistics increment:ADALCacheCounterSilentAccessTokenHit];
+    [ADALCacheStatistics increment:ADALCacheCounterSilentAccessTokenHit];
+    [ADALCacheStatistics add:5 toCounter:ADALCacheCounterItemsRead];
+    [ADALCacheStatistics set:7 forGauge:ADALCacheGaugeItemCount];
+    [ADALCacheStatistics set:3 forGauge:ADALCacheGaugeItemCount];
+    
+    NSDictionary *snapshot = [[ADALTelemetry sharedInstance] cacheStatistics];
+    
+    XCTAssertEqualObjects(snapshot[@"silent_access_token_hits"], @2);
+    XCTAssertEqualObjects(snapshot[@"cache_items_read"], @5);
+    XCTAssertEqualObjects(snapshot[@"cache_item_count"], @3);
+    XCTAssertEqualObjects(snapshot[@"silent_misses"], @0);
+}
+
+- (void)testSnapshot_whenLatencyRecorded_shouldSummarizeHistogram
+{
+    // A start 50us in the past
+    [ADALCacheStatistics recordSince:[ADALHistogram now] - 50 * NSEC_PER_USEC inHistogram:ADALCacheHistogramRead];
+    
+    NSDictionary *snapshot = [ADALCacheStatistics snapshot];
+    
+    XCTAssertEqualObjects(snapshot[@"cache_read_count"], @1);
+    XCTAssertTrue([snapshot[@"cache_read_min_us"] unsignedLongLongValue] >= 50);
+    XCTAssertEqualObjects(snapshot[@"cache_read_p99_us"], snapshot[@"cache_read_max_us"]);
+    XCTAssertEqualObjects(snapshot[@"cache_serialize_count"], @0);
+    XCTAssertNil(snapshot[@"silent_lookup_count"]);
+}
+
+- (void)testReset_shouldClearCounters
+{
+    [ADALCacheStatistics increment:ADALCacheCounterWrite];
+    
+    [[ADALTelemetry sharedInstance] resetCacheStatistics];
+    
+    XCTAssertEqualObjects([ADALCacheStatistics snapshot][@"cache_writes"], @0);
+}
+
+@end
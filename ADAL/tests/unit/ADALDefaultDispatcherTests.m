@@ -0,0 +1,187 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALDefaultDispatcher.h"
+#import "ADALTelemetryTestDispatcher.h"
+
+@interface ADALTestBatchDispatcher : NSObject <ADDispatcher>
+
+@property (nonatomic, copy) void (^batchCallback)(NSArray<NSDictionary *> *events);
+
+@end
+
+@implementation ADALTestBatchDispatcher
+
+- (void)dispatchEvent:(__unused NSDictionary *)event
+{
+    XCTFail(@"Batches should be delivered through dispatchEvents:");
+}
+
+- (void)dispatchEvents:(NSArray<NSDictionary *> *)events
+{
+    self.batchCallback(events);
+}
+
+@end
+
+@interface ADALDefaultDispatcherTests : ADTestCase
+
+@end
+
+@implementation ADALDefaultDispatcherTests
+
+- (NSDictionary *)event:(NSUInteger)index
+{
+    return @{ @"index" : [NSString stringWithFormat:@"%lu", (unsigned long)index] };
+}
+
+- (void)testDispatchEvent_whenSynchronous_shouldDispatchOnCallingThread
+{
+    __block NSDictionary *dispatched = nil;
+    ADALTelemetryTestDispatcher *testDispatcher = [ADALTelemetryTestDispatcher new];
+    [testDispatcher setTestCallback:^(NSDictionary *event) {
+        dispatched = event;
+    }];
+    
+    ADALDefaultDispatcher *dispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:testDispatcher];
+    [dispatcher dispatchEvent:[self event:1]];
+    
+    XCTAssertEqualObjects(dispatched, @{ TELEMETRY_KEY(@"index") : @"1" });
+}
+
+- (void)testDispatchEvent_whenBatchFills_shouldDeliverBatchInBackground
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"batch"];
+    ADALTestBatchDispatcher *testDispatcher = [ADALTestBatchDispatcher new];
+    testDispatcher.batchCallback = ^(NSArray<NSDictionary *> *events) {
+        XCTAssertFalse([NSThread isMainThread]);
+        XCTAssertEqual(events.count, 3);
+        XCTAssertEqualObjects(events.lastObject, @{ TELEMETRY_KEY(@"index") : @"2" });
+        [expectation fulfill];
+    };
+    
+    ADALDefaultDispatcher *dispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:testDispatcher asynchronous:YES];
+    dispatcher.batchSize = 3;
+    dispatcher.batchInterval = 60;
+    
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        [dispatcher dispatchEvent:[self event:i]];
+    }
+    
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+- (void)testDispatchEvent_whenBatchNotFull_shouldDeliverAfterInterval
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"batch"];
+    ADALTelemetryTestDispatcher *testDispatcher = [ADALTelemetryTestDispatcher new];
+    [testDispatcher setTestCallback:^(NSDictionary *event) {
+        XCTAssertEqualObjects(event, @{ TELEMETRY_KEY(@"index") : @"1" });
+        [expectation fulfill];
+    }];
+    
+    ADALDefaultDispatcher *dispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:testDispatcher asynchronous:YES];
+    dispatcher.batchInterval = 0.1;
+    [dispatcher dispatchEvent:[self event:1]];
+    
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+- (void)testDispatchEvent_whenSinkFallsBehind_shouldDropOldestEvents
+{
+    dispatch_semaphore_t firstBatchBlocked = dispatch_semaphore_create(0);
+    dispatch_semaphore_t releaseFirstBatch = dispatch_semaphore_create(0);
+    XCTestExpectation *expectation = [self expectationWithDescription:@"second batch"];
+    
+    __block NSUInteger batchCount = 0;
+    ADALTestBatchDispatcher *testDispatcher = [ADALTestBatchDispatcher new];
+    testDispatcher.batchCallback = ^(NSArray<NSDictionary *> *events) {
+        if (++batchCount == 1)
+        {
+            dispatch_semaphore_signal(firstBatchBlocked);
+            dispatch_semaphore_wait(releaseFirstBatch, DISPATCH_TIME_FOREVER);
+            return;
+        }
+        
+        // 10 events were sent while the sink was busy, only the newest 5 are kept
+        XCTAssertEqual(events.count, 5);
+        XCTAssertEqualObjects(events.firstObject, @{ TELEMETRY_KEY(@"index") : @"6" });
+        XCTAssertEqualObjects(events.lastObject, @{ TELEMETRY_KEY(@"index") : @"10" });
+        [expectation fulfill];
+    };
+    
+    ADALDefaultDispatcher *dispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:testDispatcher asynchronous:YES];
+    dispatcher.batchSize = 1;
+    dispatcher.queueLimit = 5;
+    dispatcher.batchInterval = 60;
+    
+    [dispatcher dispatchEvent:[self event:0]];
+    dispatch_semaphore_wait(firstBatchBlocked, DISPATCH_TIME_FOREVER);
+    
+    for (NSUInteger i = 1; i <= 10; i++)
+    {
+        [dispatcher dispatchEvent:[self event:i]];
+    }
+    dispatch_semaphore_signal(releaseFirstBatch);
+    
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+- (void)testFlushPendingEvents_whenBatchNotFull_shouldDeliverBeforeReturning
+{
+    __block NSDictionary *dispatched = nil;
+    ADALTelemetryTestDispatcher *testDispatcher = [ADALTelemetryTestDispatcher new];
+    [testDispatcher setTestCallback:^(NSDictionary *event) {
+        dispatched = event;
+    }];
+    
+    ADALDefaultDispatcher *dispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:testDispatcher asynchronous:YES];
+    dispatcher.batchInterval = 60;
+    [dispatcher dispatchEvent:[self event:1]];
+    [dispatcher flushPendingEvents];
+    
+    XCTAssertEqualObjects(dispatched, @{ TELEMETRY_KEY(@"index") : @"1" });
+}
+
+- (void)testDispatchEvent_whenEventChangesAfterQueued_shouldDeliverQueuedProperties
+{
+    __block NSDictionary *dispatched = nil;
+    ADALTelemetryTestDispatcher *testDispatcher = [ADALTelemetryTestDispatcher new];
+    [testDispatcher setTestCallback:^(NSDictionary *event) {
+        dispatched = event;
+    }];
+    
+    ADALDefaultDispatcher *dispatcher = [[ADALDefaultDispatcher alloc] initWithDispatcher:testDispatcher asynchronous:YES];
+    dispatcher.batchInterval = 60;
+    
+    NSMutableDictionary *properties = [[self event:1] mutableCopy];
+    [dispatcher dispatchEvent:properties];
+    properties[@"index"] = @"2";
+    [dispatcher flushPendingEvents];
+    
+    XCTAssertEqualObjects(dispatched, @{ TELEMETRY_KEY(@"index") : @"1" });
+}
+
+@end
@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "XCTestCase+TestHelperMethods.h"
+#import "ADALTokenCacheItem.h"
+#import "ADALUserInformation.h"
+
+#if TARGET_OS_IPHONE
+#import "ADALKeychainTokenCache.h"
+#import "ADALKeychainTokenCache+Internal.h"
+typedef ADALKeychainTokenCache ADALSweepTestCache;
+#else
+#import "ADALTokenCache.h"
+typedef ADALTokenCache ADALSweepTestCache;
+#endif
+
+@interface ADALExpiredItemsSweepTests : ADTestCase
+{
+    ADALSweepTestCache *mStore;
+}
+@end
+
+@implementation ADALExpiredItemsSweepTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    mStore = [ADALSweepTestCache new];
+#if TARGET_OS_IPHONE
+    [mStore testRemoveAll:nil];
+#endif
+}
+
+- (void)tearDown
+{
+#if TARGET_OS_IPHONE
+    [mStore testRemoveAll:nil];
+#endif
+    mStore = nil;
+    
+    [super tearDown];
+}
+
+- (NSArray<ADALTokenCacheItem *> *)allItems
+{
+    ADALAuthenticationError *error = nil;
+    NSArray *all = [mStore allItems:&error];
+    XCTAssertNil(error);
+    XCTAssertNotNil(all);
+    
+    return all;
+}
+
+- (BOOL)cacheContainsItem:(ADALTokenCacheItem *)item
+{
+    for (ADALTokenCacheItem *read in [self allItems])
+    {
+        if ([read.userInformation.userId isEqualToString:item.userInformation.userId]
+            && [read.resource isEqualToString:item.resource]
+            && [read.clientId isEqualToString:item.clientId])
+        {
+            return [read isEqual:item];
+        }
+    }
+    
+    return NO;
+}
+
+- (void)testRemoveExpiredItems_whenExpiredAccessTokenWithoutRefreshToken_shouldRemoveOnlyExpiredItem
+{
+    XCTAssertEqual([self allItems].count, 0);
+    
+    ADALAuthenticationError *error = nil;
+    
+    ADALTokenCacheItem *expiredItem = [self adCreateATCacheItem:@"resource 1" userId:@"eric@contoso.com"];
+    expiredItem.expiresOn = [NSDate dateWithTimeIntervalSinceNow:-3600];
+    XCTAssertTrue([mStore addOrUpdateItem:expiredItem correlationId:nil error:&error]);
+    ADALTokenCacheItem *validItem = [self adCreateATCacheItem:@"resource 2" userId:@"eric@contoso.com"];
+    XCTAssertTrue([mStore addOrUpdateItem:validItem correlationId:nil error:&error]);
+    ADALTokenCacheItem *expiredWithRTItem = [self adCreateCacheItem:@"jack@contoso.com"];
+    expiredWithRTItem.expiresOn = [NSDate dateWithTimeIntervalSinceNow:-3600];
+    XCTAssertTrue([mStore addOrUpdateItem:expiredWithRTItem correlationId:nil error:&error]);
+    ADAssertNoError;
+    XCTAssertEqual([self allItems].count, 3);
+    
+    NSUInteger removedCount = 0;
+    NSUInteger removedBytes = 0;
+    XCTAssertTrue([mStore removeExpiredItems:&removedCount removedBytes:&removedBytes error:&error]);
+    ADAssertNoError;
+    
+    XCTAssertEqual(removedCount, 1);
+    XCTAssertTrue(removedBytes > 0);
+    XCTAssertEqual([self allItems].count, 2);
+    XCTAssertTrue([self cacheContainsItem:validItem]);
+    XCTAssertTrue([self cacheContainsItem:expiredWithRTItem]);
+    XCTAssertFalse([self cacheContainsItem:expiredItem]);
+}
+
+@end
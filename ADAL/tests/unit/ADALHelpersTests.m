@@ -26,6 +26,12 @@
 #import "XCTestCase+TestHelperMethods.h"
 #import "NSBundle+ADTestUtils.h"
 
+@interface ADALHelpers (Memo)
+
++ (NSString *)canonicalizeAuthorityWithoutMemo:(NSString *)authority;
+
+@end
+
 @interface ADALHelpersTests : ADTestCase
 
 @end
@@ -111,6 +117,51 @@
     ADAssertStringEquals([ADALHelpers canonicalizeAuthority:@"https://login.windows.net/common?abc=123&vc=3"], authority);
 }
 
+- (void)testCanonicalizeAuthority_whenCalledTwice_shouldReturnMemoizedValue
+{
+    NSMutableString *authority = [@"https://login.windows.Net/Contoso.com/" mutableCopy];
+    NSString *canonicalAuthority = [ADALHelpers canonicalizeAuthority:authority];
+    ADAssertStringEquals(canonicalAuthority, @"https://login.windows.net/contoso.com");
+    XCTAssertTrue([ADALHelpers canonicalizeAuthority:@"https://login.windows.Net/Contoso.com/"] == canonicalAuthority);
+    
+    // The memo must not be affected by changes of the input
+    [authority setString:@"https://login.windows.net/other.com"];
+    ADAssertStringEquals([ADALHelpers canonicalizeAuthority:authority], @"https://login.windows.net/other.com");
+}
+
+- (void)testCheckAuthority_whenCalledTwice_shouldReturnSameOutcome
+{
+    XCTAssertNil([ADALHelpers checkAuthority:@"https://login.windows.net/common" correlationId:nil]);
+    XCTAssertNil([ADALHelpers checkAuthority:@"https://login.windows.net/common" correlationId:nil]);
+    
+    XCTAssertNotNil([ADALHelpers checkAuthority:@"https://login.windows.net" correlationId:[NSUUID UUID]]);
+    ADALAuthenticationError *error = [ADALHelpers checkAuthority:@"https://login.windows.net" correlationId:[NSUUID UUID]];
+    XCTAssertEqual(error.code, AD_ERROR_DEVELOPER_INVALID_ARGUMENT);
+    XCTAssertTrue([error.errorDetails containsString:@"Missing tenant"]);
+    
+    XCTAssertNotNil([ADALHelpers checkAuthority:@"http://login.windows.net/common" correlationId:nil]);
+}
+
+- (void)testPerformanceCanonicalizeAuthority_withMemo
+{
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; i++)
+        {
+            [ADALHelpers canonicalizeAuthority:@"https://login.microsoftonline.com/contoso.com"];
+        }
+    }];
+}
+
+- (void)testPerformanceCanonicalizeAuthority_withoutMemo
+{
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; i++)
+        {
+            [ADALHelpers canonicalizeAuthorityWithoutMemo:@"https://login.microsoftonline.com/contoso.com"];
+        }
+    }];
+}
+
 
 - (void)testGetSuffix
 {
@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALLatencyStatistics.h"
+
+@interface ADALLatencyStatisticsTests : ADTestCase
+
+@end
+
+@implementation ADALLatencyStatisticsTests
+
+- (void)setUp
+{
+    [super setUp];
+    [ADALLatencyStatistics reset];
+}
+
+- (void)tearDown
+{
+    [ADALLatencyStatistics reset];
+    [super tearDown];
+}
+
+- (void)testSnapshot_whenUniformLatencies_shouldReportPercentilesWithinPrecision
+{
+    for (uint64_t us = 1; us <= 1000; us++)
+    {
+        [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_HTTP microseconds:us apiId:@"1" status:@"2xx"];
+    }
+    
+    NSDictionary *histogram = [ADALLatencyStatistics snapshot][@"http.1.2xx"];
+    
+    XCTAssertEqualObjects(histogram[@"count"], @1000);
+    XCTAssertEqualObjects(histogram[@"min_us"], @1);
+    XCTAssertEqualObjects(histogram[@"max_us"], @1000);
+    XCTAssertEqualObjects(histogram[@"mean_us"], @500);
+    XCTAssertEqualWithAccuracy([histogram[@"p50_us"] doubleValue], 500, 500 * 0.07);
+    XCTAssertEqualWithAccuracy([histogram[@"p90_us"] doubleValue], 900, 900 * 0.07);
+    XCTAssertEqualWithAccuracy([histogram[@"p99_us"] doubleValue], 990, 990 * 0.07);
+}
+
+- (void)testSnapshot_whenSmallLatencies_shouldBeExact
+{
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_CACHE_LOOKUP microseconds:3 apiId:@"1" status:@"succeeded"];
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_CACHE_LOOKUP microseconds:7 apiId:@"1" status:@"succeeded"];
+    
+    NSDictionary *histogram = [ADALLatencyStatistics snapshot][@"cache_lookup.1.succeeded"];
+    XCTAssertEqualObjects(histogram[@"p50_us"], @3);
+    XCTAssertEqualObjects(histogram[@"p99_us"], @7);
+}
+
+- (void)testSnapshot_whenDifferentApiAndStatus_shouldKeepSeparateHistograms
+{
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_ACQUIRE_TOKEN microseconds:10 apiId:@"1" status:@"succeeded"];
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_ACQUIRE_TOKEN microseconds:20 apiId:@"1" status:@"failed"];
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_ACQUIRE_TOKEN microseconds:30 apiId:@"2" status:@"succeeded"];
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_BROKER microseconds:40 apiId:nil status:@"succeeded"];
+    
+    NSDictionary *snapshot = [ADALLatencyStatistics snapshot];
+    NSArray *expectedKeys = @[ @"acquire_token.1.succeeded", @"acquire_token.1.failed", @"acquire_token.2.succeeded", @"broker.unknown.succeeded" ];
+    XCTAssertEqualObjects([NSSet setWithArray:snapshot.allKeys], [NSSet setWithArray:expectedKeys]);
+}
+
+- (void)testStatusForHTTPStatusCode_shouldReturnStatusClass
+{
+    XCTAssertEqualObjects([ADALLatencyStatistics statusForHTTPStatusCode:200], @"2xx");
+    XCTAssertEqualObjects([ADALLatencyStatistics statusForHTTPStatusCode:429], @"4xx");
+    XCTAssertEqualObjects([ADALLatencyStatistics statusForHTTPStatusCode:0], @"other");
+}
+
+- (void)testReset_shouldClearHistograms
+{
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_HTTP microseconds:10 apiId:@"1" status:@"2xx"];
+    [ADALLatencyStatistics reset];
+    
+    XCTAssertEqual([ADALLatencyStatistics snapshot].count, 0);
+}
+
+- (void)testRecord_whenHugeLatency_shouldClamp
+{
+    [ADALLatencyStatistics recordPhase:ADAL_LATENCY_PHASE_HTTP microseconds:UINT64_MAX apiId:@"1" status:@"error"];
+    
+    NSDictionary *histogram = [ADALLatencyStatistics snapshot][@"http.1.error"];
+    XCTAssertEqualObjects(histogram[@"max_us"], @((1ULL << 40) - 1));
+    XCTAssertEqualObjects(histogram[@"p99_us"], @((1ULL << 40) - 1));
+}
+
+@end
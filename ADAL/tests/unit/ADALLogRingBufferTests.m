@@ -0,0 +1,153 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALLogRingBuffer.h"
+
+@interface ADALLogRingBufferTests : ADTestCase
+
+@end
+
+@implementation ADALLogRingBufferTests
+
+- (void)fillBuffer:(ADALLogRingBuffer *)buffer from:(NSUInteger)first count:(NSUInteger)count dropOldest:(BOOL)dropOldest
+{
+    for (NSUInteger i = first; i < first + count; i++)
+    {
+        [buffer pushLevel:i message:[NSString stringWithFormat:@"%lu", (unsigned long)i] containsPii:NO dropOldest:dropOldest];
+    }
+}
+
+- (NSArray<NSString *> *)drainBuffer:(ADALLogRingBuffer *)buffer
+{
+    NSMutableArray *messages = [NSMutableArray new];
+    NSString *message = nil;
+    
+    while ([buffer popLevel:NULL message:&message containsPii:NULL])
+    {
+        [messages addObject:message];
+    }
+    
+    return messages;
+}
+
+- (void)testInit_whenCapacityNotPowerOfTwo_shouldRoundUp
+{
+    XCTAssertEqual([[ADALLogRingBuffer alloc] initWithCapacity:100].capacity, 128);
+    XCTAssertEqual([[ADALLogRingBuffer alloc] initWithCapacity:64].capacity, 64);
+}
+
+- (void)testPop_whenRecordsPushed_shouldReturnThemInOrder
+{
+    ADALLogRingBuffer *buffer = [[ADALLogRingBuffer alloc] initWithCapacity:8];
+    
+    [buffer pushLevel:2 message:@"first" containsPii:YES dropOldest:YES];
+    [buffer pushLevel:3 message:@"second" containsPii:NO dropOldest:YES];
+    
+    NSInteger level = 0;
+    NSString *message = nil;
+    BOOL containsPii = NO;
+    
+    XCTAssertTrue([buffer popLevel:&level message:&message containsPii:&containsPii]);
+    XCTAssertEqual(level, 2);
+    XCTAssertEqualObjects(message, @"first");
+    XCTAssertTrue(containsPii);
+    
+    XCTAssertTrue([buffer popLevel:&level message:&message containsPii:&containsPii]);
+    XCTAssertEqual(level, 3);
+    XCTAssertEqualObjects(message, @"second");
+    XCTAssertFalse(containsPii);
+    
+    XCTAssertFalse([buffer popLevel:&level message:&message containsPii:&containsPii]);
+}
+
+- (void)testPush_whenFullAndDropOldest_shouldKeepNewestRecords
+{
+    ADALLogRingBuffer *buffer = [[ADALLogRingBuffer alloc] initWithCapacity:4];
+    
+    [self fillBuffer:buffer from:0 count:6 dropOldest:YES];
+    
+    XCTAssertEqualObjects([self drainBuffer:buffer], (@[@"2", @"3", @"4", @"5"]));
+    XCTAssertEqual(buffer.droppedCount, 2);
+}
+
+- (void)testPush_whenFullAndDropNewest_shouldKeepOldestRecords
+{
+    ADALLogRingBuffer *buffer = [[ADALLogRingBuffer alloc] initWithCapacity:4];
+    
+    [self fillBuffer:buffer from:0 count:4 dropOldest:NO];
+    XCTAssertFalse([buffer pushLevel:0 message:@"4" containsPii:NO dropOldest:NO]);
+    
+    XCTAssertEqualObjects([self drainBuffer:buffer], (@[@"0", @"1", @"2", @"3"]));
+    XCTAssertEqual(buffer.droppedCount, 1);
+}
+
+- (void)testPush_whenDrainedBetweenLaps_shouldReuseSlots
+{
+    ADALLogRingBuffer *buffer = [[ADALLogRingBuffer alloc] initWithCapacity:4];
+    
+    for (NSUInteger lap = 0; lap < 10; lap++)
+    {
+        [self fillBuffer:buffer from:lap * 3 count:3 dropOldest:NO];
+        XCTAssertEqual([self drainBuffer:buffer].count, 3);
+    }
+    
+    XCTAssertEqual(buffer.droppedCount, 0);
+}
+
+- (void)testPush_whenConcurrentProducersAndConsumer_shouldAccountForEveryRecord
+{
+    ADALLogRingBuffer *buffer = [[ADALLogRingBuffer alloc] initWithCapacity:64];
+    NSUInteger producers = 8;
+    NSUInteger recordsPerProducer = 2000;
+    __block NSUInteger popped = 0;
+    __block BOOL producing = YES;
+    
+    dispatch_group_t consumer = dispatch_group_create();
+    dispatch_group_async(consumer, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        NSString *message = nil;
+        for (;;)
+        {
+            BOOL stillProducing = __atomic_load_n(&producing, __ATOMIC_ACQUIRE);
+            if ([buffer popLevel:NULL message:&message containsPii:NULL])
+            {
+                popped++;
+            }
+            else if (!stillProducing)
+            {
+                break;
+            }
+        }
+    });
+    
+    dispatch_apply(producers, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t producer) {
+        [self fillBuffer:buffer from:producer * recordsPerProducer count:recordsPerProducer dropOldest:YES];
+    });
+    
+    __atomic_store_n(&producing, NO, __ATOMIC_RELEASE);
+    dispatch_group_wait(consumer, DISPATCH_TIME_FOREVER);
+    
+    XCTAssertEqual(popped + buffer.droppedCount, producers * recordsPerProducer);
+}
+
+@end
@@ -43,6 +43,10 @@
 
 - (void)tearDown
 {
+    // Before the callbacks are cleared, so messages still buffered reach this test's callback
+    [ADALLogger setAsynchronousLogging:NO];
+    [ADALLogger setLogOverflowPolicy:ADAL_LOG_OVERFLOW_DROP_OLDEST];
+    
     [super tearDown];
     
     [ADALLogger setNSLogging:self.enableNSLogging];
@@ -231,4 +235,135 @@
     [self waitForExpectationsWithTimeout:1 handler:nil];
 }
 
+#pragma mark - ADAL_LOG_ENABLED
+
+- (void)testLogEnabled_whenLevelSet_shouldOnlyEnableThatLevelAndBelow
+{
+    [ADALLogger setLevel:ADAL_LOG_LEVEL_WARN];
+    
+    XCTAssertTrue(ADAL_LOG_ENABLED(MSIDLogLevelError));
+    XCTAssertTrue(ADAL_LOG_ENABLED(MSIDLogLevelWarning));
+    XCTAssertFalse(ADAL_LOG_ENABLED(MSIDLogLevelInfo));
+    
+    [ADALLogger setLevel:ADAL_LOG_LEVEL_NO_LOG];
+    
+    XCTAssertFalse(ADAL_LOG_ENABLED(MSIDLogLevelError));
+}
+
+- (void)testLogPiiEnabled_whenPiiDisabled_shouldBeDisabledAtEveryLevel
+{
+    [ADALLogger setLevel:ADAL_LOG_LEVEL_VERBOSE];
+    
+    XCTAssertFalse(ADAL_LOG_PII_ENABLED(MSIDLogLevelError));
+    
+    [ADALLogger setPiiEnabled:YES];
+    
+    XCTAssertTrue(ADAL_LOG_PII_ENABLED(MSIDLogLevelVerbose));
+}
+
+#pragma mark - Asynchronous logging
+
+- (void)testLog_whenAsynchronous_shouldInvokeCallbackOffLoggingThread
+{
+    [ADALLogger setAsynchronousLogging:YES];
+    
+    XCTestExpectation* expectation = [self expectationWithDescription:@"Validate logger callback."];
+    NSThread *loggingThread = [NSThread currentThread];
+    
+    [ADALLogger setLoggerCallback:^(ADAL_LOG_LEVEL logLevel, NSString *message, BOOL containsPii)
+     {
+         XCTAssertNotNil(message);
+         XCTAssertEqual(logLevel, ADAL_LOG_LEVEL_ERROR);
+         XCTAssertFalse(containsPii);
+         XCTAssertNotEqual([NSThread currentThread], loggingThread);
+         
+         [expectation fulfill];
+     }];
+    
+    [[MSIDLogger sharedLogger] logLevel:MSIDLogLevelError context:nil correlationId:nil isPII:NO format:@"message"];
+    
+    [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testFlush_whenAsynchronous_shouldDeliverEveryMessageInOrder
+{
+    [ADALLogger setAsynchronousLogging:YES];
+    
+    NSMutableArray<NSString *> *received = [NSMutableArray new];
+    [ADALLogger setLoggerCallback:^(__unused ADAL_LOG_LEVEL logLevel, NSString *message, __unused BOOL containsPii)
+     {
+         [received addObject:message];
+     }];
+    
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        [[MSIDLogger sharedLogger] logLevel:MSIDLogLevelError context:nil correlationId:nil isPII:NO format:@"message %lu;", (unsigned long)i];
+    }
+    
+    [ADALLogger flush];
+    
+    XCTAssertEqual(received.count, 100);
+    for (NSUInteger i = 0; i < received.count; i++)
+    {
+        XCTAssertTrue([received[i] containsString:[NSString stringWithFormat:@"message %lu;", (unsigned long)i]]);
+    }
+}
+
+- (void)testLog_whenAsynchronousBufferOverflows_shouldCountDrops
+{
+    [ADALLogger setAsynchronousLogging:YES];
+    [ADALLogger setLogOverflowPolicy:ADAL_LOG_OVERFLOW_DROP_NEWEST];
+    
+    dispatch_semaphore_t blockCallback = dispatch_semaphore_create(0);
+    __block BOOL blocked = NO;
+    __block NSUInteger deliveredCount = 0;
+    
+    [ADALLogger setLoggerCallback:^(__unused ADAL_LOG_LEVEL logLevel, NSString *message, __unused BOOL containsPii)
+     {
+         // Hold up the background drain on the first message so the buffer fills up
+         if (!blocked)
+         {
+             blocked = YES;
+             dispatch_semaphore_wait(blockCallback, DISPATCH_TIME_FOREVER);
+         }
+         
+         if ([message containsString:@"overflow"])
+         {
+             deliveredCount++;
+         }
+     }];
+    
+    NSUInteger droppedBefore = [ADALLogger getDroppedLogCount];
+    NSUInteger total = 10000;
+    
+    for (NSUInteger i = 0; i < total; i++)
+    {
+        [[MSIDLogger sharedLogger] logLevel:MSIDLogLevelError context:nil correlationId:nil isPII:NO format:@"overflow"];
+    }
+    
+    dispatch_semaphore_signal(blockCallback);
+    [ADALLogger flush];
+    
+    NSUInteger dropped = [ADALLogger getDroppedLogCount] - droppedBefore;
+    XCTAssertGreaterThan(dropped, 0);
+    XCTAssertEqual(deliveredCount + dropped, total);
+}
+
+- (void)testSetAsynchronousLogging_whenTurnedOff_shouldDeliverBufferedMessages
+{
+    [ADALLogger setAsynchronousLogging:YES];
+    
+    __block NSUInteger deliveredCount = 0;
+    [ADALLogger setLoggerCallback:^(__unused ADAL_LOG_LEVEL logLevel, __unused NSString *message, __unused BOOL containsPii)
+     {
+         deliveredCount++;
+     }];
+    
+    [[MSIDLogger sharedLogger] logLevel:MSIDLogLevelError context:nil correlationId:nil isPII:NO format:@"message"];
+    [ADALLogger setAsynchronousLogging:NO];
+    
+    XCTAssertEqual(deliveredCount, 1);
+    XCTAssertFalse([ADALLogger getAsynchronousLogging]);
+}
+
 @end
@@ -0,0 +1,116 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALNegativeLookupCache.h"
+#import "ADALRequestParameters.h"
+#import "MSIDAccountIdentifier.h"
+#import "XCTestCase+TestHelperMethods.h"
+
+@interface ADALNegativeLookupCacheTests : ADTestCase
+{
+    ADALNegativeLookupCache *mCache;
+    NSObject *mTokenCache;
+}
+
+@end
+
+@implementation ADALNegativeLookupCacheTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    mCache = [ADALNegativeLookupCache new];
+    mCache.timeToLive = 10;
+    mTokenCache = [NSObject new];
+}
+
+- (void)tearDown
+{
+    mCache = nil;
+    mTokenCache = nil;
+    
+    [super tearDown];
+}
+
+- (ADALRequestParameters *)paramsWithUserId:(NSString *)userId resource:(NSString *)resource
+{
+    ADALRequestParameters *params = [ADALRequestParameters new];
+    params.authority = @"https://login.windows.net/contoso.com";
+    params.clientId = @"clientId";
+    params.resource = resource;
+    params.account = userId ? [[MSIDAccountIdentifier alloc] initWithLegacyAccountId:userId homeAccountId:nil] : nil;
+    return params;
+}
+
+- (void)testContainsMiss_whenMissAdded_shouldReturnYesForSameLookupOnly
+{
+    [mCache addMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache writeGeneration:mCache.writeGeneration];
+    
+    XCTAssertTrue([mCache containsMissForParams:[self paramsWithUserId:@"Eric@Contoso.com" resource:@"resource"] tokenCache:mTokenCache]);
+    XCTAssertFalse([mCache containsMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource2"] tokenCache:mTokenCache]);
+    XCTAssertFalse([mCache containsMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:[NSObject new]]);
+}
+
+- (void)testContainsMiss_whenExpired_shouldReturnNo
+{
+    mCache.timeToLive = 0.01;
+    [mCache addMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache writeGeneration:mCache.writeGeneration];
+    
+    [NSThread sleepForTimeInterval:0.02];
+    
+    XCTAssertFalse([mCache containsMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache]);
+}
+
+- (void)testAddMiss_whenTimeToLiveNotSet_shouldNotRememberMiss
+{
+    ADALNegativeLookupCache *cache = [ADALNegativeLookupCache new];
+    [cache addMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache writeGeneration:cache.writeGeneration];
+    
+    XCTAssertFalse([cache containsMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache]);
+}
+
+- (void)testAddMiss_whenInvalidatedSinceLookupStarted_shouldNotRememberMiss
+{
+    uint64_t writeGeneration = mCache.writeGeneration;
+    
+    // A token is written while the lookup that found nothing is still running
+    [mCache invalidateAll];
+    [mCache addMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache writeGeneration:writeGeneration];
+    
+    XCTAssertFalse([mCache containsMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache]);
+}
+
+- (void)testInvalidateAll_shouldDropMissesOfAllUsers
+{
+    [mCache addMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache writeGeneration:mCache.writeGeneration];
+    [mCache addMissForParams:[self paramsWithUserId:nil resource:@"resource"] tokenCache:mTokenCache writeGeneration:mCache.writeGeneration];
+    
+    [mCache invalidateAll];
+    
+    XCTAssertFalse([mCache containsMissForParams:[self paramsWithUserId:@"eric@contoso.com" resource:@"resource"] tokenCache:mTokenCache]);
+    XCTAssertFalse([mCache containsMissForParams:[self paramsWithUserId:nil resource:@"resource"] tokenCache:mTokenCache]);
+}
+
+@end
@@ -82,4 +82,16 @@
     ADAssertStringEquals([event propertyWithName:MSID_TELEMETRY_KEY_USER_ID], [NSString msidHexStringFromData:[[@"eric_cartman@contoso.com" dataUsingEncoding:NSUTF8StringEncoding] msidSHA256]]);
 }
 
+- (void)testSetCacheLookupSource_shouldSetSourceAndDuration
+{
+    ADALTelemetryAPIEvent *event = [[ADALTelemetryAPIEvent alloc] initWithName:@"testEvent1"
+                                                                 requestId:@"requestId"
+                                                             correlationId:[NSUUID UUID]];
+    
+    [event setCacheLookupSource:@"mrrt" durationInMicroseconds:42];
+    
+    ADAssertStringEquals([event propertyWithName:@"cache_lookup_source"], @"mrrt");
+    ADAssertStringEquals([event propertyWithName:@"cache_lookup_duration_us"], @"42");
+}
+
 @end
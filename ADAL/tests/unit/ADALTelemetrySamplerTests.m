@@ -0,0 +1,195 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALTelemetrySampler.h"
+#import "ADALTelemetryTestDispatcher.h"
+#import "MSIDTelemetryBaseEvent.h"
+
+@interface ADALTelemetrySamplerTests : ADTestCase
+
+@end
+
+@implementation ADALTelemetrySamplerTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    [ADALTelemetrySampler setDispatchersRegistered:YES];
+}
+
+- (void)tearDown
+{
+    [ADALTelemetrySampler setDispatchersRegistered:NO];
+    
+    [super tearDown];
+}
+
+- (NSUInteger)sampledCount:(NSArray<NSString *> *)requestIds eventName:(NSString *)eventName
+{
+    NSUInteger count = 0;
+    for (NSString *requestId in requestIds)
+    {
+        count += [ADALTelemetrySampler shouldRecordEvent:eventName requestId:requestId failed:NO];
+    }
+    return count;
+}
+
+- (NSArray<NSString *> *)requestIds:(NSUInteger)count
+{
+    NSMutableArray *requestIds = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        [requestIds addObject:[NSUUID UUID].UUIDString];
+    }
+    return requestIds;
+}
+
+- (void)testShouldRecordEvent_whenDefaultConfiguration_shouldKeepEverything
+{
+    XCTAssertEqual([self sampledCount:[self requestIds:100] eventName:@"event"], 100);
+}
+
+- (void)testShouldRecordEvent_whenRateSet_shouldKeepRoughlyThatFraction
+{
+    [ADALTelemetrySampler setDefaultRate:0.25];
+    
+    NSUInteger sampled = [self sampledCount:[self requestIds:4000] eventName:@"event"];
+    XCTAssertGreaterThan(sampled, 800);
+    XCTAssertLessThan(sampled, 1200);
+}
+
+- (void)testShouldRecordEvent_whenSameRequest_shouldBeDeterministic
+{
+    [ADALTelemetrySampler setDefaultRate:0.5];
+    
+    for (NSString *requestId in [self requestIds:50])
+    {
+        BOOL first = [ADALTelemetrySampler shouldRecordEvent:@"event" requestId:requestId failed:NO];
+        XCTAssertEqual([ADALTelemetrySampler shouldRecordEvent:@"event" requestId:requestId failed:NO], first);
+    }
+}
+
+- (void)testShouldRecordEvent_whenEventRateHigher_shouldKeepEveryRequestOfLowerRate
+{
+    [ADALTelemetrySampler setDefaultRate:0.1];
+    [ADALTelemetrySampler setRate:0.5 forEventName:@"http"];
+    
+    for (NSString *requestId in [self requestIds:500])
+    {
+        if ([ADALTelemetrySampler shouldRecordEvent:@"api" requestId:requestId failed:NO])
+        {
+            XCTAssertTrue([ADALTelemetrySampler shouldRecordEvent:@"http" requestId:requestId failed:NO]);
+        }
+    }
+    
+    [ADALTelemetrySampler setRate:-1 forEventName:@"http"];
+    XCTAssertEqual([ADALTelemetrySampler rateForEventName:@"http"], 0.1);
+}
+
+- (void)testShouldRecordEvent_whenFailedAndKeepsFailures_shouldKeep
+{
+    [ADALTelemetrySampler setDefaultRate:0];
+    
+    XCTAssertFalse([ADALTelemetrySampler shouldRecordEvent:@"event" requestId:@"request" failed:NO]);
+    XCTAssertTrue([ADALTelemetrySampler shouldRecordEvent:@"event" requestId:@"request" failed:YES]);
+    XCTAssertTrue([ADALTelemetrySampler shouldStartEvent:@"event" requestId:@"request"]);
+    
+    [ADALTelemetrySampler setKeepsFailures:NO];
+    
+    XCTAssertFalse([ADALTelemetrySampler shouldRecordEvent:@"event" requestId:@"request" failed:YES]);
+    XCTAssertFalse([ADALTelemetrySampler shouldStartEvent:@"event" requestId:@"request"]);
+}
+
+- (void)testShouldRecordEvent_whenNoDispatcherRegistered_shouldSkipEverything
+{
+    [ADALTelemetrySampler setDispatchersRegistered:NO];
+    
+    XCTAssertFalse([ADALTelemetrySampler shouldStartEvent:@"event" requestId:@"request"]);
+    XCTAssertFalse([ADALTelemetrySampler shouldRecordEvent:@"event" requestId:@"request" failed:NO]);
+    XCTAssertFalse([ADALTelemetrySampler shouldRecordEvent:@"event" requestId:@"request" failed:YES]);
+}
+
+- (void)testShouldDispatchEvent_whenRequestNotSampled_shouldOnlyPassKeptFailures
+{
+    [ADALTelemetrySampler setDefaultRate:0];
+    XCTAssertTrue([ADALTelemetrySampler beginRequest:@"request"]);
+    
+    MSIDTelemetryBaseEvent *cacheEvent = [[MSIDTelemetryBaseEvent alloc] initWithName:@"cache" requestId:@"request" correlationId:nil];
+    MSIDTelemetryBaseEvent *grantEvent = [[MSIDTelemetryBaseEvent alloc] initWithName:@"grant" requestId:@"request" correlationId:nil];
+    XCTAssertFalse([ADALTelemetrySampler shouldDispatchEvent:cacheEvent requestId:@"request"]);
+    XCTAssertFalse([ADALTelemetrySampler shouldDispatchEvent:grantEvent requestId:@"request"]);
+    
+    XCTAssertTrue([ADALTelemetrySampler shouldRecordEvent:@"grant" requestId:@"request" failed:YES]);
+    XCTAssertTrue([ADALTelemetrySampler shouldDispatchEvent:grantEvent requestId:@"request"]);
+    XCTAssertFalse([ADALTelemetrySampler shouldDispatchEvent:cacheEvent requestId:@"request"]);
+    
+    // Once the request ended nothing is remembered for it
+    [ADALTelemetrySampler endRequest:@"request"];
+    XCTAssertTrue([ADALTelemetrySampler shouldDispatchEvent:cacheEvent requestId:@"request"]);
+}
+
+- (void)testShouldDispatchEvent_whenRequestSampled_shouldPassEverything
+{
+    [ADALTelemetrySampler setDefaultRate:0.5];
+    
+    for (NSString *requestId in [self requestIds:50])
+    {
+        [ADALTelemetrySampler beginRequest:requestId];
+        MSIDTelemetryBaseEvent *event = [[MSIDTelemetryBaseEvent alloc] initWithName:@"event" requestId:requestId correlationId:nil];
+        XCTAssertEqual([ADALTelemetrySampler shouldDispatchEvent:event requestId:requestId],
+                       [ADALTelemetrySampler shouldRecordEvent:@"event" requestId:requestId failed:NO]);
+        [ADALTelemetrySampler endRequest:requestId];
+    }
+}
+
+- (void)testBeginRequest_whenNoDispatcherRegistered_shouldNotCollect
+{
+    [ADALTelemetrySampler setDispatchersRegistered:NO];
+    
+    XCTAssertFalse([ADALTelemetrySampler beginRequest:@"request"]);
+}
+
+- (void)testDispatchersRegistered_whenDispatchersAddedAndRemoved_shouldFollowTelemetry
+{
+    [ADALTelemetrySampler setDispatchersRegistered:NO];
+    ADALTelemetryTestDispatcher *first = [ADALTelemetryTestDispatcher new];
+    ADALTelemetryTestDispatcher *second = [ADALTelemetryTestDispatcher new];
+    
+    [[ADALTelemetry sharedInstance] addDispatcher:first aggregationRequired:NO];
+    [[ADALTelemetry sharedInstance] addDispatcher:second aggregationRequired:YES];
+    XCTAssertTrue([ADALTelemetrySampler dispatchersRegistered]);
+    
+    [[ADALTelemetry sharedInstance] removeDispatcher:first];
+    XCTAssertTrue([ADALTelemetrySampler dispatchersRegistered]);
+    
+    [[ADALTelemetry sharedInstance] removeDispatcher:second];
+    XCTAssertFalse([ADALTelemetrySampler dispatchersRegistered]);
+    
+    [[ADALTelemetry sharedInstance] addDispatcher:first aggregationRequired:NO];
+    [[ADALTelemetry sharedInstance] removeAllDispatchers];
+    XCTAssertFalse([ADALTelemetrySampler dispatchersRegistered]);
+}
+
+@end
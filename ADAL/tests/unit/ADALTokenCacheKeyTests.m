@@ -139,5 +139,70 @@
     }
 }
 
+- (void)testInitWithCoder_whenDecodedTwice_shouldShareInternedStrings
+{
+    ADALTokenCacheKey *key = [ADALTokenCacheKey keyWithAuthority:mAuthority resource:mResource clientId:mClientId error:nil];
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:key requiringSecureCoding:YES error:nil];
+    XCTAssertNotNil(data);
+    
+    ADALTokenCacheKey *key1 = [NSKeyedUnarchiver unarchivedObjectOfClass:[ADALTokenCacheKey class] fromData:data error:nil];
+    ADALTokenCacheKey *key2 = [NSKeyedUnarchiver unarchivedObjectOfClass:[ADALTokenCacheKey class] fromData:data error:nil];
+    
+    [self assertKey:key1 equalsTo:key2];
+    [self assertKey:key1 equalsTo:key];
+    XCTAssertTrue(key1.authority == key2.authority);
+    XCTAssertTrue(key1.resource == key2.resource);
+    XCTAssertTrue(key1.clientId == key2.clientId);
+}
+
+- (void)testKeyWithCanonicalAuthority_whenCanonicalComponents_shouldEqualValidatedKey
+{
+    ADALTokenCacheKey *key = [ADALTokenCacheKey keyWithAuthority:mAuthority resource:mResource clientId:mClientId error:nil];
+    ADALTokenCacheKey *trustedKey = [ADALTokenCacheKey keyWithCanonicalAuthority:key.authority resource:key.resource clientId:key.clientId];
+    
+    [self assertKey:key equalsTo:trustedKey];
+    [self assertKey:key.mrrtKey equalsTo:[ADALTokenCacheKey keyWithAuthority:mAuthority resource:nil clientId:mClientId error:nil]];
+}
+
+#pragma mark - Performance
+
+- (void)testPerformanceKeyWithAuthority
+{
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; i++)
+        {
+            [ADALTokenCacheKey keyWithAuthority:mAuthority resource:mResource clientId:mClientId error:nil];
+        }
+    }];
+}
+
+- (void)testPerformanceKeyWithCanonicalAuthority
+{
+    ADALTokenCacheKey *key = [ADALTokenCacheKey keyWithAuthority:mAuthority resource:mResource clientId:mClientId error:nil];
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; i++)
+        {
+            [ADALTokenCacheKey keyWithCanonicalAuthority:key.authority resource:key.resource clientId:key.clientId];
+        }
+    }];
+}
+
+- (void)testPerformanceHashAndCompare
+{
+    ADALTokenCacheKey *key = [ADALTokenCacheKey keyWithAuthority:mAuthority resource:mResource clientId:mClientId error:nil];
+    ADALTokenCacheKey *sameKey = [ADALTokenCacheKey keyWithAuthority:mAuthority resource:mResource clientId:mClientId error:nil];
+    ADALTokenCacheKey *otherKey = [ADALTokenCacheKey keyWithAuthority:mAuthority resource:@"another resource" clientId:mClientId error:nil];
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; i++)
+        {
+            [[key mrrtKey] hash];
+            XCTAssertTrue([key isEqual:sameKey]);
+            XCTAssertFalse([key isEqual:otherKey]);
+        }
+    }];
+}
+
 
 @end
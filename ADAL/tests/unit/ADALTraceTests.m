@@ -0,0 +1,116 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "ADALTrace.h"
+
+@interface ADALTraceTests : ADTestCase
+
+@end
+
+@implementation ADALTraceTests
+
+- (void)setUp
+{
+    [super setUp];
+    [ADALTrace setCallback:^(__unused NSString *requestId, __unused NSData *traceJSON) {}];
+}
+
+- (void)tearDown
+{
+    [ADALTrace setCallback:nil];
+    [super tearDown];
+}
+
+- (NSArray<NSDictionary *> *)traceEvents:(NSString *)requestId
+{
+    return [ADALTrace traceEventsForRequest:requestId][@"traceEvents"];
+}
+
+- (void)testBeginSpan_whenNoCallback_shouldRecordNothing
+{
+    [ADALTrace setCallback:nil];
+    
+    XCTAssertEqual([ADALTrace beginSpan:@"api" requestId:@"request"], 0);
+    XCTAssertEqual([self traceEvents:@"request"].count, 0);
+}
+
+- (void)testBeginSpan_whenSpansNested_shouldLinkParents
+{
+    ADALTraceSpanId api = [ADALTrace beginSpan:@"api" requestId:@"request"];
+    ADALTraceSpanId silent = [ADALTrace beginSpan:@"silent" requestId:@"request"];
+    ADALTraceSpanId http = [ADALTrace beginSpan:@"http" requestId:@"request"];
+    [ADALTrace endSpan:http requestId:@"request" status:@"2xx"];
+    [ADALTrace endSpan:silent requestId:@"request" status:@"succeeded"];
+    ADALTraceSpanId grant = [ADALTrace beginSpan:@"grant" requestId:@"request"];
+    [ADALTrace endSpan:grant requestId:@"request" status:@"succeeded"];
+    [ADALTrace endSpan:api requestId:@"request" status:@"succeeded"];
+    
+    NSArray<NSDictionary *> *events = [self traceEvents:@"request"];
+    XCTAssertEqual(events.count, 4);
+    
+    NSMutableDictionary *parents = [NSMutableDictionary new];
+    for (NSDictionary *event in events)
+    {
+        XCTAssertEqualObjects(event[@"ph"], @"X");
+        XCTAssertNotNil(event[@"ts"]);
+        XCTAssertNotNil(event[@"dur"]);
+        XCTAssertNil(event[@"args"][@"incomplete"]);
+        parents[event[@"name"]] = event[@"args"][@"parent_id"] ?: @0;
+    }
+    
+    XCTAssertEqualObjects(parents[@"api"], @0);
+    XCTAssertEqualObjects(parents[@"silent"], @(api));
+    XCTAssertEqualObjects(parents[@"http"], @(silent));
+    XCTAssertEqualObjects(parents[@"grant"], @(api));
+}
+
+- (void)testTraceEvents_whenSpanStillOpen_shouldMarkIncomplete
+{
+    [ADALTrace beginSpan:@"api" requestId:@"open request"];
+    
+    NSDictionary *event = [self traceEvents:@"open request"].firstObject;
+    XCTAssertEqualObjects(event[@"args"][@"incomplete"], @YES);
+}
+
+- (void)testFinishRequest_shouldDeliverTraceEventJSON
+{
+    XCTestExpectation *expectation = [self expectationWithDescription:@"trace"];
+    [ADALTrace setCallback:^(NSString *requestId, NSData *traceJSON) {
+        XCTAssertEqualObjects(requestId, @"finished request");
+        
+        NSDictionary *trace = [NSJSONSerialization JSONObjectWithData:traceJSON options:0 error:nil];
+        XCTAssertEqual([trace[@"traceEvents"] count], 1);
+        XCTAssertEqualObjects(trace[@"traceEvents"][0][@"name"], @"api");
+        XCTAssertEqualObjects(trace[@"otherData"][@"request_id"], @"finished request");
+        [expectation fulfill];
+    }];
+    
+    ADALTraceSpanId api = [ADALTrace beginSpan:@"api" requestId:@"finished request"];
+    [ADALTrace endSpan:api requestId:@"finished request" status:@"succeeded"];
+    [ADALTrace finishRequest:@"finished request"];
+    
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+}
+
+@end
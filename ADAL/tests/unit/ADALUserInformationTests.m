@@ -103,6 +103,28 @@
     XCTAssertEqualObjects(userInfo, userInfoCopy);
 }
 
+- (void)testUserInformationWithIdToken_whenSameIdTokenParsedTwice_shouldShareParsedClaims
+{
+    ADALUserInformation *userInfo = [self adCreateUserInformation:@"eric_cartman@contoso.com"];
+    ADALUserInformation *otherUserInfo = [ADALUserInformation userInformationWithIdToken:[userInfo.rawIdToken mutableCopy] error:nil];
+    
+    XCTAssertEqualObjects(userInfo, otherUserInfo);
+    XCTAssertEqualObjects(otherUserInfo.userId, @"eric_cartman@contoso.com");
+    XCTAssertTrue(userInfo.allClaims == otherUserInfo.allClaims);
+}
+
+- (void)testPerformanceUserInformationWithIdToken
+{
+    NSString *idToken = [self adCreateUserInformation:@"eric_cartman@contoso.com"].rawIdToken;
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 10000; i++)
+        {
+            [ADALUserInformation userInformationWithIdToken:idToken error:nil];
+        }
+    }];
+}
+
 #pragma mark -
 
 - (void) testIdTokenNormal
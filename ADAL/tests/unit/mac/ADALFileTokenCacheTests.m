@@ -0,0 +1,197 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "XCTestCase+TestHelperMethods.h"
+#import "ADALFileTokenCache+Internal.h"
+#import "ADALFileTokenCacheDataSource.h"
+#import "ADALTokenCacheItem.h"
+#import "ADALUserInformation.h"
+#import "ADALAuthenticationContext.h"
+
+@interface ADALFileTokenCacheTests : ADTestCase
+{
+    NSString *mPath;
+    ADALFileTokenCache *mStore;
+}
+@end
+
+@implementation ADALFileTokenCacheTests
+
+- (void)setUp
+{
+    [super setUp];
+    
+    mPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    mStore = [[ADALFileTokenCache alloc] initWithPath:mPath];
+    XCTAssertNotNil(mStore);
+}
+
+- (void)tearDown
+{
+    mStore = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:mPath error:nil];
+    
+    [super tearDown];
+}
+
+- (void)testAddOrUpdateItem_whenItemSaved_shouldBeReadableByAnotherInstance
+{
+    ADALAuthenticationError *error = nil;
+    ADALTokenCacheItem *item = [self adCreateCacheItem:@"eric@contoso.com"];
+    XCTAssertTrue([mStore addOrUpdateItem:item correlationId:nil error:&error]);
+    ADAssertNoError;
+    
+    ADALFileTokenCache *otherStore = [[ADALFileTokenCache alloc] initWithPath:mPath];
+    ADALTokenCacheItem *read = [otherStore getItemWithKey:[item extractKey:nil] userId:@"eric@contoso.com" correlationId:nil error:&error];
+    ADAssertNoError;
+    XCTAssertEqualObjects(read, item);
+}
+
+- (void)testAddOrUpdateItem_whenItemUpdatedByAnotherInstance_shouldReturnUpdatedItem
+{
+    ADALAuthenticationError *error = nil;
+    ADALTokenCacheItem *item = [self adCreateCacheItem:@"eric@contoso.com"];
+    XCTAssertTrue([mStore addOrUpdateItem:item correlationId:nil error:&error]);
+    XCTAssertEqual([[mStore allItems:&error] count], 1);
+    
+    ADALFileTokenCache *otherStore = [[ADALFileTokenCache alloc] initWithPath:mPath];
+    item.refreshToken = @"updated refresh token";
+    XCTAssertTrue([otherStore addOrUpdateItem:item correlationId:nil error:&error]);
+    ADAssertNoError;
+    
+    NSArray *items = [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(items.count, 1);
+    XCTAssertEqualObjects([items[0] refreshToken], @"updated refresh token");
+}
+
+- (void)testRemoveItem_whenItemInCache_shouldRemoveItem
+{
+    ADALAuthenticationError *error = nil;
+    ADALTokenCacheItem *item = [self adCreateCacheItem:@"eric@contoso.com"];
+    ADALTokenCacheItem *otherItem = [self adCreateCacheItem:@"jack@contoso.com"];
+    XCTAssertTrue([mStore addOrUpdateItem:item correlationId:nil error:&error]);
+    XCTAssertTrue([mStore addOrUpdateItem:otherItem correlationId:nil error:&error]);
+    
+    XCTAssertTrue([mStore removeItem:item error:&error]);
+    ADAssertNoError;
+    
+    NSArray *items = [[[ADALFileTokenCache alloc] initWithPath:mPath] allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(items.count, 1);
+    XCTAssertEqualObjects(items[0], otherItem);
+}
+
+- (void)testCompact_whenItemsUpdated_shouldShrinkFileAndKeepLatestItems
+{
+    ADALAuthenticationError *error = nil;
+    ADALTokenCacheItem *item = [self adCreateCacheItem:@"eric@contoso.com"];
+    
+    for (int i = 0; i < 10; i++)
+    {
+        item.refreshToken = [NSString stringWithFormat:@"refresh token %d", i];
+        XCTAssertTrue([mStore addOrUpdateItem:item correlationId:nil error:&error]);
+    }
+    
+    unsigned long long sizeBefore = [[[NSFileManager defaultManager] attributesOfItemAtPath:mPath error:nil] fileSize];
+    XCTAssertTrue([mStore compact:&error]);
+    ADAssertNoError;
+    unsigned long long sizeAfter = [[[NSFileManager defaultManager] attributesOfItemAtPath:mPath error:nil] fileSize];
+    XCTAssertTrue(sizeAfter < sizeBefore);
+    
+    NSArray *items = [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(items.count, 1);
+    XCTAssertEqualObjects([items[0] refreshToken], @"refresh token 9");
+}
+
+- (void)testClear_whenAnotherInstanceClearsAndAppends_shouldSeeOnlyItemsAfterClear
+{
+    ADALAuthenticationError *error = nil;
+    ADALTokenCacheItem *item = [self adCreateCacheItem:@"eric@contoso.com"];
+    XCTAssertTrue([mStore addOrUpdateItem:item correlationId:nil error:&error]);
+    XCTAssertEqual([[mStore allItems:&error] count], 1);
+    
+    ADALFileTokenCache *otherStore = [[ADALFileTokenCache alloc] initWithPath:mPath];
+    XCTAssertEqual([[otherStore allItems:&error] count], 1);
+    ADAssertNoError;
+    
+    NSError *clearError = nil;
+    XCTAssertTrue([otherStore.fileDataSource clearWithContext:nil error:&clearError]);
+    XCTAssertNil(clearError);
+    
+    // Same length as the cleared item, so the file grows back to the size this instance has indexed
+    ADALTokenCacheItem *otherItem = [self adCreateCacheItem:@"jack@contoso.com"];
+    XCTAssertTrue([otherStore addOrUpdateItem:otherItem correlationId:nil error:&error]);
+    ADAssertNoError;
+    
+    NSArray *items = [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(items.count, 1);
+    XCTAssertEqualObjects(items[0], otherItem);
+    
+    ADALTokenCacheItem *newItem = [self adCreateCacheItem:@"rose@contoso.com"];
+    XCTAssertTrue([mStore addOrUpdateItem:newItem correlationId:nil error:&error]);
+    ADAssertNoError;
+    
+    items = [otherStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(items.count, 2);
+    XCTAssertTrue([items containsObject:otherItem]);
+    XCTAssertTrue([items containsObject:newItem]);
+}
+
+- (void)testPreloadTokenCache_whenContextUsesFileCache_shouldLoadClientItems
+{
+    ADALAuthenticationError *error = nil;
+    XCTAssertTrue([mStore addOrUpdateItem:[self adCreateATCacheItem] correlationId:nil error:&error]);
+    XCTAssertTrue([mStore addOrUpdateItem:[self adCreateMRRTCacheItem] correlationId:nil error:&error]);
+    XCTAssertTrue([mStore addOrUpdateItem:[self adCreateFRTCacheItem] correlationId:nil error:&error]);
+    
+    ADALTokenCacheItem *otherClientItem = [self adCreateATCacheItem];
+    otherClientItem.clientId = @"other client";
+    XCTAssertTrue([mStore addOrUpdateItem:otherClientItem correlationId:nil error:&error]);
+    ADAssertNoError;
+    
+    ADALAuthenticationContext *context = [[ADALAuthenticationContext alloc] initWithAuthority:TEST_AUTHORITY
+                                                                            validateAuthority:NO
+                                                                                    fileCache:mStore
+                                                                                        error:&error];
+    XCTAssertNotNil(context);
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"preload"];
+    NSProgress *progress = [context preloadTokenCacheForClientId:TEST_CLIENT_ID completionBlock:^(NSUInteger itemCount, ADALAuthenticationError *preloadError)
+    {
+        XCTAssertTrue([NSThread isMainThread]);
+        XCTAssertNil(preloadError);
+        // The client's MRRT and FRT, neither the access token nor the other client's items
+        XCTAssertEqual(itemCount, 2);
+        [expectation fulfill];
+    }];
+    
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+    XCTAssertTrue(progress.finished);
+}
+
+@end
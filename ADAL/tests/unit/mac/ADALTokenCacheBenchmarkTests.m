@@ -0,0 +1,381 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "XCTestCase+TestHelperMethods.h"
+#import "ADALAllocationCounter.h"
+#import "ADALTokenCacheTestUtil.h"
+#import "ADALTokenCache+Internal.h"
+#import "ADALFileTokenCache+Internal.h"
+#import "ADALTokenCacheItem.h"
+#import "ADALTokenCacheKey.h"
+
+// Synthetic population: users x clients MRRTs, users x clients x resources ATs, FRTs for family users
+#define BENCHMARK_USERS             10
+#define BENCHMARK_RESOURCES         5
+#define BENCHMARK_CLIENTS           3
+#define BENCHMARK_FAMILY_INTERVAL   2
+
+// Set to a file path to choose where the machine readable results are written
+#define BENCHMARK_RESULTS_PATH_ENV  "ADAL_BENCHMARK_RESULTS_PATH"
+
+static NSMutableDictionary<NSString *, NSDictionary *> *s_results = nil;
+
+/*! Keeps the cache in a blob the way apps persisting through ADALTokenCacheDelegate do */
+@interface ADALBenchmarkBlobCacheDelegate : NSObject <ADALTokenCacheDelegate>
+
+@property (nonatomic) NSData *data;
+
+@end
+
+@implementation ADALBenchmarkBlobCacheDelegate
+
+- (void)willAccessCache:(ADALTokenCache *)cache { [cache deserialize:self.data error:nil]; }
+- (void)didAccessCache:(ADALTokenCache *)cache { (void)cache; }
+- (void)willWriteCache:(ADALTokenCache *)cache { [cache deserialize:self.data error:nil]; }
+- (void)didWriteCache:(ADALTokenCache *)cache { self.data = [cache serialize]; }
+
+@end
+
+@interface ADALTokenCacheBenchmarkTests : ADTestCase
+{
+    NSString *mPath;
+    ADALBenchmarkBlobCacheDelegate *mDelegate;
+}
+
+@end
+
+@implementation ADALTokenCacheBenchmarkTests
+
++ (void)setUp
+{
+    [super setUp];
+    s_results = [NSMutableDictionary new];
+}
+
++ (void)tearDown
+{
+    const char *envPath = getenv(BENCHMARK_RESULTS_PATH_ENV);
+    NSString *path = envPath ? @(envPath) : [NSTemporaryDirectory() stringByAppendingPathComponent:@"adal-token-cache-benchmark.json"];
+    
+    NSDictionary *report = @{ @"population" : @{ @"users" : @(BENCHMARK_USERS),
+                                                 @"resources" : @(BENCHMARK_RESOURCES),
+                                                 @"clients" : @(BENCHMARK_CLIENTS),
+                                                 @"family_interval" : @(BENCHMARK_FAMILY_INTERVAL) },
+                              @"results" : s_results };
+    
+    NSData *json = [NSJSONSerialization dataWithJSONObject:report
+                                                   options:NSJSONWritingPrettyPrinted | NSJSONWritingSortedKeys
+                                                     error:nil];
+    [json writeToFile:path atomically:YES];
+    NSLog(@"Token cache benchmark results written to %@", path);
+    
+    s_results = nil;
+    [super tearDown];
+}
+
+- (void)setUp
+{
+    [super setUp];
+    mPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:mPath error:nil];
+    mDelegate = nil;
+    [super tearDown];
+}
+
+#pragma mark - Helpers
+
+- (ADALTokenCache *)populatedMemoryCache
+{
+    ADALTokenCache *cache = [ADALTokenCache new];
+    [self populate:cache];
+    return cache;
+}
+
+- (ADALTokenCache *)populatedDelegateCache
+{
+    ADALTokenCache *cache = [self populatedMemoryCache];
+    
+    mDelegate = [ADALBenchmarkBlobCacheDelegate new];
+    mDelegate.data = [cache serialize];
+    [cache setDelegate:mDelegate];
+    
+    return cache;
+}
+
+- (ADALFileTokenCache *)populatedFileCache
+{
+    [[NSFileManager defaultManager] removeItemAtPath:mPath error:nil];
+    ADALFileTokenCache *cache = [[ADALFileTokenCache alloc] initWithPath:mPath];
+    [self populate:cache];
+    return cache;
+}
+
+- (void)populate:(id<ADALTokenCacheDataSource>)cache
+{
+    [self adPopulateCache:cache
+                userCount:BENCHMARK_USERS
+            resourceCount:BENCHMARK_RESOURCES
+              clientCount:BENCHMARK_CLIENTS
+           familyInterval:BENCHMARK_FAMILY_INTERVAL];
+}
+
+- (NSArray<ADALTokenCacheKey *> *)accessTokenKeys
+{
+    NSMutableArray *keys = [NSMutableArray new];
+    
+    for (NSUInteger client = 0; client < BENCHMARK_CLIENTS; client++)
+    {
+        for (NSUInteger resource = 0; resource < BENCHMARK_RESOURCES; resource++)
+        {
+            [keys addObject:[ADALTokenCacheKey keyWithAuthority:TEST_AUTHORITY
+                                                       resource:[self adPopulationResource:resource]
+                                                       clientId:[self adPopulationClientId:client]
+                                                          error:nil]];
+        }
+    }
+    
+    return keys;
+}
+
+/*
+ Measures block with XCTest and records the fastest run. Allocations count every malloc zone
+ call block makes and the bytes it asks for, including memory freed before it returns.
+ */
+- (void)benchmark:(NSString *)name
+       operations:(NSUInteger)operations
+            setUp:(void (^)(void))setUp
+            block:(void (^)(void))block
+{
+    __block uint64_t bestNanoseconds = UINT64_MAX;
+    __block uint64_t allocations = 0;
+    __block uint64_t allocatedBytes = 0;
+    
+    [self measureMetrics:[[self class] defaultPerformanceMetrics] automaticallyStartMeasuring:NO forBlock:^{
+        if (setUp) setUp();
+        
+        @autoreleasepool
+        {
+            uint64_t allocationsBefore = [ADALAllocationCounter allocationCount];
+            uint64_t bytesBefore = [ADALAllocationCounter allocatedBytes];
+            uint64_t start = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+            
+            [self startMeasuring];
+            block();
+            [self stopMeasuring];
+            
+            uint64_t elapsed = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - start;
+            uint64_t allocationsAfter = [ADALAllocationCounter allocationCount];
+            uint64_t bytesAfter = [ADALAllocationCounter allocatedBytes];
+            
+            if (elapsed < bestNanoseconds)
+            {
+                bestNanoseconds = elapsed;
+                allocations = allocationsAfter - allocationsBefore;
+                allocatedBytes = bytesAfter - bytesBefore;
+            }
+        }
+    }];
+    
+    double seconds = (double)bestNanoseconds / NSEC_PER_SEC;
+    
+    s_results[name] = @{ @"operations" : @(operations),
+                         @"best_seconds" : @(seconds),
+                         @"operations_per_second" : @(seconds > 0 ? operations / seconds : 0),
+                         @"allocations_per_operation" : @((double)allocations / MAX(operations, 1)),
+                         @"bytes_per_operation" : @((double)allocatedBytes / MAX(operations, 1)) };
+}
+
+- (void)benchmarkGetItemWithKey:(id<ADALTokenCacheDataSource>)cache name:(NSString *)name
+{
+    NSArray *keys = [self accessTokenKeys];
+    
+    [self benchmark:name operations:keys.count * BENCHMARK_USERS setUp:nil block:^{
+        for (NSUInteger user = 0; user < BENCHMARK_USERS; user++)
+        {
+            NSString *userId = [self adPopulationUserId:user];
+            
+            for (ADALTokenCacheKey *key in keys)
+            {
+                [cache getItemWithKey:key userId:userId correlationId:nil error:nil];
+            }
+        }
+    }];
+}
+
+- (void)benchmarkAllItems:(id<ADALTokenCacheDataSource>)cache name:(NSString *)name
+{
+    [self benchmark:name operations:10 setUp:nil block:^{
+        for (NSUInteger i = 0; i < 10; i++)
+        {
+            [cache allItems:nil];
+        }
+    }];
+}
+
+- (void)benchmarkAddOrUpdateItem:(id<ADALTokenCacheDataSource>)cache name:(NSString *)name
+{
+    NSMutableArray *items = [NSMutableArray new];
+    
+    for (NSUInteger resource = 0; resource < BENCHMARK_RESOURCES; resource++)
+    {
+        ADALTokenCacheItem *item = [self adCreateATCacheItem:[self adPopulationResource:resource] userId:[self adPopulationUserId:0]];
+        item.clientId = [self adPopulationClientId:0];
+        [items addObject:item];
+    }
+    
+    [self benchmark:name operations:items.count setUp:nil block:^{
+        for (ADALTokenCacheItem *item in items)
+        {
+            [cache addOrUpdateItem:item correlationId:nil error:nil];
+        }
+    }];
+}
+
+#pragma mark - In memory
+
+- (void)testBenchmarkGetItemWithKey_whenMemoryCache
+{
+    [self benchmarkGetItemWithKey:[self populatedMemoryCache] name:@"memory.getItemWithKey"];
+}
+
+- (void)testBenchmarkAllItems_whenMemoryCache
+{
+    [self benchmarkAllItems:[self populatedMemoryCache] name:@"memory.allItems"];
+}
+
+- (void)testBenchmarkAddOrUpdateItem_whenMemoryCache
+{
+    [self benchmarkAddOrUpdateItem:[self populatedMemoryCache] name:@"memory.addOrUpdateItem"];
+}
+
+- (void)testBenchmarkRemoveAllForUserId_whenMemoryCache
+{
+    __block ADALTokenCache *cache = nil;
+    
+    [self benchmark:@"memory.removeAllForUserId" operations:BENCHMARK_USERS * BENCHMARK_CLIENTS setUp:^{
+        cache = [self populatedMemoryCache];
+    } block:^{
+        for (NSUInteger user = 0; user < BENCHMARK_USERS; user++)
+        {
+            for (NSUInteger client = 0; client < BENCHMARK_CLIENTS; client++)
+            {
+                [cache removeAllForUserId:[self adPopulationUserId:user] clientId:[self adPopulationClientId:client] error:nil];
+            }
+        }
+    }];
+}
+
+#pragma mark - Delegate
+
+- (void)testBenchmarkGetItemWithKey_whenDelegateCache
+{
+    [self benchmarkGetItemWithKey:[self populatedDelegateCache] name:@"delegate.getItemWithKey"];
+}
+
+- (void)testBenchmarkAddOrUpdateItem_whenDelegateCache
+{
+    [self benchmarkAddOrUpdateItem:[self populatedDelegateCache] name:@"delegate.addOrUpdateItem"];
+}
+
+- (void)testBenchmarkRemoveAllForUserId_whenDelegateCache
+{
+    __block ADALTokenCache *cache = nil;
+    
+    [self benchmark:@"delegate.removeAllForUserId" operations:BENCHMARK_USERS * BENCHMARK_CLIENTS setUp:^{
+        cache = [self populatedDelegateCache];
+    } block:^{
+        for (NSUInteger user = 0; user < BENCHMARK_USERS; user++)
+        {
+            for (NSUInteger client = 0; client < BENCHMARK_CLIENTS; client++)
+            {
+                [cache removeAllForUserId:[self adPopulationUserId:user] clientId:[self adPopulationClientId:client] error:nil];
+            }
+        }
+    }];
+}
+
+#pragma mark - Blob
+
+- (void)testBenchmarkSerialize_whenCacheChanged
+{
+    ADALTokenCache *cache = [self populatedMemoryCache];
+    ADALTokenCacheItem *item = [self adCreateATCacheItem];
+    
+    // The write before every run keeps serialize from returning the last encoded snapshot
+    [self benchmark:@"blob.serialize" operations:1 setUp:^{
+        [cache addOrUpdateItem:item correlationId:nil error:nil];
+    } block:^{
+        [cache serialize];
+    }];
+}
+
+- (void)testBenchmarkDeserialize
+{
+    NSData *data = [[self populatedMemoryCache] serialize];
+    ADALTokenCache *cache = [ADALTokenCache new];
+    
+    [self benchmark:@"blob.deserialize" operations:1 setUp:nil block:^{
+        [cache deserialize:data error:nil];
+    }];
+}
+
+#pragma mark - File
+
+- (void)testBenchmarkGetItemWithKey_whenFileCache
+{
+    [self benchmarkGetItemWithKey:[self populatedFileCache] name:@"file.getItemWithKey"];
+}
+
+- (void)testBenchmarkAllItems_whenFileCache
+{
+    [self benchmarkAllItems:[self populatedFileCache] name:@"file.allItems"];
+}
+
+- (void)testBenchmarkAddOrUpdateItem_whenFileCache
+{
+    [self benchmarkAddOrUpdateItem:[self populatedFileCache] name:@"file.addOrUpdateItem"];
+}
+
+- (void)testBenchmarkRemoveAllForUserId_whenFileCache
+{
+    __block ADALFileTokenCache *cache = nil;
+    
+    [self benchmark:@"file.removeAllForUserId" operations:BENCHMARK_USERS * BENCHMARK_CLIENTS setUp:^{
+        cache = [self populatedFileCache];
+    } block:^{
+        for (NSUInteger user = 0; user < BENCHMARK_USERS; user++)
+        {
+            for (NSUInteger client = 0; client < BENCHMARK_CLIENTS; client++)
+            {
+                [cache removeAllForUserId:[self adPopulationUserId:user] clientId:[self adPopulationClientId:client] error:nil];
+            }
+        }
+    }];
+}
+
+@end
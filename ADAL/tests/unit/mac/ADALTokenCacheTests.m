@@ -28,6 +28,51 @@
 #import "ADALTokenCacheItem.h"
 #import "ADALUserInformation.h"
 
+@interface ADALTestCountingCacheDelegate : NSObject <ADALTokenCacheDelegate>
+
+@property (nonatomic) NSUInteger willAccessCount;
+@property (nonatomic) NSUInteger didAccessCount;
+@property (nonatomic) NSUInteger willWriteCount;
+@property (nonatomic) NSUInteger didWriteCount;
+
+@end
+
+@implementation ADALTestCountingCacheDelegate
+
+- (void)willAccessCache:(ADALTokenCache *)cache { @synchronized (self) { self.willAccessCount++; } }
+- (void)didAccessCache:(ADALTokenCache *)cache { @synchronized (self) { self.didAccessCount++; } }
+- (void)willWriteCache:(ADALTokenCache *)cache { @synchronized (self) { self.willWriteCount++; } }
+- (void)didWriteCache:(ADALTokenCache *)cache { @synchronized (self) { self.didWriteCount++; } }
+
+@end
+
+@interface ADALTestGenerationCacheDelegate : ADALTestCountingCacheDelegate
+
+@property (nonatomic) uint64_t generation;
+// Simulates another process writing the cache while it's being loaded
+@property (nonatomic) BOOL writeDuringNextLoad;
+
+@end
+
+@implementation ADALTestGenerationCacheDelegate
+
+- (uint64_t)generationOfCache:(ADALTokenCache *)cache { return self.generation; }
+
+- (void)willAccessCache:(ADALTokenCache *)cache
+{
+    [super willAccessCache:cache];
+    
+    if (self.writeDuringNextLoad)
+    {
+        self.writeDuringNextLoad = NO;
+        self.generation++;
+    }
+}
+
+- (void)didWriteCache:(ADALTokenCache *)cache { [super didWriteCache:cache]; self.generation++; }
+
+@end
+
 @interface ADALTokenCacheTests : ADTestCase
 {
     ADALTokenCache *mStore;
@@ -272,6 +317,324 @@
     [self verifyCacheContainsItem:item4];
 }
 
+- (void)testWriteBatch_whenMultipleItemsWrittenInBatch_shouldNotifyDelegateOnce
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setDelegate:delegate];
+    
+    ADALAuthenticationError *error = nil;
+    
+    [mStore beginWriteBatch];
+    [mStore addOrUpdateItem:[self adCreateATCacheItem:@"resource 1" userId:@"eric@contoso.com"] correlationId:nil error:&error];
+    [mStore addOrUpdateItem:[self adCreateCacheItem:@"eric@contoso.com"] correlationId:nil error:&error];
+    ADAssertNoError;
+    
+    XCTAssertEqual(delegate.willWriteCount, 1);
+    XCTAssertEqual(delegate.didWriteCount, 0);
+    
+    [mStore commitWriteBatch];
+    
+    XCTAssertEqual(delegate.willWriteCount, 1);
+    XCTAssertEqual(delegate.didWriteCount, 1);
+    XCTAssertEqual([self count], 2);
+    
+    [mStore addOrUpdateItem:[self adCreateATCacheItem:@"resource 2" userId:@"eric@contoso.com"] correlationId:nil error:&error];
+    ADAssertNoError;
+    
+    XCTAssertEqual(delegate.willWriteCount, 2);
+    XCTAssertEqual(delegate.didWriteCount, 2);
+}
+
+- (void)testWriteBatch_whenBatchOpenOnAnotherThread_shouldWaitForCommit
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setDelegate:delegate];
+
+    ADALAuthenticationError *error = nil;
+
+    [mStore beginWriteBatch];
+    [mStore addOrUpdateItem:[self adCreateATCacheItem:@"resource 1" userId:@"eric@contoso.com"] correlationId:nil error:&error];
+    ADAssertNoError;
+
+    dispatch_semaphore_t readDone = dispatch_semaphore_create(0);
+    dispatch_semaphore_t writeDone = dispatch_semaphore_create(0);
+    __block NSUInteger readCount = 0;
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        readCount = [mStore allItems:nil].count;
+        dispatch_semaphore_signal(readDone);
+    });
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [mStore addOrUpdateItem:[self adCreateATCacheItem:@"resource 2" userId:@"eric@contoso.com"] correlationId:nil error:nil];
+        dispatch_semaphore_signal(writeDone);
+    });
+
+    // Neither may see the batch half written or reload the cache over its pending write
+    XCTAssertNotEqual(dispatch_semaphore_wait(readDone, dispatch_time(DISPATCH_TIME_NOW, 200 * NSEC_PER_MSEC)), 0);
+    XCTAssertNotEqual(dispatch_semaphore_wait(writeDone, dispatch_time(DISPATCH_TIME_NOW, 200 * NSEC_PER_MSEC)), 0);
+
+    [mStore addOrUpdateItem:[self adCreateCacheItem:@"eric@contoso.com"] correlationId:nil error:&error];
+    ADAssertNoError;
+
+    XCTAssertEqual(delegate.willWriteCount, 1);
+    XCTAssertEqual(delegate.didWriteCount, 0);
+
+    [mStore commitWriteBatch];
+
+    XCTAssertEqual(dispatch_semaphore_wait(readDone, dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC)), 0);
+    XCTAssertEqual(dispatch_semaphore_wait(writeDone, dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC)), 0);
+
+    XCTAssertGreaterThanOrEqual(readCount, 2);
+    XCTAssertEqual(delegate.willWriteCount, 2);
+    XCTAssertEqual(delegate.didWriteCount, 2);
+    XCTAssertEqual([self count], 3);
+}
+
+- (void)testWriteBatch_whenLookupPassOpenOnAnotherThread_shouldWaitForPassToEnd
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setDelegate:delegate];
+
+    ADALAuthenticationError *error = nil;
+
+    [mStore beginLookupPass];
+    [mStore allItems:&error];
+    ADAssertNoError;
+
+    dispatch_semaphore_t batchDone = dispatch_semaphore_create(0);
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [mStore beginWriteBatch];
+        [mStore addOrUpdateItem:[self adCreateCacheItem:@"eric@contoso.com"] correlationId:nil error:nil];
+        [mStore commitWriteBatch];
+        dispatch_semaphore_signal(batchDone);
+    });
+
+    XCTAssertNotEqual(dispatch_semaphore_wait(batchDone, dispatch_time(DISPATCH_TIME_NOW, 200 * NSEC_PER_MSEC)), 0);
+
+    // Lookups of the pass keep seeing the contents the pass loaded
+    XCTAssertEqual([mStore allItems:&error].count, 0);
+    XCTAssertEqual(delegate.willWriteCount, 0);
+
+    [mStore endLookupPass];
+
+    XCTAssertEqual(dispatch_semaphore_wait(batchDone, dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC)), 0);
+    XCTAssertEqual(delegate.didWriteCount, 1);
+    XCTAssertEqual([self count], 1);
+}
+
+- (void)testReadLease_whenEnabled_shouldLoadOnceUntilInvalidated
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setReadLeaseEnabled:YES];
+    [mStore setDelegate:delegate];
+    XCTAssertEqual(delegate.willAccessCount, 1);
+    
+    ADALAuthenticationError *error = nil;
+    [mStore allItems:&error];
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 1);
+    
+    [mStore invalidateReadLease];
+    [mStore allItems:&error];
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 2);
+}
+
+- (void)testReadLease_whenDisabled_shouldLoadOnEveryRead
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setDelegate:delegate];
+    
+    ADALAuthenticationError *error = nil;
+    [mStore allItems:&error];
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 3);
+}
+
+- (void)testLookupPass_whenMultipleLookupsInPass_shouldLoadOnce
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setDelegate:delegate];
+    XCTAssertEqual(delegate.willAccessCount, 1);
+    XCTAssertEqual(delegate.didAccessCount, 1);
+    
+    ADALAuthenticationError *error = nil;
+    
+    [mStore beginLookupPass];
+    [mStore allItems:&error];
+    [mStore allItems:&error];
+    [mStore allItems:&error];
+    ADAssertNoError;
+    
+    XCTAssertEqual(delegate.willAccessCount, 2);
+    XCTAssertEqual(delegate.didAccessCount, 1);
+    
+    [mStore endLookupPass];
+    
+    XCTAssertEqual(delegate.willAccessCount, 2);
+    XCTAssertEqual(delegate.didAccessCount, 2);
+    
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 3);
+}
+
+- (void)testLookupPass_whenPassOpenOnAnotherThread_shouldNotBlockAccess
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setDelegate:delegate];
+
+    ADALAuthenticationError *error = nil;
+
+    [mStore beginLookupPass];
+    [mStore allItems:&error];
+    ADAssertNoError;
+
+    XCTestExpectation *expectation = [self expectationWithDescription:@"lookup on another thread"];
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [mStore allItems:nil];
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithTimeout:1.0 handler:nil];
+
+    // The other thread isn't part of the pass, its lookup loads and completes on its own
+    XCTAssertEqual(delegate.willAccessCount, 3);
+    XCTAssertEqual(delegate.didAccessCount, 2);
+
+    [mStore endLookupPass];
+
+    XCTAssertEqual(delegate.didAccessCount, 3);
+}
+
+- (void)testGeneration_whenGenerationUnchanged_shouldNotReload
+{
+    ADALTestGenerationCacheDelegate *delegate = [ADALTestGenerationCacheDelegate new];
+    [mStore setDelegate:delegate];
+    XCTAssertEqual(delegate.willAccessCount, 1);
+    
+    ADALAuthenticationError *error = nil;
+    [mStore allItems:&error];
+    [mStore addOrUpdateItem:[self adCreateCacheItem:@"eric@contoso.com"] correlationId:nil error:&error];
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 1);
+    
+    // Another process wrote the cache
+    delegate.generation++;
+    [mStore allItems:&error];
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 2);
+}
+
+- (void)testGeneration_whenGenerationChangesDuringLoad_shouldBalanceAndReloadOnNextAccess
+{
+    ADALTestGenerationCacheDelegate *delegate = [ADALTestGenerationCacheDelegate new];
+    [mStore setDelegate:delegate];
+    
+    ADALAuthenticationError *error = nil;
+    delegate.generation++;
+    delegate.writeDuringNextLoad = YES;
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 2);
+    XCTAssertEqual(delegate.didAccessCount, 2);
+    
+    // The load started before the change, so it doesn't count as up to date
+    [mStore allItems:&error];
+    [mStore allItems:&error];
+    ADAssertNoError;
+    XCTAssertEqual(delegate.willAccessCount, 3);
+    XCTAssertEqual(delegate.didAccessCount, 3);
+}
+
+- (void)testSerialize_whenCacheUnchanged_shouldReturnSnapshot
+{
+    ADALAuthenticationError *error = nil;
+    [mStore addOrUpdateItem:[self adCreateCacheItem:@"eric@contoso.com"] correlationId:nil error:&error];
+    ADAssertNoError;
+    
+    NSData *data = [mStore serialize];
+    XCTAssertNotNil(data);
+    XCTAssertTrue([mStore serialize] == data);
+    
+    [mStore addOrUpdateItem:[self adCreateCacheItem:@"jack@contoso.com"] correlationId:nil error:&error];
+    ADAssertNoError;
+    
+    NSData *updatedData = [mStore serialize];
+    XCTAssertFalse(updatedData == data);
+    
+    ADALTokenCache *otherStore = [ADALTokenCache new];
+    XCTAssertTrue([otherStore deserialize:updatedData error:&error]);
+    XCTAssertEqual([[otherStore allItems:&error] count], 2);
+    
+    // Deserialized contents are encoded again on the first serialize
+    NSData *otherData = [otherStore serialize];
+    XCTAssertNotNil(otherData);
+    XCTAssertTrue([otherStore serialize] == otherData);
+}
+
+- (void)testPerformanceLookup_whenReadLeaseDisabled
+{
+    [self measureLookupWithReadLease:NO];
+}
+
+- (void)testPerformanceLookup_whenReadLeaseEnabled
+{
+    [self measureLookupWithReadLease:YES];
+}
+
+- (void)measureLookupWithReadLease:(BOOL)readLease
+{
+    [mStore setReadLeaseEnabled:readLease];
+    [mStore setDelegate:[ADALTestCountingCacheDelegate new]];
+    
+    ADALTokenCacheItem *item = [self adCreateCacheItem:@"eric@contoso.com"];
+    ADALAuthenticationError *error = nil;
+    [mStore addOrUpdateItem:item correlationId:nil error:&error];
+    ADAssertNoError;
+    
+    ADALTokenCacheKey *key = [item extractKey:&error];
+    
+    [self measureBlock:^{
+        for (int i = 0; i < 1000; i++)
+        {
+            [mStore getItemWithKey:key userId:@"eric@contoso.com" correlationId:nil error:nil];
+        }
+    }];
+}
+
+- (void)testReadLease_whenAccessedConcurrentlyAndInvalidated_shouldBalanceDelegateCalls
+{
+    ADALTestCountingCacheDelegate *delegate = [ADALTestCountingCacheDelegate new];
+    [mStore setReadLeaseEnabled:YES];
+    [mStore setDelegate:delegate];
+    
+    ADALAuthenticationError *error = nil;
+    [mStore addOrUpdateItem:[self adCreateCacheItem:@"eric@contoso.com"] correlationId:nil error:&error];
+    ADAssertNoError;
+    
+    dispatch_apply(500, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        
+        if (i % 7 == 0)
+        {
+            [mStore invalidateReadLease];
+        }
+        
+        [mStore allItems:nil];
+    });
+    
+    XCTAssertTrue(delegate.willAccessCount > 1);
+    XCTAssertEqual(delegate.willAccessCount, delegate.didAccessCount);
+}
+
 /*! Count of items in cache store. */
 - (long)count
 {
@@ -0,0 +1,178 @@
+// Copyright (c) Microsoft Corporation.
+// All rights reserved.
+//
+// This code is licensed under the MIT License.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <malloc/malloc.h>
+#import <mach/mach.h>
+#import <pthread.h>
+#import <stdatomic.h>
+#import "ADALAllocationCounter.h"
+
+#define ADAL_MAX_COUNTED_ZONES 16
+
+typedef struct
+{
+    malloc_zone_t *zone;
+    void *(*malloc)(struct _malloc_zone_t *zone, size_t size);
+    void *(*calloc)(struct _malloc_zone_t *zone, size_t num_items, size_t size);
+    void *(*realloc)(struct _malloc_zone_t *zone, void *ptr, size_t size);
+    void *(*memalign)(struct _malloc_zone_t *zone, size_t alignment, size_t size);
+} ADALCountedZone;
+
+static ADALCountedZone s_zones[ADAL_MAX_COUNTED_ZONES];
+static unsigned s_zoneCount = 0;
+static atomic_ullong s_allocations;
+static atomic_ullong s_allocatedBytes;
+
+// Some zones hand large requests to a helper zone through its function table, only the outermost
+// call on a thread is counted. A pthread key rather than __thread, whose lazy setup mallocs.
+static pthread_key_t s_depthKey;
+
+static ADALCountedZone *ADALCountedZoneFor(malloc_zone_t *zone)
+{
+    for (unsigned i = 0; i < s_zoneCount; i++)
+    {
+        if (s_zones[i].zone == zone)
+        {
+            return &s_zones[i];
+        }
+    }
+    
+    return NULL;
+}
+
+static void ADALEnterAllocation(size_t size)
+{
+    uintptr_t depth = (uintptr_t)pthread_getspecific(s_depthKey);
+    if (depth == 0)
+    {
+        atomic_fetch_add_explicit(&s_allocations, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&s_allocatedBytes, size, memory_order_relaxed);
+    }
+    pthread_setspecific(s_depthKey, (void *)(depth + 1));
+}
+
+static void ADALLeaveAllocation(void)
+{
+    uintptr_t depth = (uintptr_t)pthread_getspecific(s_depthKey);
+    pthread_setspecific(s_depthKey, (void *)(depth - 1));
+}
+
+static void *ADALCountingMalloc(malloc_zone_t *zone, size_t size)
+{
+    ADALEnterAllocation(size);
+    void *result = ADALCountedZoneFor(zone)->malloc(zone, size);
+    ADALLeaveAllocation();
+    return result;
+}
+
+static void *ADALCountingCalloc(malloc_zone_t *zone, size_t num_items, size_t size)
+{
+    ADALEnterAllocation(num_items * size);
+    void *result = ADALCountedZoneFor(zone)->calloc(zone, num_items, size);
+    ADALLeaveAllocation();
+    return result;
+}
+
+static void *ADALCountingRealloc(malloc_zone_t *zone, void *ptr, size_t size)
+{
+    ADALEnterAllocation(size);
+    void *result = ADALCountedZoneFor(zone)->realloc(zone, ptr, size);
+    ADALLeaveAllocation();
+    return result;
+}
+
+static void *ADALCountingMemalign(malloc_zone_t *zone, size_t alignment, size_t size)
+{
+    ADALEnterAllocation(size);
+    void *result = ADALCountedZoneFor(zone)->memalign(zone, alignment, size);
+    ADALLeaveAllocation();
+    return result;
+}
+
+static void ADALInstallAllocationCounter(void)
+{
+    pthread_key_create(&s_depthKey, NULL);
+    
+    vm_address_t *addresses = NULL;
+    unsigned count = 0;
+    if (malloc_get_all_zones(mach_task_self(), NULL, &addresses, &count) != KERN_SUCCESS)
+    {
+        return;
+    }
+    
+    for (unsigned i = 0; i < count && s_zoneCount < ADAL_MAX_COUNTED_ZONES; i++)
+    {
+        malloc_zone_t *zone = (malloc_zone_t *)addresses[i];
+        
+        // The function table is read-only once the zone is registered
+        if (vm_protect(mach_task_self(), (vm_address_t)zone, sizeof(malloc_zone_t), 0, VM_PROT_READ | VM_PROT_WRITE) != KERN_SUCCESS)
+        {
+            continue;
+        }
+        
+        ADALCountedZone *counted = &s_zones[s_zoneCount];
+        counted->zone = zone;
+        counted->malloc = zone->malloc;
+        counted->calloc = zone->calloc;
+        counted->realloc = zone->realloc;
+        counted->memalign = zone->version >= 5 ? zone->memalign : NULL;
+        
+        // Publish the original table before any call can reach the counting functions
+        s_zoneCount++;
+        atomic_thread_fence(memory_order_seq_cst);
+        
+        zone->malloc = ADALCountingMalloc;
+        zone->calloc = ADALCountingCalloc;
+        zone->realloc = ADALCountingRealloc;
+        if (counted->memalign)
+        {
+            zone->memalign = ADALCountingMemalign;
+        }
+        
+        vm_protect(mach_task_self(), (vm_address_t)zone, sizeof(malloc_zone_t), 0, VM_PROT_READ);
+    }
+}
+
+@implementation ADALAllocationCounter
+
++ (void)install
+{
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        ADALInstallAllocationCounter();
+    });
+}
+
++ (uint64_t)allocationCount
+{
+    [self install];
+    return atomic_load_explicit(&s_allocations, memory_order_relaxed);
+}
+
++ (uint64_t)allocatedBytes
+{
+    [self install];
+    return atomic_load_explicit(&s_allocatedBytes, memory_order_relaxed);
+}
+
+@end
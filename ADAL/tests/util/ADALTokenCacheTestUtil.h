@@ -22,8 +22,10 @@
 // THE SOFTWARE.
 
 #import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
 
 #import "ADALTokenCache.h"
+#import "ADALTokenCacheDataSource.h"
 
 #if TARGET_OS_IPHONE
 #import "ADLegacyKeychainTokenCache.h"
@@ -51,3 +53,22 @@
 @interface ADLegacyKeychainTokenCache (TestUtil) <ADALTokenCacheTestUtil>
 @end
 #endif
+
+@interface XCTestCase (ADALTokenCachePopulation)
+
+/*!
+ Fills cache with a synthetic population. Every user gets, for each client, an MRRT and an access
+ token for each resource. The MRRT of every familyInterval-th client is a family one and users with
+ family clients also get an FRT, pass 0 for no family clients. Returns the number of items written.
+ */
+- (NSUInteger)adPopulateCache:(id<ADALTokenCacheDataSource>)cache
+                    userCount:(NSUInteger)userCount
+                resourceCount:(NSUInteger)resourceCount
+                  clientCount:(NSUInteger)clientCount
+               familyInterval:(NSUInteger)familyInterval;
+
+- (NSString *)adPopulationUserId:(NSUInteger)index;
+- (NSString *)adPopulationResource:(NSUInteger)index;
+- (NSString *)adPopulationClientId:(NSUInteger)index;
+
+@end
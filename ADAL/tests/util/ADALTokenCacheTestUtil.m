@@ -115,3 +115,67 @@ static ADALTokenCacheItem *getAT(id<ADALTokenCacheDataSource> tokenCache, NSStri
 
 @end
 #endif
+
+@implementation XCTestCase (ADALTokenCachePopulation)
+
+- (NSUInteger)adPopulateCache:(id<ADALTokenCacheDataSource>)cache
+                    userCount:(NSUInteger)userCount
+                resourceCount:(NSUInteger)resourceCount
+                  clientCount:(NSUInteger)clientCount
+               familyInterval:(NSUInteger)familyInterval
+{
+    NSUInteger written = 0;
+    
+    for (NSUInteger user = 0; user < userCount; user++)
+    {
+        NSString *userId = [self adPopulationUserId:user];
+        ADALUserInformation *userInfo = [self adCreateUserInformation:userId];
+        BOOL hasFamilyClient = NO;
+        
+        for (NSUInteger client = 0; client < clientCount; client++)
+        {
+            NSString *clientId = [self adPopulationClientId:client];
+            BOOL isFamilyClient = familyInterval && client % familyInterval == 0;
+            hasFamilyClient |= isFamilyClient;
+            
+            ADALTokenCacheItem *mrrt = [self adCreateMRRTCacheItem:userId familyId:isFamilyClient ? @"1" : nil];
+            mrrt.clientId = clientId;
+            mrrt.userInformation = userInfo;
+            written += [cache addOrUpdateItem:mrrt correlationId:nil error:nil];
+            
+            for (NSUInteger resource = 0; resource < resourceCount; resource++)
+            {
+                ADALTokenCacheItem *at = [self adCreateATCacheItem:[self adPopulationResource:resource] userId:nil];
+                at.clientId = clientId;
+                at.userInformation = userInfo;
+                written += [cache addOrUpdateItem:at correlationId:nil error:nil];
+            }
+        }
+        
+        if (hasFamilyClient)
+        {
+            ADALTokenCacheItem *frt = [self adCreateFRTCacheItem:@"1" userId:nil];
+            frt.userInformation = userInfo;
+            written += [cache addOrUpdateItem:frt correlationId:nil error:nil];
+        }
+    }
+    
+    return written;
+}
+
+- (NSString *)adPopulationUserId:(NSUInteger)index
+{
+    return [NSString stringWithFormat:@"user%lu@contoso.com", (unsigned long)index];
+}
+
+- (NSString *)adPopulationResource:(NSUInteger)index
+{
+    return [NSString stringWithFormat:@"https://resource%lu.contoso.com", (unsigned long)index];
+}
+
+- (NSString *)adPopulationClientId:(NSUInteger)index
+{
+    return [NSString stringWithFormat:@"client-%lu", (unsigned long)index];
+}
+
+@end